@@ -0,0 +1,36 @@
+#include "allocation_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<std::uint64_t> gAllocations{0};
+
+} // namespace
+
+namespace template_insight::bench {
+
+std::uint64_t allocationCount() {
+    return gAllocations.load(std::memory_order_relaxed);
+}
+
+} // namespace template_insight::bench
+
+// Array and nothrow forms forward to these, so they are counted as well.
+void* operator new(std::size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
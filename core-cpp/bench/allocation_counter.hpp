@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+namespace template_insight::bench {
+
+/// Number of global operator new calls so far in this process (all threads).
+///
+/// The benchmark binary replaces the global allocation functions to count
+/// calls; benchmarks report the difference per iteration.
+std::uint64_t allocationCount();
+
+} // namespace template_insight::bench
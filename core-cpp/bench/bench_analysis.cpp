@@ -0,0 +1,147 @@
+#include "allocation_counter.hpp"
+#include "analysis_cache.hpp"
+#include "api.hpp"
+#include "config.hpp"
+#include "corpus_generator.hpp"
+
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+
+#include <limits>
+#include <map>
+#include <tuple>
+
+using namespace template_insight;
+using namespace template_insight::bench;
+
+namespace {
+
+/// Corpus of the shape given by the benchmark arguments (MiB, error density
+/// in percent, backtrace depth), generated once per shape.
+const std::string& corpusFor(CorpusDialect dialect, const benchmark::State& state) {
+    static std::map<std::tuple<CorpusDialect, std::int64_t, std::int64_t, std::int64_t>, std::string> corpora;
+    const auto key = std::make_tuple(dialect, state.range(0), state.range(1), state.range(2));
+    auto it = corpora.find(key);
+    if (it == corpora.end()) {
+        CorpusOptions options;
+        options.dialect = dialect;
+        options.bytes = static_cast<std::size_t>(state.range(0)) << 20;
+        options.errorDensity = static_cast<double>(state.range(1)) / 100.0;
+        options.backtraceDepth = static_cast<std::size_t>(state.range(2));
+        it = corpora.emplace(key, generateCorpus(options)).first;
+    }
+    return it->second;
+}
+
+/// Single-threaded analysis that reports every issue.
+AppConfig benchConfig() {
+    AppConfig config;
+    config.analysis.workerThreads = 1;
+    config.analysis.timeoutMs = 0;
+    config.analysis.maxIssues = std::numeric_limits<std::size_t>::max();
+    return config;
+}
+
+/// Throughput (MB/s, issues/s) and allocations per iteration.
+void reportCounters(benchmark::State& state, std::size_t bytes, std::size_t issues, std::uint64_t allocations) {
+    const auto iterations = static_cast<double>(state.iterations());
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(bytes));
+    state.counters["issues"] = benchmark::Counter(static_cast<double>(issues) * iterations, benchmark::Counter::kIsRate);
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocations) / iterations);
+}
+
+void analyze(benchmark::State& state, CorpusDialect dialect) {
+    spdlog::set_level(spdlog::level::off);
+    const std::string& log = corpusFor(dialect, state);
+    const AnalysisOptions options;
+    const AppConfig config = benchConfig();
+    std::size_t issues = 0;
+    const std::uint64_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        const TemplateInsightResult result = analyzeDiagnostics(log, options, config);
+        issues = result.issues.size();
+        benchmark::DoNotOptimize(result);
+    }
+    reportCounters(state, log.size(), issues, allocationCount() - allocationsBefore);
+}
+
+void BM_AnalyzeClang(benchmark::State& state) {
+    analyze(state, CorpusDialect::Clang);
+}
+
+void BM_AnalyzeGcc(benchmark::State& state) {
+    analyze(state, CorpusDialect::Gcc);
+}
+
+void BM_SerializeToJson(benchmark::State& state) {
+    spdlog::set_level(spdlog::level::off);
+    const TemplateInsightResult result =
+        analyzeDiagnostics(corpusFor(CorpusDialect::Clang, state), AnalysisOptions{}, benchConfig());
+    std::size_t bytes = 0;
+    const std::uint64_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        const std::string json = serializeToJson(result);
+        bytes = json.size();
+        benchmark::DoNotOptimize(json.data());
+    }
+    reportCounters(state, bytes, result.issues.size(), allocationCount() - allocationsBefore);
+}
+
+/// Analysis of a log on 4 workers in 1 MiB chunks, as the CLI runs it.
+AppConfig parallelConfig() {
+    AppConfig config = benchConfig();
+    config.analysis.workerThreads = 4;
+    config.analysis.parallelChunkBytes = 1 << 20;
+    return config;
+}
+
+void BM_AnalyzeParallel(benchmark::State& state) {
+    spdlog::set_level(spdlog::level::off);
+    const std::string& log = corpusFor(CorpusDialect::Clang, state);
+    const AppConfig config = parallelConfig();
+    const auto catalog = IssueCatalog::load(config.analysis);
+    std::size_t issues = 0;
+    const std::uint64_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        const CompactResult result = analyzeDiagnosticsCompact(log, AnalysisOptions{}, config, catalog);
+        issues = result.issues().size();
+        benchmark::DoNotOptimize(result);
+    }
+    reportCounters(state, log.size(), issues, allocationCount() - allocationsBefore);
+}
+
+/// Same log and workers as BM_AnalyzeParallel, every run of blocks already cached.
+void BM_AnalyzeWarmCache(benchmark::State& state) {
+    spdlog::set_level(spdlog::level::off);
+    const std::string& log = corpusFor(CorpusDialect::Clang, state);
+    const AppConfig config = parallelConfig();
+    const auto catalog = IssueCatalog::load(config.analysis);
+    AnalysisCache cache(std::size_t{1} << 30);
+    analyzeDiagnosticsCompact(log, AnalysisOptions{}, config, catalog, {}, &cache);
+    std::size_t issues = 0;
+    const std::uint64_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        const CompactResult result = analyzeDiagnosticsCompact(log, AnalysisOptions{}, config, catalog, {}, &cache);
+        issues = result.issues().size();
+        benchmark::DoNotOptimize(result);
+    }
+    reportCounters(state, log.size(), issues, allocationCount() - allocationsBefore);
+}
+
+/// Arguments: log size in MiB, error density in percent, backtrace depth.
+void corpusShapes(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"MiB", "density", "depth"});
+    b->Args({16, 30, 4});
+    b->Args({16, 5, 4});
+    b->Args({16, 90, 4});
+    b->Args({16, 30, 16});
+    b->Unit(benchmark::kMillisecond);
+}
+
+} // namespace
+
+BENCHMARK(BM_AnalyzeClang)->Apply(corpusShapes);
+BENCHMARK(BM_AnalyzeGcc)->Apply(corpusShapes);
+BENCHMARK(BM_AnalyzeParallel)->ArgNames({"MiB", "density", "depth"})->Args({16, 30, 4})->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AnalyzeWarmCache)->ArgNames({"MiB", "density", "depth"})->Args({16, 30, 4})->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SerializeToJson)->ArgNames({"MiB", "density", "depth"})->Args({4, 30, 4})->Unit(benchmark::kMillisecond);
@@ -0,0 +1,129 @@
+#include "allocation_counter.hpp"
+#include "config.hpp"
+#include "issues.hpp"
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace template_insight;
+using namespace template_insight::bench;
+
+namespace {
+
+/// Benchmark input file, removed when the process exits.
+struct BenchFile {
+    std::string path;
+    explicit BenchFile(std::string p, const std::string& content) : path(std::move(p)) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+    }
+    ~BenchFile() { std::remove(path.c_str()); }
+};
+
+/// Code of the i-th synthetic issue kind.
+std::string syntheticCode(std::size_t i) {
+    return "CUSTOM_ISSUE_" + std::to_string(i);
+}
+
+/// issue_kinds.json with the built-in kinds and `extra` synthetic ones.
+std::string issueKindsJson(std::size_t extra) {
+    nlohmann::json kinds = nlohmann::json::array();
+    auto add = [&kinds](const IssueKind& kind) {
+        kinds.push_back({{"code", kind.code},
+                         {"category", kind.category},
+                         {"default_severity", severityToString(kind.defaultSeverity)},
+                         {"default_short_message", kind.defaultShortMessage},
+                         {"default_detailed_message", kind.defaultDetailedMessage},
+                         {"patterns", kind.patterns}});
+    };
+    for (const IssueKind& kind : builtinIssueKinds()) {
+        add(kind);
+    }
+    for (std::size_t i = 0; i < extra; ++i) {
+        add(IssueKind{syntheticCode(i), "Custom", Severity::Warning, "Custom issue.",
+                      "A project-specific diagnostic.", {"custom diagnostic " + std::to_string(i)}});
+    }
+    return nlohmann::json{{"issue_kinds", kinds}}.dump(2);
+}
+
+const BenchFile& issueKindsFile(std::size_t extra) {
+    static std::map<std::size_t, BenchFile> files;
+    auto it = files.find(extra);
+    if (it == files.end()) {
+        const std::string path = "bench_issue_kinds_" + std::to_string(extra) + ".json";
+        it = files.emplace(std::piecewise_construct, std::forward_as_tuple(extra),
+                           std::forward_as_tuple(path, issueKindsJson(extra))).first;
+    }
+    return it->second;
+}
+
+void reportAllocations(benchmark::State& state, std::uint64_t allocations) {
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocations) / static_cast<double>(state.iterations()));
+}
+
+void BM_IssueRegistryLoad(benchmark::State& state) {
+    const BenchFile& file = issueKindsFile(static_cast<std::size_t>(state.range(0)));
+    const std::uint64_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        IssueRegistry registry;
+        registry.loadFromJsonFile(file.path);
+        benchmark::DoNotOptimize(registry);
+    }
+    reportAllocations(state, allocationCount() - allocationsBefore);
+}
+
+void BM_IssueRegistryFind(benchmark::State& state) {
+    const auto extra = static_cast<std::size_t>(state.range(0));
+    IssueRegistry registry;
+    registry.loadFromJsonFile(issueKindsFile(extra).path);
+    std::vector<std::string> codes;
+    for (std::size_t i = 0; i < extra; i += 7) {
+        codes.push_back(syntheticCode(i));
+    }
+    codes.push_back("NO_MEMBER");
+    codes.push_back("UNKNOWN_CODE");
+
+    std::size_t next = 0;
+    const std::uint64_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(registry.find(codes[next]));
+        next = next + 1 == codes.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+    reportAllocations(state, allocationCount() - allocationsBefore);
+}
+
+void BM_LoadConfig(benchmark::State& state) {
+    spdlog::set_level(spdlog::level::off);
+    static const BenchFile file("bench_config.json", R"({
+  "analysis": {
+    "max_template_depth": 10,
+    "enable_optimizations": true,
+    "timeout_ms": 5000,
+    "enabled_issue_codes": ["NO_MEMBER", "NO_MATCHING_FUNCTION", "TYPE_MISMATCH"],
+    "deduplicate_issues": true,
+    "issue_kinds_file": "issue_kinds.json"
+  },
+  "output": { "format": "json", "verbose": false, "output_file": "analysis_result.json" },
+  "logger": { "level": "info", "file": "template_insight.log" }
+})");
+    const std::uint64_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(loadConfigFromJsonFile(file.path));
+    }
+    reportAllocations(state, allocationCount() - allocationsBefore);
+}
+
+} // namespace
+
+BENCHMARK(BM_IssueRegistryLoad)->Arg(0)->Arg(1000);
+BENCHMARK(BM_IssueRegistryFind)->Arg(1000);
+BENCHMARK(BM_LoadConfig);
@@ -0,0 +1,76 @@
+#include "api.hpp"
+#include "config.hpp"
+#include "corpus_generator.hpp"
+#include "dialect.hpp"
+
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+
+#include <limits>
+
+using namespace template_insight;
+using namespace template_insight::bench;
+
+namespace {
+
+/// 16 MiB corpus of the dialect, generated once.
+const std::string& corpusOf(CorpusDialect dialect) {
+    static const std::string corpora[] = {
+        [] {
+            CorpusOptions options;
+            options.bytes = 16 << 20;
+            return generateCorpus(options);
+        }(),
+        [] {
+            CorpusOptions options;
+            options.dialect = CorpusDialect::Gcc;
+            options.bytes = 16 << 20;
+            return generateCorpus(options);
+        }(),
+    };
+    return corpora[static_cast<int>(dialect)];
+}
+
+/// Context line test of `Policy` over every line of the corpus.
+template <class Policy>
+void BM_ClassifyContextLines(benchmark::State& state) {
+    const std::string_view corpus = corpusOf(static_cast<CorpusDialect>(state.range(0)));
+    for (auto _ : state) {
+        std::size_t context = 0;
+        for (std::size_t pos = 0; pos < corpus.size();) {
+            std::size_t nl = corpus.find('\n', pos);
+            nl = nl == std::string_view::npos ? corpus.size() : nl;
+            context += Policy::isContextLine(corpus.substr(pos, nl - pos)) ? 1 : 0;
+            pos = nl + 1;
+        }
+        benchmark::DoNotOptimize(context);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(corpus.size()));
+}
+
+/// Analysis of a clang (0) or gcc (1) corpus by the generic (0) or the
+/// dialect's own (1) parser.
+void BM_AnalyzeDialect(benchmark::State& state) {
+    spdlog::set_level(spdlog::level::off);
+    const auto dialect = static_cast<CorpusDialect>(state.range(0));
+    const std::string& corpus = corpusOf(dialect);
+    AnalysisOptions options;
+    options.compiler = state.range(1) == 0 ? "generic" : dialect == CorpusDialect::Clang ? "clang" : "gcc";
+    AppConfig config;
+    config.analysis.workerThreads = 1;
+    config.analysis.timeoutMs = 0;
+    config.analysis.maxIssues = std::numeric_limits<std::size_t>::max();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(analyzeDiagnostics(corpus, options, config));
+    }
+    state.SetLabel(options.compiler);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(corpus.size()));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_ClassifyContextLines, GenericDialect)->ArgName("gcc")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ClassifyContextLines, ClangDialect)->ArgName("gcc")->Arg(0);
+BENCHMARK_TEMPLATE(BM_ClassifyContextLines, GccDialect)->ArgName("gcc")->Arg(1);
+BENCHMARK(BM_AnalyzeDialect)->ArgNames({"gcc", "specialized"})->ArgsProduct({{0, 1}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,104 @@
+#include "api.hpp"
+#include "config.hpp"
+#include "mapped_file.hpp"
+
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+using namespace template_insight;
+
+namespace {
+
+const char* kLogPath = "bench_log_input.log";
+
+/// Write a synthetic log of roughly the requested size (once per process)
+/// and return its actual size.
+std::size_t ensureLogFile(std::size_t bytes) {
+    static std::size_t requested = 0;
+    static std::size_t written = 0;
+    if (requested == bytes) {
+        return written;
+    }
+    // Removes the log when the process exits.
+    static const struct Remover {
+        ~Remover() { std::remove(kLogPath); }
+    } remover;
+    std::ofstream out(kLogPath, std::ios::binary | std::ios::trunc);
+    const std::string block =
+        "[12/480] Building CXX object src/CMakeFiles/app.dir/main.cpp.o\n"
+        "src/main.cpp:10:5: error: no member named 'begin' in 'int'\n"
+        "    x.begin();\n"
+        "    ~ ^\n"
+        "src/main.cpp:42:9: warning: unused variable 'y' [-Wunused-variable]\n"
+        "    int y = 0;\n"
+        "        ^\n";
+    written = 0;
+    for (; written < bytes; written += block.size()) {
+        out << block;
+    }
+    requested = bytes;
+    return written;
+}
+
+/// Single-threaded analysis without time or issue limits, so every input path
+/// does the same, complete work.
+AppConfig benchConfig() {
+    AppConfig config;
+    config.analysis.workerThreads = 1;
+    config.analysis.timeoutMs = 0;
+    config.analysis.maxIssues = std::numeric_limits<std::size_t>::max();
+    return config;
+}
+
+/// Baseline: slurp the whole stream into a string, then analyze it.
+void BM_StdinSlurp(benchmark::State& state) {
+    spdlog::set_level(spdlog::level::off);
+    const std::size_t bytes = ensureLogFile(static_cast<std::size_t>(state.range(0)));
+    AnalysisOptions options;
+    const AppConfig config = benchConfig();
+    for (auto _ : state) {
+        std::ifstream in(kLogPath, std::ios::binary);
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        const std::string logText = buffer.str();
+        benchmark::DoNotOptimize(analyzeDiagnostics(logText, options, config));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(bytes));
+}
+
+/// Current stdin path: chunked reads fed to the streaming analyzer.
+void BM_StdinStream(benchmark::State& state) {
+    spdlog::set_level(spdlog::level::off);
+    const std::size_t bytes = ensureLogFile(static_cast<std::size_t>(state.range(0)));
+    AnalysisOptions options;
+    const AppConfig config = benchConfig();
+    for (auto _ : state) {
+        std::ifstream in(kLogPath, std::ios::binary);
+        benchmark::DoNotOptimize(analyzeDiagnosticsStream(in, options, config));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(bytes));
+}
+
+/// --log path: memory-mapped file scanned in place.
+void BM_MappedLog(benchmark::State& state) {
+    spdlog::set_level(spdlog::level::off);
+    const std::size_t bytes = ensureLogFile(static_cast<std::size_t>(state.range(0)));
+    AnalysisOptions options;
+    const AppConfig config = benchConfig();
+    for (auto _ : state) {
+        MappedFile log = MappedFile::open(kLogPath);
+        benchmark::DoNotOptimize(analyzeDiagnostics(log.view(), options, config));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(bytes));
+}
+
+} // namespace
+
+BENCHMARK(BM_StdinSlurp)->Arg(64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StdinStream)->Arg(64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MappedLog)->Arg(64 << 20)->Unit(benchmark::kMillisecond);
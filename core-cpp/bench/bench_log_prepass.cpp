@@ -0,0 +1,101 @@
+#include "api.hpp"
+#include "config.hpp"
+#include "corpus_generator.hpp"
+#include "log_prepass.hpp"
+
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+
+#include <limits>
+
+using namespace template_insight;
+using namespace template_insight::bench;
+
+namespace {
+
+/// 16 MiB clang corpus, generated once.
+const std::string& plainCorpus() {
+    static const std::string corpus = [] {
+        CorpusOptions options;
+        options.bytes = 16 << 20;
+        return generateCorpus(options);
+    }();
+    return corpus;
+}
+
+/// The same corpus as clang -fcolor-diagnostics prints it.
+const std::string& coloredCorpus() {
+    static const std::string corpus = [] {
+        const std::string& plain = plainCorpus();
+        std::string colored;
+        colored.reserve(plain.size() * 3 / 2);
+        std::size_t pos = 0;
+        while (pos < plain.size()) {
+            std::size_t nl = plain.find('\n', pos);
+            nl = nl == std::string::npos ? plain.size() : nl + 1;
+            const std::string_view line = std::string_view(plain).substr(pos, nl - pos);
+            const std::size_t error = line.find(": error: ");
+            if (error == std::string_view::npos) {
+                colored.append(line);
+            } else {
+                colored.append("\x1b[1m").append(line.substr(0, error + 2)).append("\x1b[0m\x1b[0;1;31merror: \x1b[0m\x1b[1m");
+                colored.append(line.substr(error + 9, line.size() - error - 10)).append("\x1b[0m\n");
+            }
+            pos = nl;
+        }
+        return colored;
+    }();
+    return corpus;
+}
+
+void BM_IndexLineEnds(benchmark::State& state) {
+    const auto kernel = static_cast<ScanKernel>(state.range(0));
+    if (static_cast<int>(kernel) > static_cast<int>(detectScanKernel())) {
+        state.SkipWithError("kernel not supported by this CPU");
+        return;
+    }
+    state.SetLabel(scanKernelName(kernel));
+    const std::string_view corpus = plainCorpus();
+    std::vector<std::uint32_t> ends;
+    for (auto _ : state) {
+        // Windows of the size the analyzer indexes at once.
+        for (std::size_t pos = 0; pos < corpus.size(); pos += 64 * 1024) {
+            ends.clear();
+            indexLineEnds(corpus.substr(pos, 64 * 1024), ends, kernel);
+            benchmark::DoNotOptimize(ends.data());
+        }
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(corpus.size()));
+}
+
+void BM_StripAnsiEscapes(benchmark::State& state) {
+    const std::string& corpus = coloredCorpus();
+    std::string out;
+    for (auto _ : state) {
+        AnsiStripper ansi;
+        ansi.strip(corpus, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(corpus.size()));
+}
+
+/// Analysis of plain (0) or colored (1) output of the same build.
+void BM_AnalyzeColored(benchmark::State& state) {
+    spdlog::set_level(spdlog::level::off);
+    const std::string& corpus = state.range(0) == 0 ? plainCorpus() : coloredCorpus();
+    AppConfig config;
+    config.analysis.workerThreads = 1;
+    config.analysis.timeoutMs = 0;
+    config.analysis.maxIssues = std::numeric_limits<std::size_t>::max();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(analyzeDiagnostics(corpus, AnalysisOptions{}, config));
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(corpus.size()));
+}
+
+} // namespace
+
+BENCHMARK(BM_IndexLineEnds)->Arg(static_cast<int>(ScanKernel::Scalar))->Arg(static_cast<int>(ScanKernel::Sse2))
+    ->Arg(static_cast<int>(ScanKernel::Avx2));
+BENCHMARK(BM_StripAnsiEscapes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AnalyzeColored)->ArgName("colored")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
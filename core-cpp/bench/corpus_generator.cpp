@@ -0,0 +1,229 @@
+#include "corpus_generator.hpp"
+
+#include <array>
+#include <string_view>
+
+namespace template_insight::bench {
+
+namespace {
+
+/// splitmix64: tiny, fast and, unlike the <random> distributions, produces the
+/// same sequence with every standard library.
+class Random {
+public:
+    explicit Random(std::uint64_t seed) : state_(seed) {}
+
+    std::uint64_t next() {
+        std::uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    std::size_t below(std::size_t n) { return static_cast<std::size_t>(next() % n); }
+
+    bool chance(double p) { return static_cast<double>(next() >> 11) * 0x1.0p-53 < p; }
+
+    template <typename T, std::size_t N>
+    const T& pick(const std::array<T, N>& items) {
+        return items[below(N)];
+    }
+
+private:
+    std::uint64_t state_;
+};
+
+constexpr std::array<std::string_view, 8> kFiles = {
+    "src/core/widget.cpp", "src/core/registry.cpp", "src/net/session.cpp", "src/net/codec.cpp",
+    "src/ui/layout.cpp",   "src/ui/theme.cpp",      "src/app/main.cpp",    "src/app/plugins.cpp",
+};
+
+constexpr std::array<std::string_view, 5> kHeaders = {
+    "include/util/algorithms.hpp", "include/util/containers.hpp", "include/core/traits.hpp",
+    "include/net/buffer.hpp",      "include/ui/model.hpp",
+};
+
+constexpr std::array<std::string_view, 6> kFunctions = {
+    "transform_all", "serialize", "visit_nodes", "make_index", "dispatch", "accumulate_by",
+};
+
+constexpr std::array<std::string_view, 6> kTypes = {
+    "int",
+    "Widget",
+    "std::vector<int, std::allocator<int>>",
+    "std::basic_string<char, std::char_traits<char>, std::allocator<char>>",
+    "std::map<int, Widget, std::less<int>, std::allocator<std::pair<const int, Widget>>>",
+    "std::unique_ptr<Session, std::default_delete<Session>>",
+};
+
+/// Error messages the analyzer classifies (one per built-in issue kind) and a
+/// few it does not.
+constexpr std::array<std::string_view, 8> kClangErrors = {
+    "no member named 'begin' in 'Widget'",
+    "no matching function for call to 'serialize'",
+    "no viable conversion from 'int' to 'std::string'",
+    "cannot initialize a variable of type 'Widget *' with an rvalue of type 'int'",
+    "constraints not satisfied for class template 'Range' [with T = Widget]",
+    "static assertion failed due to requirement 'std::is_integral_v<Widget>'",
+    "use of undeclared identifier 'registry_'",
+    "call to deleted constructor of 'Session'",
+};
+
+constexpr std::array<std::string_view, 8> kGccErrors = {
+    "'class Widget' has no member named 'begin'",
+    "no matching function for call to 'serialize(Widget&)'",
+    "cannot convert 'int' to 'std::string' {aka 'std::__cxx11::basic_string<char>'}",
+    "invalid conversion from 'int' to 'Widget*' [-fpermissive]",
+    "template constraint failure for 'template<class T>  requires  Sortable<T> struct Range'",
+    "static assertion failed: T must be integral",
+    "'registry_' was not declared in this scope",
+    "use of deleted function 'Session::Session(const Session&)'",
+};
+
+constexpr std::array<std::string_view, 3> kWarnings = {
+    "unused variable 'result' [-Wunused-variable]",
+    "comparison of integers of different signs: 'int' and 'std::size_t' [-Wsign-compare]",
+    "unused parameter 'context' [-Wunused-parameter]",
+};
+
+class CorpusWriter {
+public:
+    explicit CorpusWriter(const CorpusOptions& options) : options_(options), random_(options.seed) {}
+
+    std::string run() {
+        out_.reserve(options_.bytes + 4096);
+        const std::size_t steps = options_.bytes / 400 + 1;
+        for (std::size_t step = 1; out_.size() < options_.bytes; ++step) {
+            progress(step, steps);
+            if (random_.chance(options_.errorDensity)) {
+                if (random_.chance(0.2)) {
+                    warning();
+                } else if (options_.dialect == CorpusDialect::Clang) {
+                    clangError();
+                } else {
+                    gccError();
+                }
+            }
+        }
+        return std::move(out_);
+    }
+
+private:
+    void append(std::string_view s) { out_.append(s); }
+    void append(std::size_t n) { out_.append(std::to_string(n)); }
+
+    void location(std::string_view file) {
+        append(file);
+        append(":");
+        append(random_.below(900) + 1);
+        append(":");
+        append(random_.below(60) + 1);
+        append(":");
+    }
+
+    void progress(std::size_t step, std::size_t steps) {
+        const std::string_view file = random_.pick(kFiles);
+        append("[");
+        append(step);
+        append("/");
+        append(steps);
+        append("] Building CXX object CMakeFiles/app.dir/");
+        append(file);
+        append(".o\n");
+    }
+
+    void snippet() {
+        append("    auto it = ");
+        append(random_.pick(kFunctions));
+        append("(values, [&](const auto& v) { return v.begin(); });\n");
+        append("              ^~~~~~~~~~~~\n");
+    }
+
+    /// Type argument of the frame at `depth`, growing towards the outside.
+    void typeArgument(std::size_t depth) {
+        const std::size_t wrappers = depth % 3;
+        for (std::size_t i = 0; i < wrappers; ++i) {
+            append("std::vector<");
+        }
+        append(random_.pick(kTypes));
+        for (std::size_t i = 0; i < wrappers; ++i) {
+            append(">");
+        }
+    }
+
+    void warning() {
+        location(random_.pick(kFiles));
+        append(" warning: ");
+        append(random_.pick(kWarnings));
+        append("\n");
+        snippet();
+    }
+
+    void clangError() {
+        location(random_.pick(kHeaders));
+        append(" error: ");
+        append(random_.pick(kClangErrors));
+        append("\n");
+        snippet();
+        for (std::size_t depth = 0; depth < options_.backtraceDepth; ++depth) {
+            const bool outermost = depth + 1 == options_.backtraceDepth;
+            location(outermost ? random_.pick(kFiles) : random_.pick(kHeaders));
+            append(" note: in instantiation of function template specialization 'util::");
+            append(random_.pick(kFunctions));
+            append("<");
+            typeArgument(depth);
+            append(">' requested here\n");
+            snippet();
+        }
+        if (random_.chance(0.3)) {
+            location(random_.pick(kHeaders));
+            append(" note: candidate template ignored: substitution failure [with T = Widget]\n");
+        }
+        if (random_.chance(0.1)) {
+            append("1 error generated.\n");
+        }
+    }
+
+    void gccError() {
+        const std::string_view header = random_.pick(kHeaders);
+        append(header);
+        append(": In instantiation of 'void util::");
+        append(random_.pick(kFunctions));
+        append("(T&) [with T = ");
+        typeArgument(0);
+        append("]':\n");
+        for (std::size_t depth = 1; depth < options_.backtraceDepth; ++depth) {
+            const bool outermost = depth + 1 == options_.backtraceDepth;
+            location(outermost ? random_.pick(kFiles) : random_.pick(kHeaders));
+            append("   required from 'void util::");
+            append(random_.pick(kFunctions));
+            append("(T&) [with T = ");
+            typeArgument(depth);
+            append("]'\n");
+        }
+        if (options_.backtraceDepth > 0) {
+            location(random_.pick(kFiles));
+            append("   required from here\n");
+        }
+        location(header);
+        append(" error: ");
+        append(random_.pick(kGccErrors));
+        append("\n");
+        append("  412 |     ");
+        append(random_.pick(kFunctions));
+        append("(value);\n");
+        append("      |     ^~~~~~~~~\n");
+    }
+
+    const CorpusOptions& options_;
+    Random random_;
+    std::string out_;
+};
+
+} // namespace
+
+std::string generateCorpus(const CorpusOptions& options) {
+    return CorpusWriter(options).run();
+}
+
+} // namespace template_insight::bench
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace template_insight::bench {
+
+/// Compiler whose diagnostic style a synthetic corpus imitates.
+enum class CorpusDialect {
+    Clang,
+    Gcc,
+};
+
+/// Shape of a synthetic build log (see generateCorpus()).
+struct CorpusOptions {
+    CorpusDialect dialect = CorpusDialect::Clang;
+
+    /// Approximate size of the log; generation stops at the first build step
+    /// that reaches it.
+    std::size_t bytes = 1 << 20;
+
+    /// Fraction (0..1) of build steps that emit a diagnostic; the others only
+    /// print their progress line.
+    double errorDensity = 0.3;
+
+    /// Number of instantiation frames in each diagnostic's backtrace.
+    std::size_t backtraceDepth = 4;
+
+    /// Same seed, same log, on every platform.
+    std::uint64_t seed = 1;
+};
+
+/// Generate a build log with template errors in the style of the selected
+/// compiler: ninja progress lines, errors and warnings with source snippets,
+/// carets and instantiation backtraces of nested standard-library types.
+std::string generateCorpus(const CorpusOptions& options);
+
+} // namespace template_insight::bench
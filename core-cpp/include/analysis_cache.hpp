@@ -0,0 +1,96 @@
+#pragma once
+
+#include "analyzer.hpp"
+#include "compact_result.hpp"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace template_insight {
+
+/// Size-capped LRU cache of analysis results of runs of diagnostic blocks.
+///
+/// Keys combine content hashes of the lines of one run of blocks with the fingerprint
+/// of the analyzer that produced it (see DiagnosticsAnalyzer::fingerprint()),
+/// so a changed config or issue catalog never reuses stale results. Entries
+/// are kept as immutable CompactResults, so a hit is a lookup and a merge of
+/// the shared entry; the cap is measured in their approximate memory use.
+/// save() and load() persist them in the binary result encoding (see
+/// binary_format.hpp).
+///
+/// The cache is thread-safe.
+class AnalysisCache {
+public:
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    /// @param maxBytes Total size of the cached results; least recently used
+    ///                 entries are evicted beyond it.
+    explicit AnalysisCache(std::size_t maxBytes);
+
+    /// Cached result for `key`, marking it as most recently used.
+    std::shared_ptr<const CompactResult> find(std::uint64_t key);
+
+    /// Add or replace the result for `key`. Its statistics are not kept: a
+    /// hit costs none of the work they describe.
+    void insert(std::uint64_t key, CompactResult result);
+
+    /// Load entries saved by save(). A missing file leaves the cache empty.
+    /// @throws std::runtime_error if the file exists but is malformed or uses
+    ///         issue codes `catalog` does not know.
+    void load(const std::string& path, const std::shared_ptr<const IssueCatalog>& catalog);
+
+    /// Write all entries (most recently used first) to `path`.
+    /// @throws std::runtime_error if the file cannot be written.
+    void save(const std::string& path) const;
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        std::uint64_t key;
+        std::shared_ptr<const CompactResult> result;
+        std::size_t bytes;
+    };
+
+    void insertEntry(Entry entry);
+
+    std::size_t maxBytes_;
+    mutable std::mutex mutex_;
+    /// Most recently used first.
+    std::list<Entry> lru_;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index_;
+    Stats stats_;
+};
+
+/// Analyze one chunk of a log, reusing cached results for runs of blocks that
+/// were analyzed before with an equivalent analyzer.
+///
+/// The chunk is split at block boundaries (see
+/// DiagnosticsAnalyzer::nextBlockBoundary()) into runs of some ten to a few
+/// hundred KiB, keyed by the hashes of their lines. A run ends at the first
+/// block boundary after a line whose hash has its low bits clear, so runs
+/// are cut at the same places wherever the output of a build moves within
+/// the log, and only lines at the cut are classified. A colored chunk is
+/// hashed and analyzed without its escape sequences, so it shares entries
+/// with the same diagnostics printed plainly. Each run that misses the cache is analyzed by a copy of `prototype` and
+/// stored, unless its analysis was cut short by a timeout or cancellation.
+/// The merged result is identical to feeding the whole chunk to `prototype`.
+///
+/// analyzeInParallel() calls this for every chunk when given a cache.
+CompactResult analyzeWithCache(std::string_view chunk,
+                               const DiagnosticsAnalyzer& prototype,
+                               const AnalysisConfig& config,
+                               AnalysisCache& cache);
+
+} // namespace template_insight
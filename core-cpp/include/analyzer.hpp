@@ -0,0 +1,225 @@
+#pragma once
+
+#include "api.hpp"
+#include "compact_result.hpp"
+#include "diagnostic_line.hpp"
+#include "dialect.hpp"
+#include "instantiation.hpp"
+#include "issue_catalog.hpp"
+#include "log_prepass.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace template_insight {
+
+class AnalysisCache;
+struct StructuredDiagnostic;
+
+/// Push-style diagnostics analyzer.
+///
+/// Compiler output is fed in arbitrary chunks (a chunk may end in the middle of
+/// a line or of a diagnostic). ANSI escape sequences of colored output are
+/// removed first (see AnsiStripper); chunks without ESC bytes are used as
+/// they are. The analyzer then indexes the line ends of the input window by
+/// window (see indexLineEnds()) and groups the lines into diagnostic blocks:
+/// a header such as "file:line:col: error: ..." together with its notes and
+/// source snippets, plus any gcc-style "In instantiation of ..." prelude
+/// printed before it.
+///
+/// Lines are classified and backtraces parsed by code specialized for the
+/// compiler's dialect (see dialect.hpp), selected by AnalysisOptions::compiler.
+/// With "auto", the dialect is detected from the input fed so far, falling
+/// back to Generic once kDialectProbeBytes did not decide it; undecided
+/// input is parsed as Generic.
+///
+/// Only the block that is still open is buffered, so memory is bounded by the
+/// longest single diagnostic rather than by the size of the whole log.
+///
+/// Every block is scanned once by the PatternMatcher of an IssueCatalog, which
+/// holds the patterns of all enabled issue kinds, and
+/// yields one issue, located at the block's header line. Issues are kept as
+/// CompactIssue records until the result is requested. Template
+/// instantiation backtraces are parsed into a prefix tree shared by all issues
+/// (see InstantiationFrame), limited by AnalysisConfig::maxTemplateDepth.
+///
+/// Scanning stops early, with TemplateInsightResult::truncation set, as soon as
+/// an issue beyond AnalysisConfig::maxIssues is found, when the analyzer has
+/// spent AnalysisConfig::timeoutMs analyzing (time between calls, such as
+/// waiting for the next chunk, does not count), or when the cancellation
+/// flag is raised. Further input is then ignored.
+///
+/// Typical usage:
+///   DiagnosticsAnalyzer analyzer(options, config);
+///   while (readChunk(buf)) analyzer.feed(buf);
+///   TemplateInsightResult result = analyzer.finish();
+class DiagnosticsAnalyzer {
+public:
+    /// Compiles an IssueCatalog for config.analysis (see IssueCatalog::load()).
+    DiagnosticsAnalyzer(const AnalysisOptions& options, const AppConfig& config);
+
+    /// Uses an already compiled catalog, e.g. one shared by many analyses.
+    /// The catalog's enabled codes take precedence over
+    /// AnalysisConfig::enabledIssueCodes.
+    DiagnosticsAnalyzer(const AnalysisOptions& options,
+                        const AppConfig& config,
+                        std::shared_ptr<const IssueCatalog> catalog);
+
+    /// Feed the next chunk of compiler output.
+    void feed(std::string_view chunk);
+
+    /// Analyze one diagnostic of structured compiler output (see
+    /// structured_input.hpp) instead of text. Notes and remarks on their own
+    /// are ignored; they belong to the preceding diagnostic.
+    void addDiagnostic(const StructuredDiagnostic& diagnostic);
+
+    /// Analyze the open diagnostic now instead of when the next line shows
+    /// that it is complete. Meant for input that pauses, such as a log that
+    /// is still being written (see followLog()); a note that arrives after
+    /// the flush is analyzed as a diagnostic of its own. An unterminated last
+    /// line stays buffered.
+    void flushOpenBlock();
+
+    /// End the input fed so far as finish() would, but keep analyzing: its
+    /// unterminated last line and open diagnostic are analyzed now, and the
+    /// next chunk starts unrelated input. Meant for a followed log that was
+    /// truncated or replaced (see followLog()); frame ids and the issue
+    /// count carry on.
+    void restartInput();
+
+    /// Dialect the input is parsed as; std::nullopt until detected.
+    std::optional<Dialect> dialect() const { return dialect_; }
+
+    /// Detect the dialect from `input` (following what was detected from so
+    /// far) unless it is already known. feed() does this with every chunk;
+    /// call it first to judge by more of the input at once. Escape sequences
+    /// in `input` are ignored.
+    void resolveDialect(std::string_view input);
+
+    /// True once the analyzer stopped early; feeding more input is pointless.
+    bool stopped() const { return stopReason_ != TruncationReason::None; }
+
+    /// Cooperative cancellation: the analyzer polls `flag` while scanning and
+    /// stops with TruncationReason::Cancelled once it becomes true.
+    /// The flag must outlive the analyzer (or be reset to nullptr).
+    void setCancellationFlag(const std::atomic<bool>* flag) { cancelFlag_ = flag; }
+
+    /// Count `elapsed` against AnalysisConfig::timeoutMs as if this analyzer
+    /// had spent it analyzing, e.g. when it continues the work of others.
+    void chargeTime(std::chrono::steady_clock::duration elapsed);
+
+    /// Pass issues to `sink` as soon as they are found instead of collecting
+    /// them in the result of finish() (see IssueSink).
+    void setIssueSink(IssueSink sink);
+
+    /// Same, passing the issues in compact form (no strings are copied).
+    void setCompactIssueSink(CompactIssueSink sink) { issueSink_ = std::move(sink); }
+
+    const std::shared_ptr<const IssueCatalog>& catalog() const { return catalog_; }
+
+    /// Hash of the catalog and of the options and config that affect the
+    /// result; analyzers with equal fingerprints produce equal results.
+    std::uint64_t fingerprint() const;
+
+    /// Flush the last open diagnostic and return the filtered result.
+    /// The analyzer must not be fed again after this call.
+    TemplateInsightResult finish();
+
+    /// Same as finish(), returning the result without materializing the issues.
+    CompactResult finishCompact();
+
+    /// Offset of the first line start at or after `from` where a new diagnostic
+    /// block begins regardless of what precedes it, or text.size() if there is
+    /// none. Analyzing text before and after such a boundary separately yields
+    /// the same issues as analyzing the text as a whole. Colored text needs
+    /// no stripping first: lines are judged without their escape sequences.
+    static std::size_t nextBlockBoundary(std::string_view text, std::size_t from);
+
+private:
+    enum class LineKind {
+        Header,       ///< "...: error: ..." / "...: warning: ..." line starting a diagnostic.
+        Context,      ///< gcc/clang prelude ("In file included from", "In instantiation of", ...).
+        Continuation, ///< Notes, source snippets, carets, empty lines.
+        Other         ///< Anything else (build system noise, summaries).
+    };
+
+    class BusyScope;
+
+    template <class Policy>
+    static LineKind classifyLine(std::string_view line);
+
+    bool checkStop();
+    template <class Policy>
+    void splitLines(std::string_view chunk, std::size_t pos);
+    template <class Policy>
+    void onLine(std::string_view line, bool inChunk);
+    void onPartialLine();
+    void openBlock(std::string_view line, bool inChunk);
+    void extendBlock(std::string_view line, bool inChunk);
+    void closeBlock();
+    void analyzeBlock(std::string_view block);
+    bool admitIssue();
+    CompactIssue makeIssue(IssueKindId kindId) const;
+    void setInstantiation(CompactIssue& issue, std::size_t skippedFrames);
+    void emitIssue(const CompactIssue& issue);
+
+    AnalysisOptions options_;
+    AppConfig config_;
+    std::shared_ptr<const IssueCatalog> catalog_;
+    std::optional<Dialect> dialect_;
+    /// Input seen while the dialect is undecided.
+    std::string dialectProbe_;
+
+    /// Open block that is stored in (or was copied into) our own buffer.
+    std::string carry_;
+    /// Open block that still lives in the chunk currently being fed.
+    const char* openBegin_ = nullptr;
+    const char* openEnd_ = nullptr;
+    /// Unterminated last line of the previous chunk.
+    std::string partialLine_;
+    /// Colored input is analyzed from this copy without escape sequences.
+    AnsiStripper ansi_;
+    std::string clean_;
+    /// Line ends of the window of the chunk being split into lines.
+    std::vector<std::uint32_t> lineEnds_;
+
+    LineKind prevKind_ = LineKind::Other;
+    std::size_t bytesFed_ = 0;
+
+    CompactResult compact_;
+    CompactIssueSink issueSink_;
+    std::size_t issueCount_ = 0;
+    InstantiationTreeBuilder instantiations_;
+    std::vector<BacktraceFrame> frameScratch_;
+    /// Abbreviated descriptions the frames in frameScratch_ point to.
+    std::vector<std::string> descriptionScratch_;
+    std::size_t matchCount_ = 0;
+    AnalysisStats stats_;
+
+    /// Analysis time left of AnalysisConfig::timeoutMs, if limited, and the
+    /// start of the call that is spending it.
+    std::optional<std::chrono::steady_clock::duration> timeLeft_;
+    std::chrono::steady_clock::time_point busySince_;
+    const std::atomic<bool>* cancelFlag_ = nullptr;
+    std::size_t linesUntilCheck_ = 0;
+    TruncationReason stopReason_ = TruncationReason::None;
+};
+
+/// Analyze an in-memory log on several threads.
+///
+/// The log is split at block boundaries (see nextBlockBoundary()) into chunks
+/// of roughly `chunkBytes`, each chunk is analyzed by a copy of `prototype`
+/// on a pool of `workers` threads, and the results are merged in input order.
+/// The result is identical to feeding the whole log to `prototype`; with
+/// "auto", the dialect is detected once from the start of the log. With a
+/// `cache`, each chunk is analyzed through it (see analyzeWithCache()).
+CompactResult analyzeInParallel(std::string_view logText,
+                                const DiagnosticsAnalyzer& prototype,
+                                const AnalysisConfig& config,
+                                unsigned workers,
+                                AnalysisCache* cache = nullptr);
+
+} // namespace template_insight
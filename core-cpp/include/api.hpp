@@ -1,31 +1,111 @@
 #pragma once
 
 #include "model.hpp"
+#include "compact_result.hpp"
 #include "config.hpp"
 
+#include <functional>
+#include <iosfwd>
+#include <memory>
 #include <string>
+#include <string_view>
 
 namespace template_insight {
 
+class AnalysisCache;
+class IssueCatalog;
+
 /// Options for the analysis step (non-config, runtime options).
 struct AnalysisOptions {
-    /// Compiler family name, e.g. "clang", "gcc".
-    /// For now this is mostly informational.
-    std::string compiler = "clang";
+    /// Compiler family name: "clang" or "gcc" parse text output with rules
+    /// specialized for that compiler (see dialect.hpp), "auto" detects the
+    /// dialect from the first kilobytes of the log, and any other name uses
+    /// rules that accept both (as for logs of mixed builds).
+    /// "sarif" and "gcc-json" select structured input (see structured_input.hpp);
+    /// otherwise SARIF and gcc JSON are recognized automatically.
+    std::string compiler = "auto";
 };
 
+/// Receives issues as soon as they are found, together with the instantiation
+/// frames recorded so far (frame ids are stable; new frames are appended).
+/// Issues passed to a sink are not kept in the returned TemplateInsightResult,
+/// which then only carries the instantiation frames and the truncation state.
+using IssueSink = std::function<void(const TemplateIssue& issue,
+                                     const std::vector<InstantiationFrame>& frames)>;
+
 /// Analyze raw compiler diagnostics (build log) and extract template-related issues.
 ///
-/// @param logText Full text of the compiler output.
+/// Large logs are split at diagnostic boundaries and analyzed on
+/// AnalysisConfig::workerThreads threads; the result is identical to a
+/// sequential analysis. With AnalysisConfig::demultiplexBuildOutput, the log
+/// is instead split into the output of its build jobs (see BuildOutputAnalyzer).
+/// gzip and zstd logs are recognized by their magic bytes and analyzed like
+/// analyzeDiagnosticsStream() does (see compressed_input.hpp).
+///
+/// @param logText Full text of the compiler output. It is scanned in place, so a
+///                memory-mapped log (see MappedFile) is analyzed without copying.
 /// @param options Runtime analysis options (e.g. compiler kind).
 /// @param config Application configuration (logging + future tuning).
 TemplateInsightResult analyzeDiagnostics(
-    const std::string& logText,
+    std::string_view logText,
     const AnalysisOptions& options,
     const AppConfig& config
 );
 
+/// Same as above, with an issue catalog compiled once by the caller (see
+/// IssueCatalog::load()) instead of on every call, an optional sink that
+/// receives issues as they are found, and an optional cache of the results of
+/// runs of blocks (see analyzeWithCache()). Logs analyzed in parallel, through the
+/// cache or per build job pass their issues to the sink once all parts are merged.
+TemplateInsightResult analyzeDiagnostics(
+    std::string_view logText,
+    const AnalysisOptions& options,
+    const AppConfig& config,
+    std::shared_ptr<const IssueCatalog> catalog,
+    const IssueSink& sink = {},
+    AnalysisCache* cache = nullptr
+);
+
+/// Same as above, returning the result without materializing its issues (see
+/// CompactResult); `sink` receives issues in compact form. Meant for callers
+/// that only write the result, such as the CLI and AnalysisServer.
+CompactResult analyzeDiagnosticsCompact(
+    std::string_view logText,
+    const AnalysisOptions& options,
+    const AppConfig& config,
+    std::shared_ptr<const IssueCatalog> catalog,
+    const CompactIssueSink& sink = {},
+    AnalysisCache* cache = nullptr
+);
+
+/// Analyze compiler diagnostics read incrementally from a stream.
+///
+/// The input is consumed in fixed-size chunks and fed to a DiagnosticsAnalyzer
+/// (see analyzer.hpp), so the log is never held in memory as a whole.
+/// Produces the same result as analyzeDiagnostics() on the same text.
+/// gzip and zstd streams are decompressed on a background thread.
+/// @throws std::runtime_error if the stream is compressed with a format this
+///         build cannot read, or is corrupt.
+/// If `sink` is set, issues are passed to it while the stream is read (at the
+/// end with AnalysisConfig::demultiplexBuildOutput).
+TemplateInsightResult analyzeDiagnosticsStream(
+    std::istream& in,
+    const AnalysisOptions& options,
+    const AppConfig& config,
+    const IssueSink& sink = {}
+);
+
+/// Same as above, in compact form (see analyzeDiagnosticsCompact()).
+CompactResult analyzeDiagnosticsStreamCompact(
+    std::istream& in,
+    const AnalysisOptions& options,
+    const AppConfig& config,
+    const CompactIssueSink& sink = {}
+);
+
 /// Serialize analysis result to a minimal JSON string.
+/// To write large results without building the string, use ResultJsonWriter
+/// (see json_writer.hpp).
 std::string serializeToJson(const TemplateInsightResult& result);
 
 } // namespace template_insight
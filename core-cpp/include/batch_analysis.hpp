@@ -0,0 +1,91 @@
+#pragma once
+
+#include "api.hpp"
+#include "config.hpp"
+#include "model.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace template_insight {
+
+class IssueCatalog;
+
+/// One entry of a compilation database (compile_commands.json).
+struct CompileCommand {
+    /// Working directory of the compilation.
+    std::string directory;
+
+    /// Source file, made absolute against `directory`.
+    std::string file;
+
+    /// Compiler invocation; arguments[0] is the compiler.
+    std::vector<std::string> arguments;
+};
+
+/// Load a compilation database. Entries may give either "arguments" or a
+/// shell-quoted "command"; entries without a file or a command are skipped.
+/// @throws std::runtime_error if the file cannot be read or is not a JSON array.
+std::vector<CompileCommand> loadCompileCommands(const std::string& path);
+
+/// Split a shell-quoted command line ('single', "double" and \ escapes).
+std::vector<std::string> splitCommandLine(std::string_view command);
+
+/// Arguments of a syntax-only compile of `command`: output and dependency-file
+/// options are dropped, -fsyntax-only is appended and the compiler is replaced
+/// by AnalysisConfig::batchCompiler if that is set.
+std::vector<std::string> syntaxOnlyArguments(const CompileCommand& command, const AnalysisConfig& config);
+
+/// Compile durations of previous batch runs, per source file. Used to start
+/// the slowest translation units first.
+class CompileTimings {
+public:
+    /// Load timings saved by save(). A missing file leaves the timings empty.
+    /// @throws std::runtime_error if the file exists but is malformed.
+    void load(const std::string& path);
+
+    /// @throws std::runtime_error if the file cannot be written.
+    void save(const std::string& path) const;
+
+    std::optional<std::uint64_t> find(const std::string& file) const;
+    void record(const std::string& file, std::uint64_t milliseconds) { millis_[file] = milliseconds; }
+
+private:
+    std::unordered_map<std::string, std::uint64_t> millis_;
+};
+
+/// Run `task(i)` for every index in `order` on `workers` threads.
+///
+/// Indices are dealt round-robin, in order, to per-worker deques. A worker
+/// takes tasks from the front of its own deque and, once that is empty, steals
+/// from the back of the others', so long tasks placed first start early and
+/// idle workers pick up whatever is left. The first exception thrown by a task
+/// is rethrown after all workers have stopped; remaining tasks are dropped.
+void runWorkStealing(const std::vector<std::size_t>& order, unsigned workers,
+                     const std::function<void(std::size_t)>& task);
+
+/// Compile every translation unit of `commands` syntax-only and analyze its
+/// diagnostics.
+///
+/// Compilers run on AnalysisConfig::workerThreads threads (see
+/// runWorkStealing()), translation units without a recorded duration first,
+/// then the slowest of the previous run first. Each compiler's output is fed
+/// to its own DiagnosticsAnalyzer while the compiler runs; AnalysisConfig::timeoutMs
+/// is not applied, since the analyzer mostly waits for the compiler. Results
+/// are merged in the order of `commands`, with TemplateIssue::translationUnit
+/// set, and the measured durations are recorded in `timings`. Compilers are
+/// started with fork()/exec(); where those are not available, every
+/// translation unit is reported as failed.
+TemplateInsightResult analyzeCompileCommands(const std::vector<CompileCommand>& commands,
+                                             const AnalysisOptions& options,
+                                             const AppConfig& config,
+                                             std::shared_ptr<const IssueCatalog> catalog,
+                                             CompileTimings& timings);
+
+} // namespace template_insight
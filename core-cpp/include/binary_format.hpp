@@ -0,0 +1,44 @@
+#pragma once
+
+#include "model.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace template_insight {
+
+/// Format version written by encodeBinaryResult().
+constexpr std::uint8_t kBinaryFormatVersion = 3;
+
+/// Encode `result` in the compact binary format of the IDE protocol.
+///
+/// Every string (codes, categories, messages, file paths, frame descriptions)
+/// is stored once in a string table and referenced by index; all integers are
+/// unsigned LEB128 varints. Layout (version 3):
+///
+///   magic       "TIB" version:u8
+///   strings     count:varint { length:varint bytes }*
+///   issues      count:varint { code:str category:str severity:u8
+///                              shortMessage:str detailedMessage:str flags:u8
+///                              [location] [instantiation:varint] omittedFrames:varint
+///                              [translationUnit:str]
+///                              [occurrences:varint count:varint { unit:str }*] }*
+///   frames      count:varint { description:str flags:u8 [parent:varint] [location] }*
+///   truncation  u8 (TruncationReason)
+///
+///   str      := varint index into the string table
+///   location := file:str line:varint column:varint
+///   flags    := bit 0 location present, bit 1 instantiation/parent present,
+///               bit 2 translation unit present (issues only; added in version 2),
+///               bit 3 duplicates present (issues only; added in version 3)
+///
+/// A payload is typically several times smaller than the JSON document and is
+/// decoded without any parsing of text.
+std::string encodeBinaryResult(const TemplateInsightResult& result);
+
+/// Decode a result produced by encodeBinaryResult() of this or an earlier version.
+/// @throws std::runtime_error on a bad magic, an unsupported version or malformed data.
+TemplateInsightResult decodeBinaryResult(std::string_view data);
+
+} // namespace template_insight
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "api.hpp"
+#include "log_prepass.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace template_insight {
+
+class IssueCatalog;
+
+/// Splits the output of a (parallel) build into the output of its jobs.
+///
+/// Recognized framing:
+///  - ninja status lines ("[12/500] Building CXX object CMakeFiles/app.dir/src/a.cpp.o").
+///    ninja prints a job's output in one piece right after its status line,
+///    including "FAILED: <outputs>" and the failed command line;
+///  - progress lines of CMake's Makefiles ("[ 42%] Building CXX object ...",
+///    "[ 50%] Built target app") and make's "*** [target] Error 1" lines. Under
+///    make -j the output of concurrent jobs interleaves line by line;
+///  - compiler invocations echoed by plain Makefiles ("g++ -c src/a.cpp ...").
+///
+/// Without ninja framing, lines are attributed to a job by their source path
+/// ("a.cpp:3:5: error: ...", "In file included from a.cpp:1:", "a.cpp: In
+/// function ...") if it names a running job's translation unit, and otherwise
+/// to the job of the previous line, which keeps notes and source snippets
+/// with their diagnostic. Output before the first job goes to job 0, which
+/// has no translation unit; messages of the build tool itself are dropped.
+///
+/// ANSI escape sequences are removed from the output (see AnsiStripper), so
+/// jobs receive plain text. Only an unterminated last line is buffered. make never reports that a job
+/// succeeded, so at most kMaxOpenJobs jobs stay open; the oldest one is ended
+/// when another one starts.
+class BuildOutputDemuxer {
+public:
+    /// Receives one complete line (with its newline) of a job's output.
+    using OutputHandler = std::function<void(std::size_t job, std::string_view line)>;
+    /// Called once per job after its last line; all jobs end by finish().
+    using EndHandler = std::function<void(std::size_t job)>;
+
+    static constexpr std::size_t kMaxOpenJobs = 256;
+
+    BuildOutputDemuxer(OutputHandler onOutput, EndHandler onEnd);
+
+    /// Feed the next chunk of build output.
+    void feed(std::string_view chunk);
+
+    /// Flush the unterminated last line and end all open jobs.
+    void finish();
+
+    /// Number of jobs seen so far, including job 0.
+    std::size_t jobCount() const { return jobs_.size(); }
+
+    /// Source file compiled by `job` as far as the framing tells (e.g.
+    /// "src/a.cpp"); empty if unknown.
+    const std::string& translationUnit(std::size_t job) const { return jobs_[job].translationUnit; }
+
+    /// ANSI escape sequences removed so far.
+    std::size_t escapeSequences() const { return ansi_.sequences(); }
+
+private:
+    struct Job {
+        std::string translationUnit;
+        /// Output file named by the framing, matched against make's error lines.
+        std::string object;
+        /// CMake target the object belongs to, matched against "Built target".
+        std::string target;
+        bool open = true;
+    };
+
+    void onLine(std::string_view line);
+    std::size_t startJob(std::string_view object);
+    void endJob(std::size_t job);
+    std::size_t jobForPath(std::string_view path) const;
+
+    OutputHandler onOutput_;
+    EndHandler onEnd_;
+    std::vector<Job> jobs_;
+    /// Open jobs other than job 0, oldest first.
+    std::deque<std::size_t> openJobs_;
+    std::size_t current_ = 0;
+    /// Set once a ninja status line was seen: output is then never interleaved.
+    bool ninja_ = false;
+    /// The previous line was ninja's "FAILED:"; the command line follows.
+    bool expectCommand_ = false;
+    std::string partialLine_;
+    AnsiStripper ansi_;
+    std::string clean_;
+};
+
+/// Analyzes the output of a parallel build job by job (see BuildOutputDemuxer).
+///
+/// Every job gets its own DiagnosticsAnalyzer, so notes stay with their
+/// diagnostic even when make -j interleaves the output of several compilers.
+/// Jobs are analyzed on `workers` threads while the log is still being fed;
+/// at most kMaxPendingBytes of a job's output wait for its analyzer (feed()
+/// blocks until it catches up). The result lists the issues of all jobs in
+/// the order the jobs started, with TemplateIssue::translationUnit set.
+class BuildOutputAnalyzer {
+public:
+    /// Output of a job handed to its analyzer at once.
+    static constexpr std::size_t kBatchBytes = 64 * 1024;
+    static constexpr std::size_t kMaxPendingBytes = 4 * kBatchBytes;
+
+    /// @param workers Analysis threads; 0 or 1 analyzes on the feeding thread.
+    BuildOutputAnalyzer(const AnalysisOptions& options,
+                        const AppConfig& config,
+                        std::shared_ptr<const IssueCatalog> catalog,
+                        unsigned workers);
+    ~BuildOutputAnalyzer();
+
+    BuildOutputAnalyzer(const BuildOutputAnalyzer&) = delete;
+    BuildOutputAnalyzer& operator=(const BuildOutputAnalyzer&) = delete;
+
+    /// Feed the next chunk of build output.
+    void feed(std::string_view chunk);
+
+    /// Analyze the remaining output and return the merged result.
+    /// @throws whatever a job's analysis threw.
+    TemplateInsightResult finish();
+
+    /// Same as finish(), returning the result without materializing the issues.
+    CompactResult finishCompact();
+
+private:
+    struct Job;
+
+    void addOutput(std::size_t job, std::string_view line);
+    void endJob(std::size_t job);
+    Job& job(std::size_t index);
+    void schedule(std::size_t index, std::unique_lock<std::mutex>& lock);
+    void drain(std::size_t index, std::unique_lock<std::mutex>& lock);
+    void workerLoop();
+    void stopWorkers();
+
+    AnalysisOptions options_;
+    AppConfig config_;
+    std::shared_ptr<const IssueCatalog> catalog_;
+    BuildOutputDemuxer demuxer_;
+
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable jobDrained_;
+    std::vector<std::unique_ptr<Job>> jobs_;
+    std::deque<std::size_t> queue_;
+    /// Jobs whose result is not ready yet.
+    std::size_t unfinished_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr failure_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace template_insight
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "issue_catalog.hpp"
+#include "model.hpp"
+#include "string_interner.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace template_insight {
+
+/// Issue of a CompactResult: a fixed-size record without owned strings.
+struct CompactIssue {
+    static constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+
+    /// Kind in the result's IssueCatalog; code, category and messages are the kind's.
+    IssueKindId kind = 0;
+    Severity severity = Severity::Error;
+    /// Interned file (see CompactResult::internFile()), or kNone without location.
+    StringInterner::Id file = kNone;
+    int line = 0;
+    int column = 0;
+    /// Innermost frame in CompactResult::instantiations(), or kNone.
+    std::uint32_t instantiation = kNone;
+    std::uint32_t omittedFrames = 0;
+    /// Interned translation unit (see CompactResult::setTranslationUnit()), or kNone.
+    StringInterner::Id translationUnit = kNone;
+};
+
+class CompactResult;
+
+/// IssueSink for issues in compact form: `result` resolves the issue's
+/// strings (see CompactResult::code() etc.) while the sink runs.
+using CompactIssueSink = std::function<void(const CompactResult& result,
+                                            const CompactIssue& issue,
+                                            const std::vector<InstantiationFrame>& frames)>;
+
+/// Memory-lean form of a TemplateInsightResult.
+///
+/// Issues are CompactIssue records: codes and categories are IssueKindIds,
+/// messages are views of the (shared, immutable) IssueCatalog, and file paths
+/// are interned once into an arena. Adding an issue allocates nothing beyond
+/// the amortized growth of one vector, so a run that finds a million issues
+/// does not make millions of string copies.
+///
+/// DiagnosticsAnalyzer collects its issues in this form, ResultMerger merges
+/// it and ResultJsonWriter writes it; toResult() builds the public
+/// TemplateInsightResult only where the API returns one.
+class CompactResult {
+public:
+    explicit CompactResult(std::shared_ptr<const IssueCatalog> catalog);
+
+    /// Result holding the issues of `result`, whose codes must all be in
+    /// `catalog`. Messages are the catalog's (as the analyzer emits them).
+    /// @throws std::runtime_error for an issue code the catalog does not know.
+    static CompactResult fromResult(TemplateInsightResult&& result, std::shared_ptr<const IssueCatalog> catalog);
+
+    void add(const CompactIssue& issue) { issues_.push_back(issue); }
+
+    /// Intern a file path for CompactIssue::file or CompactIssue::translationUnit.
+    StringInterner::Id internFile(std::string_view file) { return files_.intern(file); }
+    /// Path interned as `id`.
+    std::string_view interned(StringInterner::Id id) const { return files_.str(id); }
+    /// Number of interned paths; their ids are 0 .. internedCount() - 1.
+    std::size_t internedCount() const { return files_.size(); }
+
+    /// Attribute all issues to the translation unit `file`.
+    void setTranslationUnit(std::string_view file);
+
+    const std::vector<CompactIssue>& issues() const { return issues_; }
+
+    /// Drop the issues, e.g. once they were passed to a sink.
+    void clearIssues() { issues_.clear(); }
+
+    const std::shared_ptr<const IssueCatalog>& catalog() const { return catalog_; }
+
+    std::string_view code(const CompactIssue& issue) const { return catalog_->kind(issue.kind).code; }
+    std::string_view category(const CompactIssue& issue) const { return catalog_->kind(issue.kind).category; }
+    std::string_view shortMessage(const CompactIssue& issue) const {
+        return catalog_->kind(issue.kind).defaultShortMessage;
+    }
+    std::string_view detailedMessage(const CompactIssue& issue) const {
+        return catalog_->kind(issue.kind).defaultDetailedMessage;
+    }
+    /// File of the issue's location, or an empty view without location.
+    std::string_view file(const CompactIssue& issue) const {
+        return issue.file == CompactIssue::kNone ? std::string_view{} : interned(issue.file);
+    }
+    /// Translation unit of the issue, or an empty view if not known.
+    std::string_view translationUnit(const CompactIssue& issue) const {
+        return issue.translationUnit == CompactIssue::kNone ? std::string_view{} : interned(issue.translationUnit);
+    }
+
+    /// Instantiation frames shared by all issues (see InstantiationFrame).
+    std::vector<InstantiationFrame>& instantiations() { return instantiations_; }
+    const std::vector<InstantiationFrame>& instantiations() const { return instantiations_; }
+
+    TruncationReason truncation = TruncationReason::None;
+    AnalysisStats stats;
+
+    /// Issue in the public representation (copies its strings).
+    TemplateIssue toIssue(const CompactIssue& issue) const;
+
+    /// Public representation of the whole result; the frames are moved out.
+    TemplateInsightResult toResult() &&;
+    /// Same, leaving this result as it is.
+    TemplateInsightResult toResult() const&;
+
+private:
+    std::shared_ptr<const IssueCatalog> catalog_;
+    std::vector<CompactIssue> issues_;
+    StringInterner files_;
+    std::vector<InstantiationFrame> instantiations_;
+};
+
+} // namespace template_insight
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <streambuf>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace template_insight {
+
+/// Compression format of an input, recognized by its magic bytes.
+enum class Compression {
+    None,
+    Gzip, ///< gzip (1f 8b), possibly several concatenated members.
+    Zstd, ///< Zstandard (28 b5 2f fd), possibly several frames.
+};
+
+/// Compression of the input starting with `head` (at least 4 bytes, if the
+/// input has them).
+Compression detectCompression(std::string_view head);
+
+/// Name for log messages: "none", "gzip" or "zstd".
+const char* compressionName(Compression compression);
+
+/// True if this build can decompress `compression` (zlib and libzstd are
+/// optional dependencies, see the TEMPLATE_INSIGHT_WITH_* CMake options).
+bool compressionSupported(Compression compression);
+
+/// Stream buffer with the decompressed content of a gzip or zstd stream.
+///
+/// A background thread reads the compressed stream and decompresses it into
+/// blocks of `blockSize` bytes, which reach the reading thread through a queue
+/// of at most kQueueBlocks blocks, so decompression and analysis overlap while
+/// memory stays bounded. Consumed blocks are reused.
+///
+/// A corrupt or truncated stream makes reading fail with std::runtime_error
+/// once the data before the error has been read; enable exceptions for badbit
+/// on the std::istream that reads this buffer to see it.
+class DecompressingStreamBuf : public std::streambuf {
+public:
+    static constexpr std::size_t kBlockSize = 256 * 1024;
+    static constexpr std::size_t kQueueBlocks = 4;
+
+    /// Starts decompressing `compressed`, which must outlive the buffer.
+    /// @throws std::runtime_error if `compression` is not supported by this build.
+    DecompressingStreamBuf(std::istream& compressed, Compression compression,
+                           std::size_t blockSize = kBlockSize);
+
+    /// Stops the background thread.
+    ~DecompressingStreamBuf() override;
+
+    DecompressingStreamBuf(const DecompressingStreamBuf&) = delete;
+    DecompressingStreamBuf& operator=(const DecompressingStreamBuf&) = delete;
+
+protected:
+    int_type underflow() override;
+
+private:
+    void run();
+    void inflateGzip();
+    void decompressZstd();
+    std::vector<char> takeBlock();
+    bool publish(std::vector<char>& block, std::size_t size);
+
+    std::istream& in_;
+    Compression compression_;
+    std::size_t blockSize_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    /// Decompressed blocks not yet read, in order.
+    std::deque<std::vector<char>> full_;
+    /// Read blocks, for reuse.
+    std::vector<std::vector<char>> free_;
+    /// Block the get area points into.
+    std::vector<char> current_;
+    bool done_ = false;
+    bool stop_ = false;
+    std::exception_ptr failure_;
+    std::thread thread_;
+};
+
+} // namespace template_insight
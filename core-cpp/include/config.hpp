@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <cstddef>
 
 #include <spdlog/common.h>
@@ -20,10 +21,19 @@ struct AnalysisConfig {
     /// Maximum template instantiation depth the analyzer should consider.
     int maxTemplateDepth = 64;
 
+    /// Instantiation frame descriptions longer than this many characters get
+    /// their type spellings abbreviated (see abbreviateTypeNames()), with
+    /// template arguments nested deeper than maxTemplateDepth elided.
+    /// 0 (the default) keeps descriptions verbatim: an abbreviated frame does
+    /// not keep the original spelling.
+    std::size_t typeNameAbbreviationLength = 0;
+
     /// Whether to enable analysis optimizations (exact meaning is up to implementation).
     bool enableOptimizations = true;
 
-    /// Soft timeout for analysis, in milliseconds.
+    /// Soft limit on the time one analysis may spend analyzing, in
+    /// milliseconds; 0 disables it. Time spent waiting for input does not
+    /// count.
     int timeoutMs = 5000;
 
     /// Optional list of enabled issue codes (e.g., "NO_MEMBER", "TYPE_MISMATCH").
@@ -33,6 +43,63 @@ struct AnalysisConfig {
     /// Maximum number of issues to report before stopping analysis.
     std::size_t maxIssues = 1000;
 
+    /// Number of worker threads for analyzing large in-memory logs.
+    /// 0 means std::thread::hardware_concurrency(); 1 disables parallel analysis.
+    unsigned workerThreads = 0;
+
+    /// Target size of the chunks a log is split into for parallel analysis.
+    /// Logs smaller than two chunks are analyzed sequentially.
+    std::size_t parallelChunkBytes = 4 * 1024 * 1024;
+
+    /// Treat the input as the output of a parallel build (ninja, make -j) and
+    /// analyze it per compile job (see BuildOutputAnalyzer), attributing
+    /// issues to the job's translation unit. Replaces chunked parallel
+    /// analysis and the analysis cache.
+    bool demultiplexBuildOutput = false;
+
+    /// Size cap of the analysis cache in bytes (see AnalysisCache).
+    /// 0 disables caching.
+    std::size_t cacheMaxBytes = 0;
+
+    /// Optional file the CLI loads the analysis cache from and saves it to,
+    /// so unchanged diagnostics are not re-analyzed across runs.
+    std::string cacheFile;
+
+    /// Merge identical issues (same code, location and instantiation stack)
+    /// into one issue with an occurrence count before output (see deduplicateIssues()).
+    /// This needs the complete result, so the CLI then writes no issue
+    /// before analysis ends.
+    bool deduplicateIssues = false;
+
+    /// Maximum number of other translation units listed per merged issue.
+    std::size_t maxDuplicateUnits = 32;
+
+    /// Compiler whose diagnostics the CLI and the server analyze unless a
+    /// request names one (see AnalysisOptions::compiler).
+    std::string compiler = "auto";
+
+    /// Compiler (possibly with wrapper, e.g. "ccache clang++") used for the
+    /// syntax-only compiles of a batch analysis (see analyzeCompileCommands()).
+    /// If empty, each compile command's own compiler is used.
+    std::string batchCompiler;
+
+    /// Optional file the CLI keeps per-translation-unit compile durations in,
+    /// so the next batch analysis starts the slowest translation units first.
+    std::string batchTimingsFile;
+
+    /// Number of most expensive templates and headers reported when profiling
+    /// -ftime-trace files (see profileTimeTraces()).
+    std::size_t profileTopN = 10;
+
+    /// Time in milliseconds a followed log (see followLog()) must stay
+    /// unchanged before its last diagnostic is reported without waiting for
+    /// the line that would close it.
+    int followSettleMs = 250;
+
+    /// Stop following a log once it has not grown for this many milliseconds.
+    /// 0 follows until interrupted.
+    int followIdleTimeoutMs = 0;
+
     /// Optional path to a JSON file describing known issue kinds.
     /// If empty, a built-in minimal set (or hard-coded defaults) is used.
     std::string issueKindsFile;
@@ -40,7 +107,9 @@ struct AnalysisConfig {
 
 /// Output-related configuration parameters.
 struct OutputConfig {
-    /// Output format identifier, e.g., "json" or "text".
+    /// Output format identifier, e.g., "json", "ndjson" (one JSON object per
+    /// line, written while analysis runs; see ResultJsonWriter), "binary"
+    /// (see encodeBinaryResult()) or "text".
     std::string format = "json";
 
     /// Whether to include additional details in the output.
@@ -48,6 +117,14 @@ struct OutputConfig {
 
     /// Optional path to an output file. If empty, output goes to stdout.
     std::string outputFile;
+
+    /// Whether JSON output includes the analysis statistics (phase timings and
+    /// counters, see AnalysisStats). Requires a TEMPLATE_INSIGHT_METRICS build.
+    bool writeStats = false;
+
+    /// Optional path the CLI writes the analysis statistics to as a Chrome
+    /// trace-event file (see writeChromeTrace()).
+    std::string traceFile;
 };
 
 /// Application-wide configuration (extendable later).
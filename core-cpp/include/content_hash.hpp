@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace template_insight {
+
+/// Finalizer of MurmurHash3 (full avalanche of a 64-bit value).
+inline std::uint64_t mixHash(std::uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/// Fold `value` into the running hash `seed`.
+inline std::uint64_t combineHash(std::uint64_t seed, std::uint64_t value) {
+    return mixHash(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+/// Fast 64-bit non-cryptographic hash of `data`, reading 8 bytes at a time.
+///
+/// Unlike std::hash the result is fixed for a given input and seed (on
+/// little-endian targets), so it can key data persisted between runs.
+inline std::uint64_t hashBytes(std::string_view data, std::uint64_t seed = 0) {
+    std::uint64_t h = seed ^ (data.size() * 0x9e3779b97f4a7c15ULL);
+    std::size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data.data() + i, sizeof(word));
+        h = (h ^ mixHash(word)) * 0x87c37b91114253d5ULL;
+        h = (h << 31) | (h >> 33);
+    }
+    std::uint64_t tail = 0;
+    if (i < data.size()) {
+        std::memcpy(&tail, data.data() + i, data.size() - i);
+    }
+    return mixHash(h ^ mixHash(tail ^ (data.size() - i)));
+}
+
+} // namespace template_insight
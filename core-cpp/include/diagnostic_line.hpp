@@ -0,0 +1,46 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+namespace template_insight {
+
+/// Kind keyword of a compiler diagnostic line.
+enum class DiagnosticKind {
+    Error,
+    FatalError,
+    Warning,
+    Note,
+    Remark
+};
+
+/// Tokenized clang/gcc diagnostic line, e.g.
+///   "src/main.cpp:10:5: error: no member named 'begin' in 'int'".
+///
+/// All fields are views into the parsed line; nothing is allocated.
+struct DiagnosticLine {
+    /// File (or tool name, as in "clang: error: ..."). Empty if absent.
+    std::string_view file;
+    /// 1-based line and column; 0 if not present.
+    int line = 0;
+    int column = 0;
+    DiagnosticKind kind = DiagnosticKind::Error;
+    /// Text after the "error: " keyword.
+    std::string_view message;
+};
+
+/// Parse the "file:line:col: kind: message" prefix of a diagnostic line.
+///
+/// Accepted forms are "file:line:col: kind: msg", "file:line: kind: msg",
+/// "file: kind: msg" and "kind: msg", where kind is one of "error",
+/// "fatal error", "warning", "note" or "remark". Windows drive letters
+/// ("C:\src\a.cpp:1:2: ...") are handled. A trailing "\n" / "\r\n" is ignored.
+///
+/// @return std::nullopt if the line is not a diagnostic line.
+std::optional<DiagnosticLine> parseDiagnosticLine(std::string_view text);
+
+/// Split a "file:line:col", "file:line" or "file" location into its parts.
+/// Missing numbers are set to 0. Nothing is allocated.
+void parseLocationPrefix(std::string_view text, std::string_view& file, int& line, int& column);
+
+} // namespace template_insight
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace template_insight {
+
+/// How a compiler phrases its text diagnostics.
+enum class Dialect {
+    Generic, ///< Understands clang and gcc output at once (also mixed logs).
+    Clang,
+    Gcc,
+};
+
+/// "generic", "clang" or "gcc".
+const char* dialectName(Dialect dialect);
+
+/// Dialect selected by AnalysisOptions::compiler: "clang" (also "clang++",
+/// "apple-clang"), "gcc" (also "g++"), anything else is Generic. std::nullopt
+/// for "auto", which detects the dialect from the input (see detectDialect()).
+std::optional<Dialect> dialectFromCompiler(std::string_view compiler);
+
+/// Input inspected by detectDialect().
+inline constexpr std::size_t kDialectProbeBytes = 16 * 1024;
+
+/// Dialect of the log starting with `head`, judged by phrases only one of
+/// the compilers prints ("requested here", "N errors generated." for clang;
+/// "required from", "In instantiation of", "has no member named" for gcc).
+/// Generic if both appear; std::nullopt if neither does.
+std::optional<Dialect> detectDialect(std::string_view head);
+
+namespace detail {
+
+inline bool startsWith(std::string_view s, std::string_view prefix) {
+    return s.substr(0, prefix.size()) == prefix;
+}
+
+} // namespace detail
+
+// Dialect policies. Parsers are templates over these, so every check below
+// is resolved at compile time and inlined into the per-line loops.
+
+/// clang: context lines are include stacks only; instantiation backtraces are
+/// notes ("note: in instantiation of ... requested here").
+struct ClangDialect {
+    static constexpr Dialect kDialect = Dialect::Clang;
+    static constexpr bool kBacktraceNotes = true;
+    static constexpr bool kBacktraceContextLines = false;
+
+    /// Line (without its line end) that opens or continues a prelude.
+    static bool isContextLine(std::string_view line) {
+        return detail::startsWith(line, "In file included from");
+    }
+};
+
+/// gcc: "a.cpp: In function ...", "a.h: In instantiation of ...", "required
+/// from ..." context lines carry the backtrace.
+struct GccDialect {
+    static constexpr Dialect kDialect = Dialect::Gcc;
+    static constexpr bool kBacktraceNotes = false;
+    static constexpr bool kBacktraceContextLines = true;
+
+    static bool isContextLine(std::string_view line) {
+        static constexpr std::string_view kScopes[] = {
+            "instantiation of",
+            "substitution of",
+            "function",
+            "member function",
+            "static member function",
+            "constructor",
+            "destructor",
+            "lambda function",
+        };
+        if (detail::startsWith(line, "In file included from")) {
+            return true;
+        }
+        // "file: In <scope> ...", found with one search.
+        const auto in = line.find(": In ");
+        if (in != std::string_view::npos) {
+            const std::string_view scope = line.substr(in + 5);
+            for (std::string_view s : kScopes) {
+                if (detail::startsWith(scope, s)) {
+                    return true;
+                }
+            }
+        }
+        const auto required = line.find("required ");
+        if (required != std::string_view::npos) {
+            const std::string_view rest = line.substr(required + 9);
+            if (detail::startsWith(rest, "from") || detail::startsWith(rest, "by substitution of")) {
+                return true;
+            }
+        }
+        return line.find(": At global scope") != std::string_view::npos;
+    }
+};
+
+/// Both dialects: every marker of either compiler, anywhere in the line.
+struct GenericDialect {
+    static constexpr Dialect kDialect = Dialect::Generic;
+    static constexpr bool kBacktraceNotes = true;
+    static constexpr bool kBacktraceContextLines = true;
+
+    static bool isContextLine(std::string_view line) {
+        static constexpr std::string_view kMarkers[] = {
+            "In file included from",
+            ": In instantiation of",
+            ": In substitution of",
+            ": In function",
+            ": In member function",
+            ": In static member function",
+            ": In constructor",
+            ": In destructor",
+            ": In lambda function",
+            ": At global scope",
+            "required from",
+            "required by substitution of",
+        };
+        for (std::string_view marker : kMarkers) {
+            if (line.find(marker) != std::string_view::npos) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/// Call `f` with the policy object of `dialect`: the only runtime dispatch,
+/// done once per chunk or block rather than per line.
+template <class F>
+decltype(auto) withDialect(Dialect dialect, F&& f) {
+    switch (dialect) {
+        case Dialect::Clang: return f(ClangDialect{});
+        case Dialect::Gcc:   return f(GccDialect{});
+        case Dialect::Generic: break;
+    }
+    return f(GenericDialect{});
+}
+
+} // namespace template_insight
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "model.hpp"
+#include "string_interner.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace template_insight {
+
+/// A backtrace frame as found in the log; views into the diagnostic block.
+struct BacktraceFrame {
+    std::string_view description;
+    std::string_view file;
+    int line = 0;
+    int column = 0;
+};
+
+/// Extract the template instantiation backtrace of one diagnostic block.
+///
+/// Understands clang notes ("in instantiation of ... requested here",
+/// "while substituting ...", "(skipping N contexts in backtrace ...)") and gcc
+/// context lines ("In instantiation of '...':", "required from ...",
+/// "required by substitution of ...", "[ skipping N instantiation contexts ... ]").
+///
+/// @param frames  Cleared and filled with frames, innermost first.
+/// @return Number of frames the compiler reported as skipped.
+std::size_t parseInstantiationBacktrace(std::string_view block, std::vector<BacktraceFrame>& frames);
+
+/// Same, looking only for the backtrace forms of one dialect (ClangDialect,
+/// GccDialect or GenericDialect, see dialect.hpp); the function above uses
+/// GenericDialect.
+template <class Policy>
+std::size_t parseInstantiationBacktrace(std::string_view block, std::vector<BacktraceFrame>& frames);
+
+/// Collects an instantiation backtrace from diagnostic notes one at a time.
+///
+/// This is the core of parseInstantiationBacktrace(), usable for structured
+/// compiler output (SARIF, gcc JSON) where every note comes with a separate
+/// message and location. Notes that are not part of a backtrace are ignored.
+class BacktraceNoteParser {
+public:
+    /// `frames` is cleared and receives the frames, innermost first.
+    explicit BacktraceNoteParser(std::vector<BacktraceFrame>& frames);
+
+    /// Process one note, e.g. "in instantiation of ... requested here",
+    /// "required from 'void h()'" or "In instantiation of 'void g()':".
+    /// The views must stay valid as long as the frames are used.
+    void note(std::string_view message, std::string_view file, int line, int column);
+
+    /// Same, recognizing only the note forms of one dialect (see dialect.hpp).
+    template <class Policy>
+    void noteIn(std::string_view message, std::string_view file, int line, int column);
+
+    /// Number of frames the compiler reported as skipped.
+    std::size_t skipped() const { return skipped_; }
+
+private:
+    void noteGcc(std::string_view message, std::string_view file, int line, int column);
+
+    std::vector<BacktraceFrame>& frames_;
+    std::size_t skipped_ = 0;
+    /// gcc names a frame in one note and gives its location in the next one.
+    std::optional<std::string_view> gccPending_;
+};
+
+/// Builds the shared prefix tree of instantiation frames for one result.
+///
+/// Backtraces are inserted outermost frame first; a frame with the same
+/// parent, description and location as an existing one reuses that node.
+class InstantiationTreeBuilder {
+public:
+    /// Insert a backtrace (innermost first, as returned by
+    /// parseInstantiationBacktrace()) keeping at most `maxDepth` frames.
+    ///
+    /// When the backtrace is deeper than `maxDepth`, the outer and inner ends
+    /// are kept and the middle is dropped (like clang's backtrace limit).
+    ///
+    /// @param omitted Incremented by the number of dropped frames.
+    /// @return Innermost node, or std::nullopt if nothing was inserted.
+    std::optional<std::size_t> insert(const std::vector<BacktraceFrame>& frames,
+                                      int maxDepth,
+                                      std::size_t& omitted);
+
+    /// Insert a single frame below `parent` (or as an outermost frame).
+    std::size_t insertFrame(std::optional<std::size_t> parent, const InstantiationFrame& frame);
+
+    const std::vector<InstantiationFrame>& frames() const { return frames_; }
+
+    /// Move the built frames out (the builder is empty afterwards).
+    std::vector<InstantiationFrame> take();
+
+private:
+    std::size_t insertView(std::optional<std::size_t> parent, const BacktraceFrame& frame);
+
+    std::vector<InstantiationFrame> frames_;
+    /// Hash of (parent, description, location) -> candidate nodes.
+    std::unordered_multimap<std::uint64_t, std::size_t> index_;
+    StringInterner files_;
+};
+
+} // namespace template_insight
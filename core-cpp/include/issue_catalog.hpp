@@ -0,0 +1,75 @@
+#pragma once
+
+#include "config.hpp"
+#include "issues.hpp"
+#include "pattern_matcher.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace template_insight {
+
+/// Compact handle of an issue kind inside an IssueCatalog.
+using IssueKindId = std::uint32_t;
+
+/// Immutable, compiled set of issue kinds for one analysis configuration.
+///
+/// The catalog merges the kinds of an IssueRegistry with the built-in kinds
+/// (registry entries override built-ins with the same code; kinds without
+/// patterns inherit the built-in patterns), assigns every kind an IssueKindId
+/// and compiles the patterns of the enabled kinds into one PatternMatcher whose
+/// pattern indices resolve directly to kind ids. No code string is looked up
+/// while logs are analyzed.
+///
+/// Build it once (IssueCatalog::load()) and share it between analyses, threads
+/// and requests; it is never modified after construction.
+class IssueCatalog {
+public:
+    /// Compile a catalog from `registry` and the built-in kinds.
+    /// @param enabledCodes Codes whose patterns are matched; empty enables all.
+    IssueCatalog(const IssueRegistry& registry, const std::vector<std::string>& enabledCodes);
+
+    // byCode_ refers to the codes stored in kinds_.
+    IssueCatalog(const IssueCatalog&) = delete;
+    IssueCatalog& operator=(const IssueCatalog&) = delete;
+
+    /// Load the registry named by AnalysisConfig::issueKindsFile and compile it
+    /// for AnalysisConfig::enabledIssueCodes. A missing or invalid file is
+    /// logged and only the built-in kinds are used.
+    static std::shared_ptr<const IssueCatalog> load(const AnalysisConfig& config);
+
+    /// Kind by id.
+    const IssueKind& kind(IssueKindId id) const { return kinds_[id]; }
+
+    /// Id of the kind with the given code, or std::nullopt if the code is unknown.
+    std::optional<IssueKindId> findId(std::string_view code) const;
+
+    /// Matcher over the patterns of all enabled kinds.
+    const PatternMatcher& matcher() const { return matcher_; }
+
+    /// Kind of a matcher pattern (as reported by PatternMatcher::scan()).
+    IssueKindId kindOfPattern(std::uint32_t patternIndex) const { return patternKinds_[patternIndex]; }
+
+    std::size_t size() const { return kinds_.size(); }
+
+    /// Whether the kind is enabled by AnalysisConfig::enabledIssueCodes.
+    bool enabled(IssueKindId id) const { return enabled_[id]; }
+
+    /// Hash of everything that affects the issues produced with this catalog
+    /// (kinds, messages, patterns, enabled codes); used to key cached results.
+    std::uint64_t fingerprint() const { return fingerprint_; }
+
+private:
+    std::vector<IssueKind> kinds_;
+    std::unordered_map<std::string_view, IssueKindId> byCode_;
+    PatternMatcher matcher_;
+    std::vector<IssueKindId> patternKinds_;
+    std::vector<bool> enabled_;
+    std::uint64_t fingerprint_ = 0;
+};
+
+} // namespace template_insight
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "model.hpp"
+
+#include <cstddef>
+
+namespace template_insight {
+
+/// Collapse issues that report the same problem into one aggregated issue.
+///
+/// Two issues are the same problem when they have the same code, the same
+/// normalized location (file path lexically normalized, line, column) and the
+/// same instantiation stack. Identical stacks share one node in the
+/// instantiation tree of a result, so the stack compares as a single frame
+/// index. Keys are built from interned ids and looked up in one hash map.
+///
+/// The first occurrence is kept, in place. Its TemplateIssue::occurrences
+/// counts all merged issues. The distinct translation units of the others are
+/// appended to TemplateIssue::duplicateTranslationUnits, up to
+/// `maxListedUnits` per issue (0 lists none).
+///
+/// @return Number of issues removed.
+std::size_t deduplicateIssues(TemplateInsightResult& result, std::size_t maxListedUnits);
+
+} // namespace template_insight
@@ -4,7 +4,7 @@
 
 #include <string>
 #include <unordered_map>
-#include <optional>
+#include <vector>
 
 namespace template_insight {
 
@@ -25,14 +25,19 @@ struct IssueKind {
 
     /// Default detailed explanation.
     std::string defaultDetailedMessage;
+
+    /// Literal phrases in compiler output that identify this issue kind,
+    /// e.g. "no member named". If empty, the built-in patterns for the code
+    /// (if any) are used.
+    std::vector<std::string> patterns;
 };
 
 /// Registry that stores known issue kinds and can provide metadata
 /// for a given issue code.
 ///
 /// The registry is intentionally lightweight and loaded from a JSON file.
-/// If an issue code is not found in the registry, callers may choose to
-/// fall back to hard-coded defaults.
+/// Analyses do not use it directly: it is compiled, together with the
+/// hard-coded defaults, into an IssueCatalog (see issue_catalog.hpp).
 class IssueRegistry {
 public:
     IssueRegistry() = default;
@@ -42,7 +47,8 @@ public:
     /// Expected structure:
     /// {
     ///   "issue_kinds": [
-    ///      { "code": "...", "category": "...", "default_severity": "error", ... },
+    ///      { "code": "...", "category": "...", "default_severity": "error",
+    ///        "patterns": ["..."], ... },
     ///      ...
     ///   ]
     /// }
@@ -54,15 +60,26 @@ public:
     void addIssueKind(const IssueKind& kind);
 
     /// Lookup metadata for a given issue code.
-    /// Returns std::nullopt if the code is unknown.
-    std::optional<IssueKind> find(const std::string& code) const;
+    /// Returns nullptr if the code is unknown. The pointer stays valid until
+    /// the registry is modified.
+    const IssueKind* find(const std::string& code) const;
+
+    /// All registered issue kinds (in no particular order).
+    std::vector<IssueKind> all() const;
 
 private:
     std::unordered_map<std::string, IssueKind> kinds_;
 };
 
+/// Hard-coded metadata and patterns for the well-known IssueCodes.
+/// Used whenever the registry does not describe a code (or its patterns).
+const std::vector<IssueKind>& builtinIssueKinds();
+
 /// Helper to map textual severity from JSON ("info", "warning", "error", ...) to Severity enum.
 /// Unknown strings fall back to Severity::Error.
 Severity parseSeverity(const std::string& s);
 
+/// Inverse of parseSeverity(): textual name used in logs and JSON output.
+std::string severityToString(Severity s);
+
 } // namespace template_insight
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "compact_result.hpp"
+#include "model.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace template_insight {
+
+/// Append `text` to `out` as the contents of a JSON string literal.
+///
+/// Quotes, backslashes and all control characters are escaped; runs of bytes
+/// that need no escaping (the common case) are located 16 bytes at a time and
+/// copied in bulk.
+void appendJsonEscaped(std::string& out, std::string_view text);
+
+/// Textual name of a truncation reason ("max_issues", "timeout", ...).
+const char* truncationReasonToString(TruncationReason reason);
+
+/// Append-only output buffer.
+///
+/// Either collects everything in memory (see str()), or is bound to a file
+/// descriptor and writes its contents there with write(2) whenever it grows
+/// past a threshold, on flush() and on destruction. Where file descriptors
+/// are not available, output goes through a C stdio stream instead.
+class OutputBuffer {
+public:
+    /// In-memory buffer.
+    OutputBuffer() = default;
+
+    /// Buffer flushed to `fd`, which is not closed by the buffer. Without
+    /// file descriptors, only 1 (stdout) and 2 (stderr) are supported.
+    explicit OutputBuffer(int fd);
+
+    /// Buffer flushed to the standard output.
+    static OutputBuffer standardOutput() { return OutputBuffer(1); }
+
+    /// Buffer flushed to the file at `path` (created or truncated).
+    /// @throws std::runtime_error if the file cannot be opened.
+    static OutputBuffer openFile(const std::string& path);
+
+    OutputBuffer(OutputBuffer&& other) noexcept;
+    OutputBuffer& operator=(OutputBuffer&& other) noexcept;
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    /// Flushes pending output (errors are logged) and closes an owned file.
+    ~OutputBuffer();
+
+    void append(std::string_view text) {
+        buffer_.append(text);
+        maybeFlush();
+    }
+    void append(char c) {
+        buffer_.push_back(c);
+        maybeFlush();
+    }
+    void appendNumber(std::uint64_t value);
+    void appendEscaped(std::string_view text) {
+        appendJsonEscaped(buffer_, text);
+        maybeFlush();
+    }
+
+    /// Write pending output to the file descriptor (no-op for in-memory buffers).
+    /// @throws std::runtime_error if writing fails.
+    void flush();
+
+    /// Contents of an in-memory buffer.
+    std::string& str() { return buffer_; }
+
+    /// Pending output is written once it reaches this size.
+    static constexpr std::size_t kFlushThreshold = 64 * 1024;
+
+private:
+    bool bound() const { return fd_ >= 0 || stream_ != nullptr; }
+    void maybeFlush() {
+        if (bound() && buffer_.size() >= kFlushThreshold) {
+            flush();
+        }
+    }
+    void release() noexcept;
+
+    std::string buffer_;
+    int fd_ = -1;
+    /// Used instead of fd_ where file descriptors are not available.
+    std::FILE* stream_ = nullptr;
+    bool ownsFd_ = false;
+};
+
+/// Incremental JSON writer for analysis results.
+///
+/// Issues are written one by one as they are produced (writeIssue()), the
+/// rest of the result when analysis is done (finish()). Nothing is written
+/// before the first issue or finish(), so a run that fails before producing
+/// anything leaves the output empty. Two layouts exist:
+///
+/// - Document: the single JSON object produced by serializeToJson().
+/// - Ndjson: one JSON object per line, flushed as soon as it is complete, so a
+///   reader can render issues while analysis continues:
+///     {"type":"frame","id":0,"description":"...","parent":..,"location":{..}}
+///     {"type":"issue","code":"...",...,"instantiation":0}
+///     {"type":"summary","issues":1,"truncated":false}
+///   Frames are written before the first issue that refers to them.
+class ResultJsonWriter {
+public:
+    enum class Layout { Document, Ndjson };
+
+    ResultJsonWriter(OutputBuffer& out, Layout layout);
+
+    /// Also write the result's statistics in finish(), unless they are empty:
+    /// a "stats" member ({"phaseMicros": {...}, "counters": {...}}) in the
+    /// Document layout, a {"type":"stats",...} line before the summary in the
+    /// Ndjson layout. The serialize phase covers the time from the writer's
+    /// construction to the statistics.
+    void setWriteStats(bool enabled) { writeStats_ = enabled; }
+
+    /// Write one issue. `frames` are the instantiation frames recorded so far;
+    /// frame ids are stable, so only frames not written yet are looked at.
+    void writeIssue(const TemplateIssue& issue, const std::vector<InstantiationFrame>& frames);
+
+    /// Same for an issue of `result`, written straight from the catalog's
+    /// strings and the interned paths (see CompactIssueSink).
+    void writeIssue(const CompactResult& result, const CompactIssue& issue,
+                    const std::vector<InstantiationFrame>& frames);
+
+    /// Write the issues still held by `result`, its instantiation frames and
+    /// truncation state, and close the output. The writer must not be used
+    /// afterwards.
+    void finish(const TemplateInsightResult& result);
+    void finish(const CompactResult& result);
+
+private:
+    void writeHeader();
+    template <class WriteFields>
+    void writeIssueObject(const std::vector<InstantiationFrame>& frames, WriteFields&& writeFields);
+    void writeKindFields(std::string_view code, std::string_view category, Severity severity,
+                         std::string_view shortMessage, std::string_view detailedMessage);
+    void writeIssueFields(const TemplateIssue& issue);
+    void writeIssueFields(const CompactResult& result, const CompactIssue& issue);
+    void writeFrame(std::size_t id, const InstantiationFrame& frame);
+    void writeLocation(std::string_view file, int line, int column);
+    void writeTail(const std::vector<InstantiationFrame>& frames, TruncationReason truncation,
+                   const AnalysisStats& statistics);
+    void writeStatsFields(const AnalysisStats& stats);
+
+    OutputBuffer& out_;
+    Layout layout_;
+    std::size_t issuesWritten_ = 0;
+    std::size_t framesWritten_ = 0;
+    bool headerWritten_ = false;
+    bool writeStats_ = false;
+    std::uint64_t startMicros_ = 0;
+};
+
+} // namespace template_insight
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "api.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace template_insight {
+
+/// Analyze a log file that is still being written, like `tail -f`.
+///
+/// The existing content is analyzed first; after that, bytes appended to the
+/// file are fed to the same DiagnosticsAnalyzer as they arrive, so a
+/// diagnostic split across writes is parsed as one. Changes are waited for
+/// with inotify on Linux and by polling elsewhere.
+///
+/// Issues are passed to `sink` (in compact form, since they are usually
+/// written right away) as soon as their diagnostic is complete: when
+/// the next diagnostic or build output line is appended, or when the log has
+/// not changed for AnalysisConfig::followSettleMs. If the file is truncated
+/// or replaced (log rotation, a new build writing the same path), it is
+/// reopened and read from the start.
+///
+/// Following ends when `stop` becomes true, when the log has not grown for
+/// AnalysisConfig::followIdleTimeoutMs (if set) or when the analyzer stops at
+/// AnalysisConfig::maxIssues. AnalysisConfig::timeoutMs does not apply.
+///
+/// @throws std::runtime_error if the file cannot be opened or read.
+CompactResult followLog(const std::string& path,
+                        const AnalysisOptions& options,
+                        const AppConfig& config,
+                        std::shared_ptr<const IssueCatalog> catalog,
+                        const CompactIssueSink& sink,
+                        const std::atomic<bool>& stop);
+
+} // namespace template_insight
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace template_insight {
+
+/// Implementation of the byte scans below.
+enum class ScanKernel {
+    Scalar, ///< memchr.
+    Sse2,   ///< 16-byte compares (any x86-64 CPU).
+    Avx2,   ///< 32-byte compares, chosen at run time if the CPU has AVX2.
+};
+
+/// Fastest kernel the running CPU supports.
+ScanKernel detectScanKernel();
+
+/// "scalar", "sse2" or "avx2".
+const char* scanKernelName(ScanKernel kernel);
+
+/// Append the offset of every '\n' in `text` to `ends`, in order, using the
+/// kernel of detectScanKernel(). `text` must be shorter than 4 GiB; callers
+/// index long input window by window.
+void indexLineEnds(std::string_view text, std::vector<std::uint32_t>& ends);
+
+/// Same, with the given kernel, which must not be faster than the one of
+/// detectScanKernel(). Meant for tests and benchmarks.
+void indexLineEnds(std::string_view text, std::vector<std::uint32_t>& ends, ScanKernel kernel);
+
+/// True if `text` contains an ESC byte, i.e. possibly ANSI escape sequences.
+bool containsEscape(std::string_view text);
+
+/// Removes ANSI escape sequences from text fed in arbitrary chunks.
+///
+/// Builds with -fcolor-diagnostics / -fdiagnostics-color=always put SGR
+/// sequences ("\x1b[1m", "\x1b[0;1;31m") between the words of a diagnostic
+/// and gcc wraps URLs in OSC 8 hyperlinks ("\x1b]8;;https://...\x1b\\"), so
+/// patterns and "file:line:col:" prefixes only match once they are removed.
+/// Recognized are CSI sequences (ESC [ ... final byte), OSC sequences
+/// (ESC ] ... BEL or ESC \) and other two-byte escapes. A sequence may span
+/// chunks; a malformed one ends at the next newline, which is kept.
+class AnsiStripper {
+public:
+    /// Replace the content of `out` with `chunk` minus escape sequences.
+    void strip(std::string_view chunk, std::string& out);
+
+    /// True if the last chunk ended inside an escape sequence, so the next
+    /// one must be stripped even if it contains no ESC.
+    bool inSequence() const { return state_ != State::Text; }
+
+    /// Drop an escape sequence the last chunk ended in; the next chunk is
+    /// unrelated text.
+    void reset() { state_ = State::Text; }
+
+    /// Escape sequences removed so far.
+    std::size_t sequences() const { return sequences_; }
+
+private:
+    enum class State {
+        Text,
+        Escape,       ///< After ESC.
+        Intermediate, ///< ESC followed by intermediate bytes (0x20-0x2f).
+        Csi,          ///< Inside ESC [ ...
+        Osc,          ///< Inside ESC ] ...
+        OscEscape,    ///< ESC inside an OSC sequence.
+    };
+
+    State state_ = State::Text;
+    std::size_t sequences_ = 0;
+};
+
+/// `text` without ANSI escape sequences (see AnsiStripper).
+std::string stripAnsiEscapes(std::string_view text);
+
+/// The first `size` bytes of `text` once its escape sequences are removed:
+/// a view of `text` itself if no escape sequence gets in the way, else of
+/// `scratch`. Only as much of `text` is stripped as needed.
+std::string_view strippedPrefix(std::string_view text, std::size_t size, std::string& scratch);
+
+} // namespace template_insight
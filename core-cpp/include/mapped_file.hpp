@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace template_insight {
+
+/// Read-only view of a whole log file.
+///
+/// On POSIX systems the file is memory-mapped, so analyzing it costs no read or
+/// copy and repeated analyses of the same log are served from the page cache.
+/// If mapping is not possible (non-POSIX platform, empty file, pipe or other
+/// special file), the content is read into an owned buffer instead; callers see
+/// the same string_view either way.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// Open and map (or read) the given file.
+    ///
+    /// @throws std::runtime_error if the file cannot be opened or read.
+    static MappedFile open(const std::string& path);
+
+    /// Entire file content.
+    std::string_view view() const { return {data_, size_}; }
+
+    /// True if the content is backed by a memory mapping rather than a buffer.
+    bool isMapped() const { return mapped_; }
+
+private:
+    void reset() noexcept;
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;
+};
+
+} // namespace template_insight
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Metrics collection is compiled in when TEMPLATE_INSIGHT_METRICS is 1 (the
+/// CMake option of the same name). Otherwise the macros below expand to
+/// nothing and every AnalysisStats stays empty.
+#ifndef TEMPLATE_INSIGHT_METRICS
+#define TEMPLATE_INSIGHT_METRICS 0
+#endif
+
+namespace template_insight {
+
+/// Timed phases of an analysis.
+enum class Phase : std::uint8_t {
+    RegistryLoad, ///< Loading issue kinds and building the issue catalog.
+    Scan,         ///< Splitting input into lines and diagnostic blocks (excluding Parse).
+    Parse,        ///< Classifying blocks and extracting locations and backtraces.
+    Filter,       ///< Merging duplicate issues (see deduplicateIssues()).
+    Serialize,    ///< Writing the result.
+};
+inline constexpr std::size_t kPhaseCount = 5;
+
+/// Counted events of an analysis.
+enum class Counter : std::uint8_t {
+    BytesScanned,
+    Lines,
+    EscapeSequences,    ///< ANSI escape sequences removed from colored output.
+    Blocks,             ///< Diagnostics (text blocks or structured diagnostics) classified.
+    PatternMatches,
+    Issues,             ///< Issues produced, before deduplication.
+    UnclassifiedBlocks, ///< Diagnostics dropped because no enabled issue kind matched.
+    MergedDuplicates,   ///< Issues dropped as duplicates of another one.
+    CacheHits,
+    CacheMisses,
+};
+inline constexpr std::size_t kCounterCount = 10;
+
+/// Name used in JSON output and trace files, e.g. "registryLoad", "bytesScanned".
+const char* phaseName(Phase phase);
+const char* counterName(Counter counter);
+
+/// Microseconds on a steady clock; the origin is arbitrary but shared by all threads.
+inline std::uint64_t metricsNowMicros() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// Timings and counters of one analysis (see TemplateInsightResult::stats).
+///
+/// Phase totals and counters of results merged from several threads are
+/// summed, so phase totals are thread time rather than wall time; spans keep
+/// the wall-clock placement of the larger steps per thread.
+struct AnalysisStats {
+    /// A timed interval, for trace output.
+    struct Span {
+        const char* name = "";
+        std::uint32_t thread = 0;
+        std::uint64_t startMicros = 0;
+        std::uint64_t durationMicros = 0;
+    };
+
+    std::array<std::uint64_t, kPhaseCount> phaseMicros{};
+    std::array<std::uint64_t, kCounterCount> counters{};
+    std::vector<Span> spans;
+
+    std::uint64_t& phase(Phase p) { return phaseMicros[static_cast<std::size_t>(p)]; }
+    std::uint64_t phase(Phase p) const { return phaseMicros[static_cast<std::size_t>(p)]; }
+    std::uint64_t& counter(Counter c) { return counters[static_cast<std::size_t>(c)]; }
+    std::uint64_t counter(Counter c) const { return counters[static_cast<std::size_t>(c)]; }
+
+    /// Record a span on the calling thread.
+    void addSpan(const char* name, std::uint64_t startMicros, std::uint64_t durationMicros);
+
+    /// True if nothing was recorded (always the case without TEMPLATE_INSIGHT_METRICS).
+    bool empty() const;
+
+    /// Add the totals, counters and spans of `other`.
+    void merge(const AnalysisStats& other);
+};
+
+/// Adds the time between construction and destruction to a phase.
+class ScopedPhaseTimer {
+public:
+    /// @param recordSpan Also record the interval as a span; off for timers
+    ///                   around small, frequent steps.
+    /// @param nested     Phase timed inside this one whose time is not counted
+    ///                   twice (pass `phase` itself if there is none).
+    ScopedPhaseTimer(AnalysisStats& stats, Phase phase, bool recordSpan, Phase nested)
+        : stats_(stats), phase_(phase), nested_(nested), recordSpan_(recordSpan),
+          nestedBefore_(stats.phase(nested)), start_(metricsNowMicros()) {}
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+    ~ScopedPhaseTimer() {
+        const std::uint64_t elapsed = metricsNowMicros() - start_;
+        if (nested_ != phase_) {
+            const std::uint64_t nested = stats_.phase(nested_) - nestedBefore_;
+            stats_.phase(phase_) += elapsed > nested ? elapsed - nested : 0;
+        } else {
+            stats_.phase(phase_) += elapsed;
+        }
+        if (recordSpan_) {
+            stats_.addSpan(phaseName(phase_), start_, elapsed);
+        }
+    }
+
+private:
+    AnalysisStats& stats_;
+    Phase phase_;
+    Phase nested_;
+    bool recordSpan_;
+    std::uint64_t nestedBefore_;
+    std::uint64_t start_;
+};
+
+/// Records the time between construction and destruction as a named span.
+class ScopedSpan {
+public:
+    ScopedSpan(AnalysisStats& stats, const char* name) : stats_(stats), name_(name), start_(metricsNowMicros()) {}
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+    ~ScopedSpan() { stats_.addSpan(name_, start_, metricsNowMicros() - start_); }
+
+private:
+    AnalysisStats& stats_;
+    const char* name_;
+    std::uint64_t start_;
+};
+
+/// Write `stats` as a Chrome trace-event file (chrome://tracing, Perfetto):
+/// one complete event per span and the counters as a counter event.
+/// @throws std::runtime_error if the file cannot be written.
+void writeChromeTrace(const AnalysisStats& stats, const std::string& path);
+
+} // namespace template_insight
+
+#define TEMPLATE_INSIGHT_METRICS_CONCAT2(a, b) a##b
+#define TEMPLATE_INSIGHT_METRICS_CONCAT(a, b) TEMPLATE_INSIGHT_METRICS_CONCAT2(a, b)
+
+#if TEMPLATE_INSIGHT_METRICS
+/// Add the rest of the enclosing scope's run time to `phase` (no span).
+#define TEMPLATE_INSIGHT_TIME_PHASE(stats, phase)                                                     \
+    ::template_insight::ScopedPhaseTimer TEMPLATE_INSIGHT_METRICS_CONCAT(tiPhaseTimer, __LINE__)(     \
+        (stats), (phase), false, (phase))
+/// Like TEMPLATE_INSIGHT_TIME_PHASE, without the time spent in phase `nested`.
+#define TEMPLATE_INSIGHT_TIME_PHASE_EXCLUDING(stats, phase, nested)                                   \
+    ::template_insight::ScopedPhaseTimer TEMPLATE_INSIGHT_METRICS_CONCAT(tiPhaseTimer, __LINE__)(     \
+        (stats), (phase), false, (nested))
+/// Add the rest of the enclosing scope's run time to `phase` and record it as a span.
+#define TEMPLATE_INSIGHT_TRACE_PHASE(stats, phase)                                                    \
+    ::template_insight::ScopedPhaseTimer TEMPLATE_INSIGHT_METRICS_CONCAT(tiPhaseTimer, __LINE__)(     \
+        (stats), (phase), true, (phase))
+/// Record the rest of the enclosing scope's run time as a span named `name`.
+#define TEMPLATE_INSIGHT_TRACE_SPAN(stats, name)                                                      \
+    ::template_insight::ScopedSpan TEMPLATE_INSIGHT_METRICS_CONCAT(tiSpan, __LINE__)((stats), (name))
+#define TEMPLATE_INSIGHT_COUNT(stats, which, n) ((stats).counter(which) += (n))
+#else
+// Unevaluated, but keeps the arguments "used".
+#define TEMPLATE_INSIGHT_TIME_PHASE(stats, phase) ((void)sizeof(stats))
+#define TEMPLATE_INSIGHT_TIME_PHASE_EXCLUDING(stats, phase, nested) ((void)sizeof(stats))
+#define TEMPLATE_INSIGHT_TRACE_PHASE(stats, phase) ((void)sizeof(stats))
+#define TEMPLATE_INSIGHT_TRACE_SPAN(stats, name) ((void)sizeof(stats), (void)sizeof(name))
+#define TEMPLATE_INSIGHT_COUNT(stats, which, n) ((void)sizeof(stats), (void)sizeof(n))
+#endif
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "metrics.hpp"
+
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <optional>
@@ -20,6 +23,26 @@ struct SourceLocation {
     int column = 0;
 };
 
+/// One frame of a template instantiation backtrace, e.g. clang's
+/// "note: in instantiation of function template specialization 'f<int>' requested here"
+/// or gcc's "required from 'void g() [with T = int]'".
+///
+/// Frames form a prefix tree shared by all issues of a result: every frame
+/// points to the next outer frame, so a common outer chain (e.g. the same
+/// std::vector<...> instantiation) is stored once no matter how many issues
+/// go through it.
+struct InstantiationFrame {
+    /// What is being instantiated, e.g. "function template specialization 'f<int>'".
+    std::string description;
+
+    /// Where the instantiation was requested (if known).
+    std::optional<SourceLocation> location;
+
+    /// Index of the next outer frame in TemplateInsightResult::instantiations,
+    /// or std::nullopt for an outermost frame.
+    std::optional<std::size_t> parent;
+};
+
 /// Represents a single template-related issue extracted from compiler diagnostics.
 ///
 /// Instead of using a hard-coded enum for issue types, we use a string-based
@@ -42,11 +65,52 @@ struct TemplateIssue {
 
     /// Where the issue is reported in user code (if known).
     std::optional<SourceLocation> location;
+
+    /// Innermost frame of the instantiation backtrace, as an index into
+    /// TemplateInsightResult::instantiations (if the diagnostic had one).
+    /// Follow InstantiationFrame::parent to walk outwards.
+    std::optional<std::size_t> instantiation;
+
+    /// Number of backtrace frames not recorded, either because of
+    /// AnalysisConfig::maxTemplateDepth or because the compiler skipped them.
+    std::size_t omittedFrames = 0;
+
+    /// Source file of the translation unit whose compilation produced the
+    /// issue, in batch analyses (see analyzeCompileCommands()) and analyses of
+    /// build output (see BuildOutputAnalyzer); empty otherwise.
+    std::string translationUnit;
+
+    /// Number of times the issue was reported; greater than 1 once identical
+    /// issues were merged (see deduplicateIssues()).
+    std::size_t occurrences = 1;
+
+    /// Distinct translation units, other than translationUnit, that reported
+    /// the merged duplicates (possibly capped, see deduplicateIssues()).
+    std::vector<std::string> duplicateTranslationUnits;
+};
+
+/// Why an analysis stopped before reaching the end of its input.
+enum class TruncationReason {
+    None,       ///< The whole input was analyzed.
+    MaxIssues,  ///< More than AnalysisConfig::maxIssues issues were found.
+    Timeout,    ///< AnalysisConfig::timeoutMs elapsed.
+    Cancelled   ///< The caller cancelled the analysis.
 };
 
 /// Result of the analysis of a diagnostics log.
 struct TemplateInsightResult {
     std::vector<TemplateIssue> issues;
+
+    /// Set if the analysis stopped early; `issues` then holds a partial result.
+    TruncationReason truncation = TruncationReason::None;
+
+    /// Instantiation frames shared by all issues (see InstantiationFrame).
+    std::vector<InstantiationFrame> instantiations;
+
+    /// Where the time of this analysis went. Describes the run, not the
+    /// diagnostics: it is not part of serializeToJson() output, binary
+    /// results or cache entries, and is empty without TEMPLATE_INSIGHT_METRICS.
+    AnalysisStats stats;
 };
 
 /// Some well-known issue codes used by the core.
@@ -58,6 +122,10 @@ namespace IssueCodes
     inline constexpr const char* TYPE_MISMATCH        = "TYPE_MISMATCH";
     inline constexpr const char* SUBSTITUTION_FAILURE = "SUBSTITUTION_FAILURE";
     inline constexpr const char* CONSTRAINT_NOT_SATISFIED = "CONSTRAINT_NOT_SATISFIED";
+
+    // Compile-time costs reported by the -ftime-trace profiler (time_trace.hpp).
+    inline constexpr const char* EXPENSIVE_INSTANTIATION = "EXPENSIVE_INSTANTIATION";
+    inline constexpr const char* EXPENSIVE_HEADER        = "EXPENSIVE_HEADER";
 }
 
 } // namespace template_insight
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace template_insight {
+
+/// A literal text pattern that identifies an issue code in compiler output,
+/// e.g. { "NO_MEMBER", "no member named" }.
+struct IssuePattern {
+    std::string code;
+    std::string text;
+};
+
+/// Multi-pattern literal matcher (Aho-Corasick automaton).
+///
+/// The automaton is compiled once from all patterns of the enabled checks and
+/// then finds every occurrence of every pattern in a single pass over the text,
+/// so the scanning cost does not grow with the number of checks.
+///
+/// Bytes are mapped to equivalence classes (all bytes that do not occur in any
+/// pattern share one class), which keeps the dense transition table small
+/// enough to stay in cache.
+class PatternMatcher {
+public:
+    PatternMatcher() = default;
+
+    /// Build the automaton from the given patterns.
+    /// Empty patterns are ignored.
+    explicit PatternMatcher(std::vector<IssuePattern> patterns);
+
+    /// Report every occurrence of every pattern in `text`, in order of the
+    /// position where the occurrence ends.
+    ///
+    /// @param onMatch Called as onMatch(std::size_t offset, std::uint32_t patternIndex),
+    ///                where offset is the position of the first byte of the match.
+    ///                Returning false stops the scan early.
+    template <typename Callback>
+    void scan(std::string_view text, Callback&& onMatch) const;
+
+    /// Pattern by index (as reported by scan()).
+    const IssuePattern& pattern(std::uint32_t index) const { return patterns_[index]; }
+
+    std::size_t patternCount() const { return patterns_.size(); }
+    bool empty() const { return patterns_.empty(); }
+
+private:
+    using State = std::uint32_t;
+
+    std::vector<IssuePattern> patterns_;
+    std::uint8_t classOf_[256] = {};
+    std::size_t classCount_ = 1;
+    /// transitions_[state * classCount_ + class] -> next state.
+    std::vector<State> transitions_;
+    /// Matches ending in a state: outputs_[outputBegin_[s] .. outputBegin_[s + 1]).
+    std::vector<std::uint32_t> outputBegin_;
+    std::vector<std::uint32_t> outputs_;
+};
+
+template <typename Callback>
+void PatternMatcher::scan(std::string_view text, Callback&& onMatch) const {
+    if (patterns_.empty()) {
+        return;
+    }
+    State state = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        state = transitions_[state * classCount_ + classOf_[static_cast<unsigned char>(text[i])]];
+        const std::uint32_t begin = outputBegin_[state];
+        const std::uint32_t end = outputBegin_[state + 1];
+        for (std::uint32_t o = begin; o < end; ++o) {
+            const std::uint32_t index = outputs_[o];
+            if (!onMatch(i + 1 - patterns_[index].text.size(), index)) {
+                return;
+            }
+        }
+    }
+}
+
+} // namespace template_insight
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "compact_result.hpp"
+#include "instantiation.hpp"
+#include "model.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace template_insight {
+
+/// Concatenates partial analysis results in order.
+///
+/// Instantiation frames of every part are re-inserted into one shared tree in
+/// issue order, so merging the results of consecutive pieces of a log yields
+/// exactly what a single sequential analysis of the whole log would produce.
+/// Parts and the merged result are CompactResults of one IssueCatalog; file
+/// paths are re-interned into the merged result.
+class ResultMerger {
+public:
+    ResultMerger(std::size_t maxIssues, std::shared_ptr<const IssueCatalog> catalog);
+
+    /// Append the issues of `part`, which is left as it is.
+    ///
+    /// Like the sequential analyzer, the merged result is marked truncated
+    /// (MaxIssues) only when an issue beyond maxIssues is actually seen. A part
+    /// that was itself truncated ends the merge with its reason, since the
+    /// parts after it no longer directly follow its issues.
+    ///
+    /// The statistics of every part are added, also of parts that are ignored.
+    ///
+    /// @return false once the merged result is truncated; further parts are ignored.
+    bool append(const CompactResult& part);
+
+    /// True once maxIssues issues have been collected.
+    bool full() const { return result_.issues().size() >= maxIssues_; }
+
+    /// Truncation of the merged result so far.
+    TruncationReason truncation() const { return truncation_; }
+
+    /// Merged result (the merger is empty afterwards).
+    CompactResult finish();
+
+private:
+    /// `id` of `part` interned into the merged result.
+    StringInterner::Id remapString(const CompactResult& part, StringInterner::Id id);
+
+    std::size_t maxIssues_;
+    TruncationReason truncation_ = TruncationReason::None;
+    CompactResult result_;
+    InstantiationTreeBuilder tree_;
+    /// Local frame index of the current part -> merged frame index.
+    std::vector<std::optional<std::size_t>> remap_;
+    std::vector<std::size_t> path_;
+    /// Interned string id of the current part -> merged id.
+    std::vector<StringInterner::Id> stringRemap_;
+};
+
+} // namespace template_insight
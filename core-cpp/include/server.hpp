@@ -0,0 +1,68 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace template_insight {
+
+class AnalysisCache;
+class IssueCatalog;
+
+/// Resident analysis service for the IDE plugin.
+///
+/// Instead of spawning the CLI (and reloading the config, the issue catalog
+/// and the logger) for every analysis, the plugin starts one server process
+/// and exchanges length-prefixed JSON frames with it over stdin/stdout:
+///
+///   frame    := length (4 bytes, big-endian) payload (UTF-8 JSON)
+///   request  := { "id": <any>, "log": "<compiler output>", "compiler": "clang" }
+///            |  { "id": <any>, "log_file": "<path>", "compiler": "gcc" }
+///   (either may add "stats": true for the request's timings and counters,
+///    see ResultJsonWriter::setWriteStats(); "compiler" defaults to
+///    AnalysisConfig::compiler)
+///   response := { "id": <same>, "result": <analysis result JSON> }
+///            |  { "id": <same>, "error": "<message>" }
+///
+/// Requests are handled concurrently by a fixed pool of workers, so responses
+/// may arrive out of order; the plugin matches them by "id".
+///
+/// With AnalysisConfig::cacheMaxBytes set, results of runs of blocks are
+/// cached across requests (and loaded from / saved to
+/// AnalysisConfig::cacheFile), so recompiling a translation unit with unchanged diagnostics is cheap.
+class AnalysisServer {
+public:
+    /// @param concurrency Number of requests analyzed at the same time
+    ///                    (0 = std::thread::hardware_concurrency()).
+    AnalysisServer(AppConfig config, unsigned concurrency);
+    ~AnalysisServer();
+
+    /// Serve requests read from `in`, writing responses to `out`, until `in`
+    /// reaches end of file. All accepted requests are answered before returning.
+    void serve(std::istream& in, std::ostream& out);
+
+    /// Handle one request payload and return the response payload.
+    std::string handle(std::string_view request) const;
+
+    /// Maximum accepted payload size of a single frame.
+    static constexpr std::size_t kMaxFrameBytes = 1u << 30;
+
+private:
+    AppConfig config_;
+    unsigned concurrency_;
+    std::shared_ptr<const IssueCatalog> catalog_;
+    std::unique_ptr<AnalysisCache> cache_;
+};
+
+/// Write one length-prefixed frame.
+void writeFrame(std::ostream& out, std::string_view payload);
+
+/// Read one length-prefixed frame into `payload`.
+/// @return false on clean end of input before a frame starts.
+/// @throws std::runtime_error on a truncated or oversized frame.
+bool readFrame(std::istream& in, std::string& payload);
+
+} // namespace template_insight
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace template_insight {
+
+/// Append-only store for string bytes.
+///
+/// Strings are copied into large blocks, so storing many short strings costs
+/// one allocation per block instead of one per string. Stored bytes never move
+/// (also not when the arena itself is moved) and are freed with the arena.
+class StringArena {
+public:
+    StringArena() = default;
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    /// Copy `s` into the arena and return a view of the copy.
+    std::string_view store(std::string_view s) {
+        if (s.size() > left_) {
+            if (s.size() > kBlockSize / 4) {
+                // Large strings get a block of their own; the current one stays open.
+                blocks_.push_back(std::make_unique<char[]>(s.size()));
+                std::memcpy(blocks_.back().get(), s.data(), s.size());
+                return {blocks_.back().get(), s.size()};
+            }
+            blocks_.push_back(std::make_unique<char[]>(kBlockSize));
+            next_ = blocks_.back().get();
+            left_ = kBlockSize;
+        }
+        char* stored = next_;
+        if (!s.empty()) {
+            std::memcpy(stored, s.data(), s.size());
+        }
+        next_ += s.size();
+        left_ -= s.size();
+        return {stored, s.size()};
+    }
+
+private:
+    static constexpr std::size_t kBlockSize = 16 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* next_ = nullptr;
+    std::size_t left_ = 0;
+};
+
+/// Deduplicating string store.
+///
+/// Each distinct string is stored once, in a StringArena; interning the same
+/// text again returns the same id and a view of the same storage. Views stay
+/// valid for the lifetime of the interner.
+class StringInterner {
+public:
+    using Id = std::uint32_t;
+
+    StringInterner() = default;
+    StringInterner(StringInterner&&) = default;
+    StringInterner& operator=(StringInterner&&) = default;
+
+    /// Copies re-intern every string so their views point into their own storage.
+    StringInterner(const StringInterner& other) { *this = other; }
+    StringInterner& operator=(const StringInterner& other) {
+        if (this != &other) {
+            arena_ = StringArena{};
+            strings_.clear();
+            ids_.clear();
+            for (const auto& s : other.strings_) {
+                intern(s);
+            }
+        }
+        return *this;
+    }
+
+    /// Intern `s` and return its id.
+    Id intern(std::string_view s) {
+        auto it = ids_.find(s);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        const Id id = static_cast<Id>(strings_.size());
+        const std::string_view stored = arena_.store(s);
+        strings_.push_back(stored);
+        ids_.emplace(stored, id);
+        return id;
+    }
+
+    /// Intern `s` and return a view of the stored copy.
+    std::string_view internView(std::string_view s) { return str(intern(s)); }
+
+    /// Text of a previously interned id.
+    std::string_view str(Id id) const { return strings_[id]; }
+
+    std::size_t size() const { return strings_.size(); }
+
+private:
+    StringArena arena_;
+    std::vector<std::string_view> strings_;
+    std::unordered_map<std::string_view, Id> ids_;
+};
+
+} // namespace template_insight
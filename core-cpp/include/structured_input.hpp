@@ -0,0 +1,55 @@
+#pragma once
+
+#include "diagnostic_line.hpp"
+#include "model.hpp"
+
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace template_insight {
+
+class DiagnosticsAnalyzer;
+
+/// One diagnostic of structured compiler output, together with its notes.
+struct StructuredDiagnostic {
+    struct Note {
+        std::string message;
+        std::optional<SourceLocation> location;
+    };
+
+    DiagnosticKind kind = DiagnosticKind::Error;
+    std::string message;
+    std::optional<SourceLocation> location;
+    /// Notes in the order the compiler emitted them (innermost context first).
+    std::vector<Note> notes;
+};
+
+/// Format of the compiler output given to the analyzer.
+enum class InputFormat {
+    Text,   ///< Plain clang/gcc diagnostics.
+    Sarif,  ///< SARIF 2.1.0 (clang -fdiagnostics-format=sarif).
+    GccJson ///< gcc -fdiagnostics-format=json.
+};
+
+/// Choose the input format. AnalysisOptions::compiler "sarif" or "gcc-json"
+/// selects a structured format explicitly; otherwise the format is detected
+/// from `head`, the first bytes of the input.
+InputFormat resolveInputFormat(const std::string& compiler, std::string_view head);
+
+/// Parse structured compiler output with a SAX parser (no JSON document is
+/// built) and pass every diagnostic to analyzer.addDiagnostic(). Parsing stops
+/// as soon as the analyzer stops.
+///
+/// SARIF results with level "note" and "relatedLocations" become notes of the
+/// preceding diagnostic; gcc "children" become notes of their parent.
+///
+/// @throws std::runtime_error if the input is not valid JSON.
+void feedStructuredDiagnostics(std::string_view text, InputFormat format, DiagnosticsAnalyzer& analyzer);
+
+/// Same as above, reading the JSON incrementally from a stream.
+void feedStructuredDiagnostics(std::istream& in, InputFormat format, DiagnosticsAnalyzer& analyzer);
+
+} // namespace template_insight
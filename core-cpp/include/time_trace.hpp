@@ -0,0 +1,77 @@
+#pragma once
+
+#include "config.hpp"
+#include "model.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace template_insight {
+
+class IssueCatalog;
+
+/// Compile-time costs aggregated from clang -ftime-trace files.
+///
+/// Each trace file is read with a SAX parser, one event at a time, so only the
+/// aggregates (one entry per distinct template and header) are kept in memory
+/// no matter how many or how large the files are.
+///
+/// Durations are inclusive, as clang records them: an instantiation includes
+/// the instantiations it triggers, a header includes the headers it includes.
+class TimeTraceProfile {
+public:
+    struct Cost {
+        std::uint64_t microseconds = 0;
+        /// Number of events (instantiations, or times the header was parsed).
+        std::size_t count = 0;
+        /// Number of translation units the events occurred in.
+        std::size_t translationUnits = 0;
+    };
+
+    /// Add the events of one trace file.
+    /// @return false if the file is valid JSON but not a time trace.
+    /// @throws std::runtime_error if the file cannot be read or is not valid JSON.
+    bool addFile(const std::string& path);
+
+    /// Add the aggregates of another profile (built from other files).
+    void merge(TimeTraceProfile&& other);
+
+    /// InstantiateClass / InstantiateFunction events by template.
+    const std::unordered_map<std::string, Cost>& instantiations() const { return instantiations_; }
+
+    /// Source events by header.
+    const std::unordered_map<std::string, Cost>& headers() const { return headers_; }
+
+    /// Sum of all Frontend events.
+    std::uint64_t frontendMicroseconds() const { return frontendMicroseconds_; }
+
+    /// Number of trace files added.
+    std::size_t files() const { return files_; }
+
+private:
+    class Handler;
+
+    void add(std::unordered_map<std::string, Cost>& costs, const std::string& name, std::uint64_t microseconds);
+
+    std::unordered_map<std::string, Cost> instantiations_;
+    std::unordered_map<std::string, Cost> headers_;
+    std::uint64_t frontendMicroseconds_ = 0;
+    std::size_t files_ = 0;
+};
+
+/// All *.json files below `directory` (compile_commands.json excluded),
+/// sorted by path.
+/// @throws std::runtime_error if the directory cannot be read.
+std::vector<std::string> findTimeTraceFiles(const std::string& directory);
+
+/// Aggregate `files` on AnalysisConfig::workerThreads threads and report the
+/// AnalysisConfig::profileTopN most expensive templates (EXPENSIVE_INSTANTIATION)
+/// and headers (EXPENSIVE_HEADER), most expensive first. Files that cannot be
+/// parsed are logged and skipped.
+TemplateInsightResult profileTimeTraces(const std::vector<std::string>& files,
+                                        const AnalysisConfig& config,
+                                        const IssueCatalog& catalog);
+
+} // namespace template_insight
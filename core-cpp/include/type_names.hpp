@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace template_insight {
+
+/// Settings of TypeNameTree::abbreviate().
+struct TypeNameOptions {
+    /// Template argument lists nested deeper than this are shown as "<...>".
+    std::size_t maxDepth = 64;
+
+    /// Template-ids at least this long (after elision) that occur more than
+    /// once are replaced by back-references "$1", "$2", ... defined in a
+    /// trailing "[with $1 = ...]" clause.
+    std::size_t minBackReferenceLength = 32;
+};
+
+/// Parsed template-id structure of a type spelling (or of any text containing
+/// type spellings, such as "function template specialization 'f<...>'").
+///
+/// Parsing is a single left-to-right pass that builds a flat tree: every node
+/// is a source range made of text pieces and template argument lists whose
+/// arguments are child nodes. Each node carries a hash of its canonical
+/// spelling (inline namespaces removed, default arguments elided, spacing
+/// normalized), computed from its children's hashes, so equal subtrees are
+/// recognized in constant time.
+///
+/// The tree refers to the source text; the full spelling of any node is
+/// available from its source range for as long as the source is alive.
+class TypeNameTree {
+public:
+    using NodeId = std::uint32_t;
+
+    /// Parse `source`. Returns std::nullopt if its angle brackets do not
+    /// balance, in which case the text should be used as is.
+    static std::optional<TypeNameTree> parse(std::string_view source);
+
+    /// The outermost node, covering the whole source.
+    NodeId root() const { return root_; }
+
+    std::size_t nodeCount() const { return nodes_.size(); }
+
+    /// Full, unabbreviated spelling of a node.
+    std::string_view spelling(NodeId node) const;
+
+    /// Canonical length of a node, i.e. of its spelling after elision.
+    std::size_t canonicalLength(NodeId node) const { return nodes_[node].length; }
+
+    /// Render the whole text with elision, depth truncation and back-references:
+    ///   std::__1::basic_string<char, std::__1::char_traits<char>, std::__1::allocator<char>>
+    /// becomes "std::string", and std::vector<T, std::allocator<T>> becomes
+    /// "std::vector<T>".
+    std::string abbreviate(const TypeNameOptions& options) const;
+
+private:
+    struct Node {
+        std::uint32_t begin = 0;
+        std::uint32_t end = 0;
+        std::uint32_t firstItem = 0;
+        std::uint32_t itemCount = 0;
+        std::uint64_t hash = 0;
+        std::uint64_t power = 1;
+        std::uint32_t length = 0;
+        bool templateId = false;
+    };
+
+    struct Item {
+        enum class Kind : std::uint8_t { Text, Open, Child, Close };
+        Kind kind = Kind::Text;
+        /// Open: index + 1 of the alias replacing the template-id (0 if none).
+        std::uint8_t alias = 0;
+        /// Text: source range [a, b). Open: a = name length dropped for an
+        /// alias, b = number of arguments kept. Child: a = node.
+        std::uint32_t a = 0;
+        std::uint32_t b = 0;
+    };
+
+    class Parser;
+    class Renderer;
+
+    std::string_view source_;
+    std::vector<Node> nodes_;
+    std::vector<Item> items_;
+    NodeId root_ = 0;
+};
+
+/// Abbreviate the type spellings in `text` (see TypeNameTree::abbreviate()).
+/// Returns `text` unchanged if it does not parse or would not get shorter.
+std::string abbreviateTypeNames(std::string_view text, const TypeNameOptions& options);
+
+} // namespace template_insight
@@ -0,0 +1,246 @@
+#include "analysis_cache.hpp"
+
+#include "binary_format.hpp"
+#include "content_hash.hpp"
+#include "log_prepass.hpp"
+#include "result_merger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+namespace {
+
+constexpr char kCacheMagic[] = {'T', 'I', 'C', '1'};
+
+void writeU64(std::ostream& out, std::uint64_t value) {
+    char bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+    out.write(bytes, sizeof(bytes));
+}
+
+bool readU64(std::istream& in, std::uint64_t& value) {
+    unsigned char bytes[8];
+    if (!in.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= std::uint64_t{bytes[i]} << (8 * i);
+    }
+    return true;
+}
+
+/// A run of blocks ends at the first block boundary after a line whose hash
+/// has these bits clear, once it holds kMinRunBytes, or after kMaxRunBytes
+/// regardless.
+constexpr std::uint64_t kRunCutMask = 0xff;
+constexpr std::size_t kMinRunBytes = 16 * 1024;
+constexpr std::size_t kMaxRunBytes = 256 * 1024;
+
+/// Approximate memory held by `result`, which the cache cap is measured in.
+std::size_t footprint(const CompactResult& result) {
+    std::size_t bytes = sizeof(CompactResult) + result.issues().size() * sizeof(CompactIssue);
+    for (const auto& frame : result.instantiations()) {
+        bytes += sizeof(InstantiationFrame) + frame.description.size();
+        if (frame.location) {
+            bytes += frame.location->file.size();
+        }
+    }
+    for (StringInterner::Id id = 0; id < result.internedCount(); ++id) {
+        bytes += sizeof(std::string_view) + result.interned(id).size();
+    }
+    return bytes;
+}
+
+} // namespace
+
+AnalysisCache::AnalysisCache(std::size_t maxBytes) : maxBytes_(maxBytes) {
+}
+
+std::shared_ptr<const CompactResult> AnalysisCache::find(std::uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++stats_.misses;
+        return nullptr;
+    }
+    ++stats_.hits;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->result;
+}
+
+void AnalysisCache::insert(std::uint64_t key, CompactResult result) {
+    result.stats = AnalysisStats{};
+    const std::size_t bytes = footprint(result);
+    auto shared = std::make_shared<const CompactResult>(std::move(result));
+    std::lock_guard<std::mutex> lock(mutex_);
+    insertEntry(Entry{key, std::move(shared), bytes});
+}
+
+void AnalysisCache::insertEntry(Entry entry) {
+    if (entry.bytes > maxBytes_) {
+        return;
+    }
+    auto it = index_.find(entry.key);
+    if (it != index_.end()) {
+        stats_.bytes -= it->second->bytes;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    stats_.bytes += entry.bytes;
+    lru_.push_front(std::move(entry));
+    index_[lru_.front().key] = lru_.begin();
+
+    while (stats_.bytes > maxBytes_) {
+        const Entry& victim = lru_.back();
+        stats_.bytes -= victim.bytes;
+        index_.erase(victim.key);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+    stats_.entries = lru_.size();
+}
+
+void AnalysisCache::load(const std::string& path, const std::shared_ptr<const IssueCatalog>& catalog) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        SPDLOG_INFO("No analysis cache at '{}', starting empty.", path);
+        return;
+    }
+    char magic[sizeof(kCacheMagic)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kCacheMagic)) {
+        throw std::runtime_error("AnalysisCache: '" + path + "' is not an analysis cache file");
+    }
+
+    std::vector<Entry> entries;
+    std::uint64_t key = 0;
+    std::string encoded;
+    while (readU64(in, key)) {
+        std::uint64_t size = 0;
+        if (!readU64(in, size) || size > maxBytes_) {
+            throw std::runtime_error("AnalysisCache: malformed entry in '" + path + "'");
+        }
+        encoded.resize(static_cast<std::size_t>(size));
+        if (!in.read(encoded.data(), static_cast<std::streamsize>(size))) {
+            throw std::runtime_error("AnalysisCache: truncated entry in '" + path + "'");
+        }
+        CompactResult result = CompactResult::fromResult(decodeBinaryResult(encoded), catalog);
+        const std::size_t bytes = footprint(result);
+        entries.push_back(Entry{key, std::make_shared<const CompactResult>(std::move(result)), bytes});
+    }
+
+    // Saved most recently used first; insert oldest first to restore the order.
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        insertEntry(std::move(*it));
+    }
+    SPDLOG_INFO("Loaded {} analysis cache entries ({} bytes) from '{}'.",
+                stats_.entries, stats_.bytes, path);
+}
+
+void AnalysisCache::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("AnalysisCache: failed to open '" + path + "' for writing");
+    }
+    out.write(kCacheMagic, sizeof(kCacheMagic));
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : lru_) {
+        const std::string encoded = encodeBinaryResult(entry.result->toResult());
+        writeU64(out, entry.key);
+        writeU64(out, encoded.size());
+        out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+    }
+    if (!out.flush()) {
+        throw std::runtime_error("AnalysisCache: failed to write '" + path + "'");
+    }
+}
+
+AnalysisCache::Stats AnalysisCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+CompactResult analyzeWithCache(std::string_view chunk,
+                               const DiagnosticsAnalyzer& prototype,
+                               const AnalysisConfig& config,
+                               AnalysisCache& cache) {
+    const auto started = std::chrono::steady_clock::now();
+    const std::uint64_t fingerprint = prototype.fingerprint();
+    ResultMerger merger(config.maxIssues, prototype.catalog());
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+
+    // A colored chunk is keyed and analyzed without its escape sequences, so
+    // it shares entries with the same diagnostics printed plainly.
+    AnsiStripper ansi;
+    std::string clean;
+    std::string_view text = chunk;
+    if (containsEscape(chunk)) {
+        ansi.strip(chunk, clean);
+        text = clean;
+    }
+
+    std::size_t runBegin = 0;
+    std::size_t runEnd = std::string_view::npos;
+    std::uint64_t key = fingerprint;
+    for (std::size_t begin = 0; begin < text.size();) {
+        std::size_t end = text.find('\n', begin);
+        end = end == std::string_view::npos ? text.size() : end + 1;
+        const std::uint64_t lineHash = hashBytes(text.substr(begin, end - begin));
+        key = combineHash(key, lineHash);
+        begin = end;
+
+        // Lines are only classified at the block boundary that ends a run.
+        const std::size_t runBytes = end - runBegin;
+        if (runEnd == std::string_view::npos && runBytes >= kMinRunBytes &&
+            ((lineHash & kRunCutMask) == 0 || runBytes >= kMaxRunBytes)) {
+            runEnd = DiagnosticsAnalyzer::nextBlockBoundary(text, end);
+        }
+        if (end < runEnd && end < text.size()) {
+            continue;
+        }
+
+        const std::string_view run = text.substr(runBegin, end - runBegin);
+        bool more = true;
+        if (std::shared_ptr<const CompactResult> cached = cache.find(key)) {
+            ++hits;
+            more = merger.append(*cached);
+        } else {
+            ++misses;
+            DiagnosticsAnalyzer analyzer = prototype;
+            analyzer.chargeTime(std::chrono::steady_clock::now() - started);
+            analyzer.feed(run);
+            CompactResult part = analyzer.finishCompact();
+            more = merger.append(part);
+            if (part.truncation != TruncationReason::Timeout &&
+                part.truncation != TruncationReason::Cancelled) {
+                cache.insert(key, std::move(part));
+            }
+        }
+        if (!more) {
+            break;
+        }
+        runBegin = end;
+        runEnd = std::string_view::npos;
+        key = fingerprint;
+    }
+
+    SPDLOG_DEBUG("Analysis cache: {} hits, {} misses in a chunk of {} bytes.", hits, misses, chunk.size());
+    CompactResult result = merger.finish();
+    TEMPLATE_INSIGHT_COUNT(result.stats, Counter::EscapeSequences, ansi.sequences());
+    TEMPLATE_INSIGHT_COUNT(result.stats, Counter::CacheHits, hits);
+    TEMPLATE_INSIGHT_COUNT(result.stats, Counter::CacheMisses, misses);
+    return result;
+}
+
+} // namespace template_insight
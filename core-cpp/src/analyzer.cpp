@@ -0,0 +1,623 @@
+#include "analyzer.hpp"
+
+#include "content_hash.hpp"
+#include "structured_input.hpp"
+#include "type_names.hpp"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+namespace {
+
+/// Input indexed at once by feed(); small enough to stay in cache.
+constexpr std::size_t kLineIndexWindow = 64 * 1024;
+
+std::string_view trimLineEnd(std::string_view line) {
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+} // namespace
+
+DiagnosticsAnalyzer::DiagnosticsAnalyzer(const AnalysisOptions& options, const AppConfig& config)
+    : DiagnosticsAnalyzer(options, config, IssueCatalog::load(config.analysis)) {
+}
+
+DiagnosticsAnalyzer::DiagnosticsAnalyzer(const AnalysisOptions& options,
+                                         const AppConfig& config,
+                                         std::shared_ptr<const IssueCatalog> catalog)
+    : options_(options),
+      config_(config),
+      catalog_(std::move(catalog)),
+      dialect_(dialectFromCompiler(options.compiler)),
+      compact_(catalog_) {
+    SPDLOG_DEBUG("Logger config: file='{}', max_size={}, max_files={}",
+                 config.logger.filePath,
+                 config.logger.maxFileSize,
+                 config.logger.maxFiles);
+
+    if (config_.analysis.timeoutMs > 0) {
+        timeLeft_ = std::chrono::milliseconds(config_.analysis.timeoutMs);
+    }
+}
+
+/// Charges the duration of a public call to the analyzer's time limit.
+class DiagnosticsAnalyzer::BusyScope {
+public:
+    explicit BusyScope(DiagnosticsAnalyzer& analyzer) : analyzer_(analyzer) {
+        if (analyzer_.timeLeft_) {
+            analyzer_.busySince_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~BusyScope() {
+        if (analyzer_.timeLeft_) {
+            analyzer_.chargeTime(std::chrono::steady_clock::now() - analyzer_.busySince_);
+        }
+    }
+
+    BusyScope(const BusyScope&) = delete;
+    BusyScope& operator=(const BusyScope&) = delete;
+
+private:
+    DiagnosticsAnalyzer& analyzer_;
+};
+
+void DiagnosticsAnalyzer::chargeTime(std::chrono::steady_clock::duration elapsed) {
+    if (timeLeft_) {
+        *timeLeft_ -= elapsed;
+    }
+}
+
+std::uint64_t DiagnosticsAnalyzer::fingerprint() const {
+    std::uint64_t h = catalog_->fingerprint();
+    h = combineHash(h, hashBytes(options_.compiler));
+    h = combineHash(h, static_cast<std::uint64_t>(config_.analysis.maxTemplateDepth));
+    h = combineHash(h, config_.analysis.maxIssues);
+    h = combineHash(h, config_.analysis.typeNameAbbreviationLength);
+    return h;
+}
+
+template <class Policy>
+DiagnosticsAnalyzer::LineKind DiagnosticsAnalyzer::classifyLine(std::string_view line) {
+    line = trimLineEnd(line);
+
+    if (line.empty() || line.front() == ' ' || line.front() == '\t') {
+        // Source snippets, carets and gcc's "                 from a.h:3," lines.
+        return LineKind::Continuation;
+    }
+
+    if (auto diag = parseDiagnosticLine(line)) {
+        const bool isNote = diag->kind == DiagnosticKind::Note || diag->kind == DiagnosticKind::Remark;
+        return isNote ? LineKind::Continuation : LineKind::Header;
+    }
+
+    return Policy::isContextLine(line) ? LineKind::Context : LineKind::Other;
+}
+
+std::size_t DiagnosticsAnalyzer::nextBlockBoundary(std::string_view text, std::size_t from) {
+    if (from == 0) {
+        return 0;
+    }
+    if (from >= text.size()) {
+        return text.size();
+    }
+    // First line starting at or after `from`.
+    std::size_t lineStart = from;
+    if (text[from - 1] != '\n') {
+        const auto nl = text.find('\n', from);
+        if (nl == std::string_view::npos) {
+            return text.size();
+        }
+        lineStart = nl + 1;
+    }
+
+    // Same decision as onLine(): a header, context or other line opens a new
+    // block unless it continues a gcc prelude. The generic dialect sees a
+    // superset of the context lines of the others, so its boundaries hold
+    // for every dialect. Colored lines are judged without their escape
+    // sequences; stripping never removes a newline, so offsets in `text`
+    // stay line starts of the stripped text too.
+    std::string clean;
+    auto classify = [&clean](std::string_view line) {
+        if (containsEscape(line)) {
+            AnsiStripper().strip(line, clean);
+            line = clean;
+        }
+        return classifyLine<GenericDialect>(line);
+    };
+    std::size_t prevStart = 0;
+    if (lineStart >= 2) {
+        const auto nl = text.rfind('\n', lineStart - 2);
+        prevStart = nl == std::string_view::npos ? 0 : nl + 1;
+    }
+    LineKind prevKind = classify(text.substr(prevStart, lineStart - prevStart));
+    while (lineStart < text.size()) {
+        auto nl = text.find('\n', lineStart);
+        nl = nl == std::string_view::npos ? text.size() : nl + 1;
+        const LineKind kind = classify(text.substr(lineStart, nl - lineStart));
+        if (kind != LineKind::Continuation && prevKind != LineKind::Context) {
+            return lineStart;
+        }
+        prevKind = kind;
+        lineStart = nl;
+    }
+    return text.size();
+}
+
+void DiagnosticsAnalyzer::resolveDialect(std::string_view input) {
+    if (dialect_) {
+        return;
+    }
+    // Only the new input, plus enough of the old for a phrase it completes.
+    const std::size_t seen = dialectProbe_.size();
+    std::string clean;
+    dialectProbe_.append(strippedPrefix(input, kDialectProbeBytes - seen, clean));
+    dialect_ = detectDialect(std::string_view(dialectProbe_).substr(seen > 64 ? seen - 64 : 0));
+    if (!dialect_ && dialectProbe_.size() < kDialectProbeBytes) {
+        return;
+    }
+    dialect_ = dialect_.value_or(Dialect::Generic);
+    SPDLOG_DEBUG("Parsing diagnostics as {} output.", dialectName(*dialect_));
+    std::string().swap(dialectProbe_);
+}
+
+void DiagnosticsAnalyzer::feed(std::string_view chunk) {
+    const BusyScope busy(*this);
+    if (stopped()) {
+        return;
+    }
+    TEMPLATE_INSIGHT_TIME_PHASE_EXCLUDING(stats_, Phase::Scan, Phase::Parse);
+    bytesFed_ += chunk.size();
+    if (ansi_.inSequence() || containsEscape(chunk)) {
+        const std::size_t before = ansi_.sequences();
+        ansi_.strip(chunk, clean_);
+        TEMPLATE_INSIGHT_COUNT(stats_, Counter::EscapeSequences, ansi_.sequences() - before);
+        chunk = clean_;
+    }
+    resolveDialect(chunk);
+    std::size_t pos = 0;
+
+    // Complete the line left unterminated by the previous chunk.
+    if (!partialLine_.empty()) {
+        const auto nl = chunk.find('\n');
+        if (nl == std::string_view::npos) {
+            partialLine_.append(chunk);
+            return;
+        }
+        partialLine_.append(chunk.substr(0, nl + 1));
+        onPartialLine();
+        pos = nl + 1;
+    }
+
+    withDialect(dialect_.value_or(Dialect::Generic),
+                [&](auto policy) { splitLines<decltype(policy)>(chunk, pos); });
+
+    if (stopped()) {
+        // Nothing fed after the stop point is analyzed, including the open block.
+        openBegin_ = openEnd_ = nullptr;
+        carry_.clear();
+        partialLine_.clear();
+    } else if (openBegin_ != nullptr) {
+        // The chunk is about to go away: keep our own copy of the open block.
+        carry_.assign(openBegin_, openEnd_);
+        openBegin_ = openEnd_ = nullptr;
+    }
+}
+
+/// Split `chunk` from `pos` into lines; an unterminated last line is kept
+/// in partialLine_.
+template <class Policy>
+void DiagnosticsAnalyzer::splitLines(std::string_view chunk, std::size_t pos) {
+    while (pos < chunk.size() && !stopped()) {
+        const std::size_t windowBegin = pos;
+        const std::string_view window = chunk.substr(windowBegin, kLineIndexWindow);
+        lineEnds_.clear();
+        indexLineEnds(window, lineEnds_);
+        if (lineEnds_.empty()) {
+            // A line longer than the window, or the unterminated last line.
+            const auto nl = chunk.find('\n', windowBegin + window.size());
+            if (nl == std::string_view::npos) {
+                partialLine_.assign(chunk.substr(pos));
+                break;
+            }
+            onLine<Policy>(chunk.substr(pos, nl + 1 - pos), true);
+            pos = nl + 1;
+            continue;
+        }
+        // The part of the window after its last line end is indexed again
+        // as the start of the next window.
+        for (const std::uint32_t end : lineEnds_) {
+            if (stopped()) {
+                break;
+            }
+            const std::size_t next = windowBegin + end + 1;
+            onLine<Policy>(chunk.substr(pos, next - pos), true);
+            pos = next;
+        }
+    }
+}
+
+/// Analyze the line completed in partialLine_ and clear it.
+void DiagnosticsAnalyzer::onPartialLine() {
+    withDialect(dialect_.value_or(Dialect::Generic),
+                [&](auto policy) { onLine<decltype(policy)>(partialLine_, false); });
+    partialLine_.clear();
+}
+
+void DiagnosticsAnalyzer::flushOpenBlock() {
+    const BusyScope busy(*this);
+    if (stopped() || !partialLine_.empty()) {
+        return;
+    }
+    TEMPLATE_INSIGHT_TIME_PHASE_EXCLUDING(stats_, Phase::Scan, Phase::Parse);
+    closeBlock();
+    // Whatever comes next starts a new block, even after a gcc prelude line.
+    prevKind_ = LineKind::Other;
+}
+
+void DiagnosticsAnalyzer::restartInput() {
+    const BusyScope busy(*this);
+    if (stopped()) {
+        return;
+    }
+    TEMPLATE_INSIGHT_TIME_PHASE_EXCLUDING(stats_, Phase::Scan, Phase::Parse);
+    if (!partialLine_.empty()) {
+        onPartialLine();
+    }
+    if (!stopped()) {
+        closeBlock();
+    }
+    prevKind_ = LineKind::Other;
+    ansi_.reset();
+}
+
+/// Poll the deadline and the cancellation flag every few thousand lines.
+bool DiagnosticsAnalyzer::checkStop() {
+    constexpr std::size_t kLinesPerCheck = 4096;
+    if (stopped()) {
+        return true;
+    }
+    if (linesUntilCheck_ > 0) {
+        --linesUntilCheck_;
+        return false;
+    }
+    linesUntilCheck_ = kLinesPerCheck;
+
+    if (cancelFlag_ != nullptr && cancelFlag_->load(std::memory_order_relaxed)) {
+        SPDLOG_WARN("Analysis cancelled after {} bytes.", bytesFed_);
+        stopReason_ = TruncationReason::Cancelled;
+    } else if (timeLeft_ && std::chrono::steady_clock::now() - busySince_ >= *timeLeft_) {
+        SPDLOG_WARN("Analysis timeout ({} ms) reached. Returning partial result.", config_.analysis.timeoutMs);
+        stopReason_ = TruncationReason::Timeout;
+    }
+    return stopped();
+}
+
+template <class Policy>
+void DiagnosticsAnalyzer::onLine(std::string_view line, bool inChunk) {
+    if (checkStop()) {
+        return;
+    }
+    TEMPLATE_INSIGHT_COUNT(stats_, Counter::Lines, 1);
+    const LineKind kind = classifyLine<Policy>(line);
+    const bool blockOpen = openBegin_ != nullptr || !carry_.empty();
+
+    switch (kind) {
+        case LineKind::Header:
+            // A header right after a gcc prelude belongs to that prelude.
+            if (blockOpen && prevKind_ == LineKind::Context) {
+                extendBlock(line, inChunk);
+            } else {
+                openBlock(line, inChunk);
+            }
+            break;
+        case LineKind::Context:
+            if (blockOpen && prevKind_ == LineKind::Context) {
+                extendBlock(line, inChunk);
+            } else {
+                openBlock(line, inChunk);
+            }
+            break;
+        case LineKind::Continuation:
+            if (blockOpen) {
+                extendBlock(line, inChunk);
+            } else {
+                analyzeBlock(line);
+            }
+            break;
+        case LineKind::Other:
+            closeBlock();
+            analyzeBlock(line);
+            break;
+    }
+
+    prevKind_ = kind;
+}
+
+void DiagnosticsAnalyzer::openBlock(std::string_view line, bool inChunk) {
+    closeBlock();
+    if (inChunk) {
+        openBegin_ = line.data();
+        openEnd_ = line.data() + line.size();
+    } else {
+        carry_.assign(line);
+    }
+}
+
+void DiagnosticsAnalyzer::extendBlock(std::string_view line, bool inChunk) {
+    if (openBegin_ != nullptr && inChunk && line.data() == openEnd_) {
+        openEnd_ = line.data() + line.size();
+        return;
+    }
+    if (openBegin_ != nullptr) {
+        carry_.assign(openBegin_, openEnd_);
+        openBegin_ = openEnd_ = nullptr;
+    }
+    carry_.append(line);
+}
+
+void DiagnosticsAnalyzer::closeBlock() {
+    if (openBegin_ != nullptr) {
+        analyzeBlock(std::string_view(openBegin_, static_cast<std::size_t>(openEnd_ - openBegin_)));
+        openBegin_ = openEnd_ = nullptr;
+    } else if (!carry_.empty()) {
+        analyzeBlock(carry_);
+        carry_.clear();
+    }
+}
+
+/// Turn one diagnostic block into (at most) one issue.
+///
+/// The issue code comes from the first pattern match in the header message
+/// ("error: ..."), or else from the first match anywhere in the block (notes,
+/// prelude). The location is taken from the header.
+void DiagnosticsAnalyzer::analyzeBlock(std::string_view block) {
+    if (stopped()) {
+        return;
+    }
+    TEMPLATE_INSIGHT_TIME_PHASE(stats_, Phase::Parse);
+    TEMPLATE_INSIGHT_COUNT(stats_, Counter::Blocks, 1);
+    // Find the header line of the block.
+    std::optional<DiagnosticLine> header;
+    std::size_t headerBegin = 0;
+    std::size_t headerEnd = 0;
+    for (std::size_t pos = 0; pos < block.size();) {
+        std::size_t nl = block.find('\n', pos);
+        nl = nl == std::string_view::npos ? block.size() : nl + 1;
+        auto parsed = parseDiagnosticLine(block.substr(pos, nl - pos));
+        if (parsed && parsed->kind != DiagnosticKind::Note && parsed->kind != DiagnosticKind::Remark) {
+            header = parsed;
+            headerBegin = pos;
+            headerEnd = nl;
+            break;
+        }
+        pos = nl;
+    }
+
+    // Single pass over the block: prefer a match inside the header line.
+    const PatternMatcher& matcher = catalog_->matcher();
+    std::optional<std::uint32_t> chosen;
+    std::optional<std::uint32_t> firstAny;
+    matcher.scan(block, [&](std::size_t offset, std::uint32_t index) {
+        ++matchCount_;
+        if (header && offset >= headerBegin && offset < headerEnd) {
+            chosen = index;
+            return false;
+        }
+        if (!firstAny) {
+            firstAny = index;
+        }
+        // Matches are reported in order of their end, so once we are past the
+        // header nothing can match inside it any more.
+        return header.has_value() && offset < headerEnd;
+    });
+    if (!chosen) {
+        chosen = firstAny;
+    }
+    if (!chosen) {
+        TEMPLATE_INSIGHT_COUNT(stats_, Counter::UnclassifiedBlocks, 1);
+        return;
+    }
+    if (!admitIssue()) {
+        return;
+    }
+
+    CompactIssue issue = makeIssue(catalog_->kindOfPattern(*chosen));
+    if (header) {
+        if (header->kind == DiagnosticKind::Warning) {
+            issue.severity = Severity::Warning;
+        }
+        if (header->line > 0) {
+            // Interning keeps one copy of each path while the log is scanned.
+            issue.file = compact_.internFile(header->file);
+            issue.line = header->line;
+            issue.column = header->column;
+        }
+    }
+    const std::size_t skippedFrames = withDialect(dialect_.value_or(Dialect::Generic), [&](auto policy) {
+        return parseInstantiationBacktrace<decltype(policy)>(block, frameScratch_);
+    });
+    setInstantiation(issue, skippedFrames);
+
+    SPDLOG_DEBUG("Detected pattern '{}' ({}) in diagnostic: '{}'",
+                 matcher.pattern(*chosen).text, compact_.code(issue),
+                 trimLineEnd(block.substr(headerBegin, headerEnd - headerBegin)));
+    emitIssue(issue);
+}
+
+void DiagnosticsAnalyzer::addDiagnostic(const StructuredDiagnostic& diagnostic) {
+    const BusyScope busy(*this);
+    if (checkStop() || diagnostic.kind == DiagnosticKind::Note || diagnostic.kind == DiagnosticKind::Remark) {
+        return;
+    }
+    TEMPLATE_INSIGHT_TIME_PHASE(stats_, Phase::Parse);
+    TEMPLATE_INSIGHT_COUNT(stats_, Counter::Blocks, 1);
+
+    // Same rule as for text blocks: the message itself first, then the notes.
+    const PatternMatcher& matcher = catalog_->matcher();
+    std::optional<std::uint32_t> chosen;
+    auto firstMatch = [&](std::string_view text) {
+        matcher.scan(text, [&](std::size_t, std::uint32_t index) {
+            ++matchCount_;
+            chosen = index;
+            return false;
+        });
+        return chosen.has_value();
+    };
+    if (!firstMatch(diagnostic.message)) {
+        for (const auto& note : diagnostic.notes) {
+            if (firstMatch(note.message)) {
+                break;
+            }
+        }
+    }
+    if (!chosen) {
+        TEMPLATE_INSIGHT_COUNT(stats_, Counter::UnclassifiedBlocks, 1);
+        return;
+    }
+    if (!admitIssue()) {
+        return;
+    }
+
+    CompactIssue issue = makeIssue(catalog_->kindOfPattern(*chosen));
+    if (diagnostic.kind == DiagnosticKind::Warning) {
+        issue.severity = Severity::Warning;
+    }
+    if (diagnostic.location) {
+        issue.file = compact_.internFile(diagnostic.location->file);
+        issue.line = diagnostic.location->line;
+        issue.column = diagnostic.location->column;
+    }
+
+    BacktraceNoteParser backtrace(frameScratch_);
+    for (const auto& note : diagnostic.notes) {
+        if (note.location) {
+            backtrace.note(note.message, note.location->file, note.location->line, note.location->column);
+        } else {
+            backtrace.note(note.message, {}, 0, 0);
+        }
+    }
+    setInstantiation(issue, backtrace.skipped());
+
+    SPDLOG_DEBUG("Detected pattern '{}' ({}) in structured diagnostic: '{}'",
+                 matcher.pattern(*chosen).text, compact_.code(issue), diagnostic.message);
+    emitIssue(issue);
+}
+
+bool DiagnosticsAnalyzer::admitIssue() {
+    if (issueCount_ >= config_.analysis.maxIssues) {
+        // One issue too many: the result is known to be incomplete, stop scanning.
+        SPDLOG_INFO("Reached max_issues limit ({}). Stopping analysis.", config_.analysis.maxIssues);
+        stopReason_ = TruncationReason::MaxIssues;
+        return false;
+    }
+    return true;
+}
+
+/// Build an issue of the given kind with the kind's default severity.
+CompactIssue DiagnosticsAnalyzer::makeIssue(IssueKindId kindId) const {
+    CompactIssue issue;
+    issue.kind = kindId;
+    issue.severity = catalog_->kind(kindId).defaultSeverity;
+    return issue;
+}
+
+/// Insert the backtrace in frameScratch_ into the instantiation tree.
+void DiagnosticsAnalyzer::setInstantiation(CompactIssue& issue, std::size_t skippedFrames) {
+    const std::size_t abbreviateOver = config_.analysis.typeNameAbbreviationLength;
+    if (abbreviateOver > 0) {
+        // Reserved up front: the frames keep views of these strings.
+        descriptionScratch_.clear();
+        descriptionScratch_.reserve(frameScratch_.size());
+        TypeNameOptions options;
+        options.maxDepth = static_cast<std::size_t>(std::max(config_.analysis.maxTemplateDepth, 0));
+        for (BacktraceFrame& frame : frameScratch_) {
+            if (frame.description.size() > abbreviateOver) {
+                descriptionScratch_.push_back(abbreviateTypeNames(frame.description, options));
+                frame.description = descriptionScratch_.back();
+            }
+        }
+    }
+
+    std::size_t omitted = 0;
+    const std::optional<std::size_t> frame =
+        instantiations_.insert(frameScratch_, config_.analysis.maxTemplateDepth, omitted);
+    if (frame) {
+        issue.instantiation = static_cast<std::uint32_t>(*frame);
+    }
+    issue.omittedFrames = static_cast<std::uint32_t>(omitted + skippedFrames);
+}
+
+void DiagnosticsAnalyzer::setIssueSink(IssueSink sink) {
+    if (!sink) {
+        issueSink_ = nullptr;
+        return;
+    }
+    issueSink_ = [sink = std::move(sink)](const CompactResult& result, const CompactIssue& issue,
+                                          const std::vector<InstantiationFrame>& frames) {
+        sink(result.toIssue(issue), frames);
+    };
+}
+
+void DiagnosticsAnalyzer::emitIssue(const CompactIssue& issue) {
+    ++issueCount_;
+    if (issueSink_) {
+        issueSink_(compact_, issue, instantiations_.frames());
+    } else {
+        compact_.add(issue);
+    }
+}
+
+TemplateInsightResult DiagnosticsAnalyzer::finish() {
+    return finishCompact().toResult();
+}
+
+CompactResult DiagnosticsAnalyzer::finishCompact() {
+    const BusyScope busy(*this);
+    {
+        TEMPLATE_INSIGHT_TIME_PHASE_EXCLUDING(stats_, Phase::Scan, Phase::Parse);
+        if (!partialLine_.empty()) {
+            onPartialLine();
+        }
+        if (!stopped()) {
+            closeBlock();
+        }
+        openBegin_ = openEnd_ = nullptr;
+        carry_.clear();
+    }
+
+    SPDLOG_DEBUG("Pattern matches in diagnostics: {}", matchCount_);
+
+    // Disabled codes never reach compact_ (see the matcher) and scanning
+    // stops at the first issue past maxIssues.
+    CompactResult result = std::move(compact_);
+    compact_ = CompactResult(catalog_);
+    result.truncation = stopReason_;
+    result.instantiations() = instantiations_.take();
+    TEMPLATE_INSIGHT_COUNT(stats_, Counter::BytesScanned, bytesFed_);
+    TEMPLATE_INSIGHT_COUNT(stats_, Counter::PatternMatches, matchCount_);
+    TEMPLATE_INSIGHT_COUNT(stats_, Counter::Issues, issueCount_);
+    result.stats = std::move(stats_);
+    stats_ = AnalysisStats{};
+    SPDLOG_DEBUG("Instantiation frames recorded: {}", result.instantiations().size());
+
+    // Debug only: parallel chunks, build jobs and batch units each finish
+    // an analyzer of their own.
+    SPDLOG_DEBUG("Diagnostics analysis complete. Bytes analyzed: {}, issues found: {}",
+                 bytesFed_, result.issues().size());
+    for ([[maybe_unused]] const auto& issue : result.issues()) {
+        SPDLOG_DEBUG("Issue: code='{}', category='{}', severity='{}'",
+                     result.code(issue),
+                     result.category(issue),
+                     severityToString(issue.severity));
+    }
+    return result;
+}
+
+} // namespace template_insight
@@ -1,180 +1,337 @@
 #include "api.hpp"
 
-#include <sstream>
+#include <algorithm>
+#include <istream>
+#include <optional>
+#include <streambuf>
+#include <thread>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
-#include "issues.hpp"
+#include "analyzer.hpp"
+#include "build_output.hpp"
+#include "compressed_input.hpp"
+#include "dialect.hpp"
+#include "json_writer.hpp"
+#include "log_prepass.hpp"
+#include "structured_input.hpp"
 
 namespace template_insight {
 
 namespace {
 
-std::string jsonEscape(const std::string& s) {
-    std::string out;
-    out.reserve(s.size() + 8);
-    for (char c : s) {
-        switch (c) {
-            case '\\': out += "\\\\"; break;
-            case '"':  out += "\\\""; break;
-            case '\n': out += "\\n";  break;
-            case '\r': out += "\\r";  break;
-            case '\t': out += "\\t";  break;
-            default:   out += c;      break;
+/// Read size used by analyzeDiagnosticsStream().
+constexpr std::size_t kStreamChunkSize = 64 * 1024;
+
+/// Number of leading bytes inspected to detect the input format.
+constexpr std::size_t kFormatProbeSize = 4096;
+
+/// Run `analyze` and add its run time to the result's statistics as a span.
+template <typename Fn>
+CompactResult traced(const char* span, Fn&& analyze) {
+    AnalysisStats stats;
+    std::optional<CompactResult> result;
+    {
+        TEMPLATE_INSIGHT_TRACE_SPAN(stats, span);
+        result.emplace(analyze());
+    }
+    result->stats.merge(stats);
+    return std::move(*result);
+}
+
+/// Stream buffer that yields an already read chunk and then the rest of a
+/// stream, so format detection does not consume input.
+class ChainedStreamBuf : public std::streambuf {
+public:
+    ChainedStreamBuf(std::vector<char> head, std::size_t headSize, std::istream& rest)
+        : buffer_(std::move(head)), rest_(rest) {
+        setg(buffer_.data(), buffer_.data(), buffer_.data() + headSize);
+    }
+
+protected:
+    int_type underflow() override {
+        rest_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        const auto got = static_cast<std::size_t>(rest_.gcount());
+        if (got == 0) {
+            return traits_type::eof();
         }
+        setg(buffer_.data(), buffer_.data(), buffer_.data() + got);
+        return traits_type::to_int_type(buffer_[0]);
     }
-    return out;
+
+private:
+    std::vector<char> buffer_;
+    std::istream& rest_;
+};
+
+unsigned analysisWorkers(const AnalysisConfig& config) {
+    return config.workerThreads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : config.workerThreads;
 }
 
-/// A tiny helper used in the stub implementation to demonstrate
-/// how you could detect a specific kind of template-related error.
-///
-/// Now it takes IssueRegistry so we can populate the issue from metadata.
-TemplateInsightResult analyzeSimpleNoMember(const std::string& logText, const IssueRegistry& registry) {
-    TemplateInsightResult result;
-
-    const std::string needle = "no member";
-    auto pos = logText.find(needle);
-    if (pos != std::string::npos) {
-        SPDLOG_DEBUG("Detected substring '{}' at position {} in diagnostics.", needle, pos);
-
-        TemplateIssue issue;
-        issue.code = IssueCodes::NO_MEMBER;
-
-        // Try to get metadata from the registry.
-        if (auto kind = registry.find(issue.code)) {
-            issue.category        = kind->category;
-            issue.severity        = kind->defaultSeverity;
-            issue.shortMessage    = kind->defaultShortMessage;
-            issue.detailedMessage = kind->defaultDetailedMessage;
-        } else {
-            // Fallback hard-coded defaults if registry does not know this code.
-            issue.category = "MemberAccess";
-            issue.severity = Severity::Error;
-            issue.shortMessage =
-                "Detected 'no member' error in diagnostics.";
-            issue.detailedMessage =
-                "The compiler reported that a type does not have a required member.\n"
-                "This is often caused by using a type that does not meet template "
-                "requirements (e.g., passing an int where a container is expected).";
+/// Pass the issues of a result that was analyzed without a sink to `sink`.
+CompactResult passToSink(CompactResult result, const CompactIssueSink& sink) {
+    if (sink) {
+        for (const auto& issue : result.issues()) {
+            sink(result, issue, result.instantiations());
         }
+        result.clearIssues();
+    }
+    return result;
+}
 
-        issue.location = std::nullopt;
-        result.issues.push_back(std::move(issue));
-    } else {
-        SPDLOG_DEBUG("No 'no member' error pattern found in diagnostics.");
+/// `sink` counting the issues it passes on, for the completion message.
+CompactIssueSink countingSink(const CompactIssueSink& sink, std::size_t& count) {
+    if (!sink) {
+        return {};
     }
+    return [&sink, &count](const CompactResult& result, const CompactIssue& issue,
+                           const std::vector<InstantiationFrame>& frames) {
+        ++count;
+        sink(result, issue, frames);
+    };
+}
 
-    return result;
+/// Compact sink passing the issues on to `sink` in the public representation.
+CompactIssueSink materializingSink(const IssueSink& sink) {
+    if (!sink) {
+        return {};
+    }
+    return [&sink](const CompactResult& result, const CompactIssue& issue,
+                   const std::vector<InstantiationFrame>& frames) {
+        sink(result.toIssue(issue), frames);
+    };
 }
 
-std::string severityToString(Severity s) {
-    switch (s) {
-        case Severity::Info:    return "info";
-        case Severity::Warning: return "warning";
-        case Severity::Error:   return "error";
+/// `options` with an "auto" compiler replaced by the dialect detected in
+/// `head` (see detectDialect()), ignoring escape sequences.
+AnalysisOptions resolveCompiler(const AnalysisOptions& options, std::string_view head) {
+    if (dialectFromCompiler(options.compiler)) {
+        return options;
     }
-    return "unknown";
+    std::string clean;
+    AnalysisOptions resolved = options;
+    resolved.compiler = dialectName(
+        detectDialect(strippedPrefix(head, kDialectProbeBytes, clean)).value_or(Dialect::Generic));
+    SPDLOG_DEBUG("Parsing diagnostics as {} output.", resolved.compiler);
+    return resolved;
 }
 
-/// Utility: check if an issue code is enabled in the analysis config.
-/// If enabledIssueCodes is empty, all codes are allowed.
-bool isIssueCodeEnabled(const std::string& code, const AnalysisConfig& cfg) {
-    if (cfg.enabledIssueCodes.empty()) {
-        return true;
+/// Feed `text` to `consumer` (an analyzer or BuildOutputAnalyzer). Colored
+/// text goes in windows, so it is stripped a window at a time instead of
+/// being copied whole.
+template <class Consumer>
+void feedText(Consumer& consumer, std::string_view text) {
+    const std::size_t window = containsEscape(text) ? kStreamChunkSize : text.size();
+    for (std::size_t pos = 0; pos < text.size(); pos += window) {
+        consumer.feed(text.substr(pos, window));
     }
-    return std::find(cfg.enabledIssueCodes.begin(),
-        cfg.enabledIssueCodes.end(),
-        code) != cfg.enabledIssueCodes.end();
 }
 
-} // namespace
+/// Stream buffer over text that is only read.
+class ViewStreamBuf : public std::streambuf {
+public:
+    explicit ViewStreamBuf(std::string_view text) {
+        char* begin = const_cast<char*>(text.data());
+        setg(begin, begin, begin + text.size());
+    }
+};
 
-TemplateInsightResult analyzeDiagnostics(
-    const std::string& logText,
-    const AnalysisOptions& options,
-    const AppConfig& config
-) {
-    SPDLOG_INFO("Starting diagnostics analysis. Compiler: {}, input size: {} bytes",
-                options.compiler, logText.size());
-    SPDLOG_DEBUG("Logger config: file='{}', max_size={}, max_files={}",
-                 config.logger.filePath,
-                 config.logger.maxFileSize,
-                 config.logger.maxFiles);
-    // Initialize issue registry.
-    IssueRegistry registry;
-    if (!config.analysis.issueKindsFile.empty()) {
-        try {
-            registry.loadFromJsonFile(config.analysis.issueKindsFile);
-            SPDLOG_INFO("Loaded issue kinds from '{}'", config.analysis.issueKindsFile);
-        } catch (const std::exception& ex) {
-            SPDLOG_WARN("Failed to load issue kinds file '{}': {}. Falling back to built-in defaults.",
-                        config.analysis.issueKindsFile, ex.what());
-        }
-    } else {
-        SPDLOG_INFO("No issue_kinds_file specified. Using built-in issue defaults.");
+CompactResult analyzeStream(std::istream& in,
+                            const AnalysisOptions& options,
+                            const AppConfig& config,
+                            std::shared_ptr<const IssueCatalog> catalog,
+                            const CompactIssueSink& sink);
+
+/// Analysis of an in-memory log (text or structured), sequential, parallel,
+/// cached or per build job. Compressed logs are streamed through a
+/// decompressing reader instead (see DecompressingStreamBuf).
+CompactResult analyzeText(std::string_view logText,
+                          const AnalysisOptions& options,
+                          const AppConfig& config,
+                          std::shared_ptr<const IssueCatalog> catalog,
+                          const CompactIssueSink& sink,
+                          AnalysisCache* cache) {
+    if (detectCompression(logText.substr(0, 4)) != Compression::None) {
+        ViewStreamBuf view(logText);
+        std::istream compressed(&view);
+        return analyzeStream(compressed, options, config, std::move(catalog), sink);
     }
 
-    // Here we eventually will run multiple checks; for now only the simple stub.
-    TemplateInsightResult rawResult = analyzeSimpleNoMember(logText, registry);
-    TemplateInsightResult filteredResult;
+    const InputFormat format = resolveInputFormat(options.compiler, logText.substr(0, kFormatProbeSize));
+    if (format != InputFormat::Text) {
+        DiagnosticsAnalyzer analyzer(options, config, catalog);
+        analyzer.setCompactIssueSink(sink);
+        feedStructuredDiagnostics(logText, format, analyzer);
+        return analyzer.finishCompact();
+    }
+
+    // Colored logs are not copied: block boundaries are found in the raw
+    // text, and each chunk, block or job is stripped where it is analyzed.
+    // Parallel chunks and build jobs all parse the same dialect.
+    const AnalysisOptions resolved = resolveCompiler(options, logText);
+    DiagnosticsAnalyzer analyzer(resolved, config, catalog);
+    const unsigned workers = analysisWorkers(config.analysis);
+    if (config.analysis.demultiplexBuildOutput) {
+        BuildOutputAnalyzer build(resolved, config, std::move(catalog), workers);
+        feedText(build, logText);
+        return passToSink(build.finishCompact(), sink);
+    }
+    const bool parallel = workers > 1 && logText.size() >= 2 * config.analysis.parallelChunkBytes;
+    if (cache != nullptr || parallel) {
+        return passToSink(analyzeInParallel(logText, analyzer, config.analysis, workers, cache), sink);
+    }
+
+    analyzer.setCompactIssueSink(sink);
+    feedText(analyzer, logText);
+    return analyzer.finishCompact();
+}
+
+/// Analysis of a stream, fed to one analyzer chunk by chunk; compressed
+/// streams are decompressed on a background thread.
+CompactResult analyzeStream(std::istream& in,
+                            const AnalysisOptions& options,
+                            const AppConfig& config,
+                            std::shared_ptr<const IssueCatalog> catalog,
+                            const CompactIssueSink& sink) {
+    std::vector<char> buffer(kStreamChunkSize);
+    in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    std::size_t got = static_cast<std::size_t>(in.gcount());
+
+    const Compression compression = detectCompression(std::string_view(buffer.data(), got));
+    if (compression != Compression::None) {
+        SPDLOG_INFO("Decompressing {} input on a background thread.", compressionName(compression));
+        ChainedStreamBuf chained(std::move(buffer), got, in);
+        std::istream compressed(&chained);
+        DecompressingStreamBuf decompressed(compressed, compression);
+        std::istream plain(&decompressed);
+        plain.exceptions(std::ios::badbit);
+        return analyzeStream(plain, options, config, std::move(catalog), sink);
+    }
 
-    // Apply basic filtering based on enabled issue codes and maxIssues.
-    for (const auto& issue : rawResult.issues) {
-        if (!isIssueCodeEnabled(issue.code, config.analysis)) {
-            SPDLOG_DEBUG("Skipping issue with code '{}' due to analysis.enabledIssueCodes filter.", issue.code);
-            continue;
+    const InputFormat format = resolveInputFormat(
+        options.compiler, std::string_view(buffer.data(), std::min(got, kFormatProbeSize)));
+    if (format != InputFormat::Text) {
+        DiagnosticsAnalyzer analyzer(options, config, catalog);
+        analyzer.setCompactIssueSink(sink);
+        ChainedStreamBuf chained(std::move(buffer), got, in);
+        std::istream structured(&chained);
+        feedStructuredDiagnostics(structured, format, analyzer);
+        return analyzer.finishCompact();
+    }
+
+    const AnalysisOptions resolved = resolveCompiler(options, std::string_view(buffer.data(), got));
+    if (config.analysis.demultiplexBuildOutput) {
+        BuildOutputAnalyzer build(resolved, config, std::move(catalog), analysisWorkers(config.analysis));
+        while (got > 0) {
+            build.feed(std::string_view(buffer.data(), got));
+            if (!in) {
+                break;
+            }
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            got = static_cast<std::size_t>(in.gcount());
         }
+        return passToSink(build.finishCompact(), sink);
+    }
 
-        filteredResult.issues.push_back(issue);
-        if (filteredResult.issues.size() >= config.analysis.maxIssues) {
-            SPDLOG_INFO("Reached max_issues limit ({}). Remaining issues will be ignored.",
-                        config.analysis.maxIssues);
+    DiagnosticsAnalyzer analyzer(resolved, config, catalog);
+    analyzer.setCompactIssueSink(sink);
+    while (got > 0 && !analyzer.stopped()) {
+        analyzer.feed(std::string_view(buffer.data(), got));
+        if (!in) {
             break;
         }
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        got = static_cast<std::size_t>(in.gcount());
     }
+    return analyzer.finishCompact();
+}
 
-    SPDLOG_INFO("Diagnostics analysis complete. Issues found: {}", filteredResult.issues.size());
-    for ([[maybe_unused]] const auto& issue : filteredResult.issues) {
-        SPDLOG_DEBUG("Issue: code='{}', category='{}', severity='{}'",
-                     issue.code,
-                     issue.category,
-                     severityToString(issue.severity));
+} // namespace
+
+TemplateInsightResult analyzeDiagnostics(
+    std::string_view logText,
+    const AnalysisOptions& options,
+    const AppConfig& config
+) {
+    AnalysisStats stats;
+    std::shared_ptr<const IssueCatalog> catalog;
+    {
+        TEMPLATE_INSIGHT_TRACE_PHASE(stats, Phase::RegistryLoad);
+        catalog = IssueCatalog::load(config.analysis);
     }
+    TemplateInsightResult result = analyzeDiagnostics(logText, options, config, std::move(catalog));
+    result.stats.merge(stats);
+    return result;
+}
 
-    return filteredResult;
+TemplateInsightResult analyzeDiagnostics(
+    std::string_view logText,
+    const AnalysisOptions& options,
+    const AppConfig& config,
+    std::shared_ptr<const IssueCatalog> catalog,
+    const IssueSink& sink,
+    AnalysisCache* cache
+) {
+    return analyzeDiagnosticsCompact(logText, options, config, std::move(catalog), materializingSink(sink), cache)
+        .toResult();
 }
 
-std::string serializeToJson(const TemplateInsightResult& result) {
-    std::ostringstream oss;
-    oss << "{ \"issues\": [";
+CompactResult analyzeDiagnosticsCompact(
+    std::string_view logText,
+    const AnalysisOptions& options,
+    const AppConfig& config,
+    std::shared_ptr<const IssueCatalog> catalog,
+    const CompactIssueSink& sink,
+    AnalysisCache* cache
+) {
+    SPDLOG_INFO("Starting diagnostics analysis. Compiler: {}, input size: {} bytes",
+                options.compiler, logText.size());
+    std::size_t streamed = 0;
+    const CompactIssueSink counting = countingSink(sink, streamed);
+    CompactResult result =
+        traced("analyze", [&] { return analyzeText(logText, options, config, std::move(catalog), counting, cache); });
+    SPDLOG_INFO("Diagnostics analysis complete. Issues found: {}", result.issues().size() + streamed);
+    return result;
+}
 
-    for (std::size_t i = 0; i < result.issues.size(); ++i) {
-        const auto& issue = result.issues[i];
-        if (i > 0) {
-            oss << ", ";
-        }
-        oss << "{";
-        oss << R"("code":")" << jsonEscape(issue.code) << "\",";
-        oss << R"("category":")" << jsonEscape(issue.category) << "\",";
-        oss << R"("severity":")" << jsonEscape(severityToString(issue.severity)) << "\",";
-        oss << R"("shortMessage":")" << jsonEscape(issue.shortMessage) << "\",";
-        oss << R"("detailedMessage":")" << jsonEscape(issue.detailedMessage) << "\"";
-
-        if (issue.location.has_value()) {
-            const auto& loc = *issue.location;
-            oss << ",\"location\":{"
-                << R"("file":")" << jsonEscape(loc.file) << "\","
-                << "\"line\":" << loc.line << ","
-                << "\"column\":" << loc.column
-                << "}";
-        }
+TemplateInsightResult analyzeDiagnosticsStream(
+    std::istream& in,
+    const AnalysisOptions& options,
+    const AppConfig& config,
+    const IssueSink& sink
+) {
+    return analyzeDiagnosticsStreamCompact(in, options, config, materializingSink(sink)).toResult();
+}
+
+CompactResult analyzeDiagnosticsStreamCompact(
+    std::istream& in,
+    const AnalysisOptions& options,
+    const AppConfig& config,
+    const CompactIssueSink& sink
+) {
+    SPDLOG_INFO("Starting streaming diagnostics analysis. Compiler: {}", options.compiler);
 
-        oss << "}";
+    AnalysisStats stats;
+    std::shared_ptr<const IssueCatalog> catalog;
+    {
+        TEMPLATE_INSIGHT_TRACE_PHASE(stats, Phase::RegistryLoad);
+        catalog = IssueCatalog::load(config.analysis);
     }
+    std::size_t streamed = 0;
+    const CompactIssueSink counting = countingSink(sink, streamed);
+    CompactResult result =
+        traced("analyze", [&] { return analyzeStream(in, options, config, std::move(catalog), counting); });
+    result.stats.merge(stats);
+    SPDLOG_INFO("Diagnostics analysis complete. Issues found: {}", result.issues().size() + streamed);
+    return result;
+}
 
-    oss << "] }";
-    return oss.str();
+std::string serializeToJson(const TemplateInsightResult& result) {
+    OutputBuffer out;
+    ResultJsonWriter writer(out, ResultJsonWriter::Layout::Document);
+    writer.finish(result);
+    return std::move(out.str());
 }
 
 } // namespace template_insight
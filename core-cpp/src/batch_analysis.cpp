@@ -0,0 +1,441 @@
+#include "batch_analysis.hpp"
+
+#include "analyzer.hpp"
+#include "result_merger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TEMPLATE_INSIGHT_HAVE_FORK 1
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+using nlohmann::json;
+
+namespace {
+
+/// Read size for compiler output.
+constexpr std::size_t kPipeChunkSize = 64 * 1024;
+
+std::string errnoMessage(const char* what) {
+    return std::string(what) + ": " + std::strerror(errno);
+}
+
+#ifdef TEMPLATE_INSIGHT_HAVE_FORK
+
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define TEMPLATE_INSIGHT_HAVE_PIPE2 1
+#else
+/// Without pipe2(), a pipe is close-on-exec only after two more calls;
+/// fork() waits until then so no child inherits it in between.
+std::mutex spawnMutex;
+#endif
+
+/// Pipe whose ends are close-on-exec from the start, so compilers started
+/// by other workers never inherit them (and keep them open).
+void openPipe(int fds[2]) {
+#ifdef TEMPLATE_INSIGHT_HAVE_PIPE2
+    if (::pipe2(fds, O_CLOEXEC) != 0) {
+        throw std::runtime_error(errnoMessage("pipe"));
+    }
+#else
+    std::lock_guard<std::mutex> lock(spawnMutex);
+    if (::pipe(fds) != 0) {
+        throw std::runtime_error(errnoMessage("pipe"));
+    }
+    ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+}
+
+pid_t forkChild() {
+#ifndef TEMPLATE_INSIGHT_HAVE_PIPE2
+    std::lock_guard<std::mutex> lock(spawnMutex);
+#endif
+    return ::fork();
+}
+
+/// Run `arguments` in `directory` with stdin from /dev/null and pass its
+/// combined stdout/stderr to `onOutput` as it arrives.
+/// @return The exit status (127 if the compiler could not be started).
+/// @throws std::runtime_error if the process cannot be created.
+int runCompiler(const std::vector<std::string>& arguments, const std::string& directory,
+                const std::function<void(std::string_view)>& onOutput) {
+    // Everything the child needs is prepared before fork().
+    std::vector<char*> argv;
+    argv.reserve(arguments.size() + 1);
+    for (const auto& arg : arguments) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    int fds[2];
+    openPipe(fds);
+    const int devNull = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+    const pid_t pid = forkChild();
+    if (pid < 0) {
+        const std::string message = errnoMessage("fork");
+        ::close(fds[0]);
+        ::close(fds[1]);
+        ::close(devNull);
+        throw std::runtime_error(message);
+    }
+    if (pid == 0) {
+        // Child: only async-signal-safe calls until exec.
+        if (devNull >= 0) {
+            ::dup2(devNull, STDIN_FILENO);
+        }
+        ::dup2(fds[1], STDOUT_FILENO);
+        ::dup2(fds[1], STDERR_FILENO);
+        if (!directory.empty() && ::chdir(directory.c_str()) != 0) {
+            ::_exit(127);
+        }
+        ::execvp(argv[0], argv.data());
+        ::_exit(127);
+    }
+
+    ::close(fds[1]);
+    if (devNull >= 0) {
+        ::close(devNull);
+    }
+    std::vector<char> buffer(kPipeChunkSize);
+    for (;;) {
+        const ssize_t n = ::read(fds[0], buffer.data(), buffer.size());
+        if (n > 0) {
+            onOutput(std::string_view(buffer.data(), static_cast<std::size_t>(n)));
+        } else if (n == 0 || errno != EINTR) {
+            break;
+        }
+    }
+    ::close(fds[0]);
+
+    int status = 0;
+    while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+#else
+
+int runCompiler(const std::vector<std::string>&, const std::string&, const std::function<void(std::string_view)>&) {
+    throw std::runtime_error("running compilers is not supported on this platform");
+}
+
+#endif
+
+} // namespace
+
+std::vector<std::string> splitCommandLine(std::string_view command) {
+    std::vector<std::string> args;
+    std::string current;
+    bool inArg = false;
+    for (std::size_t i = 0; i < command.size(); ++i) {
+        const char c = command[i];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (inArg) {
+                args.push_back(std::move(current));
+                current.clear();
+                inArg = false;
+            }
+            continue;
+        }
+        inArg = true;
+        if (c == '\'') {
+            const std::size_t end = command.find('\'', i + 1);
+            const std::size_t stop = end == std::string_view::npos ? command.size() : end;
+            current.append(command.substr(i + 1, stop - i - 1));
+            i = stop;
+        } else if (c == '"') {
+            for (++i; i < command.size() && command[i] != '"'; ++i) {
+                if (command[i] == '\\' && i + 1 < command.size() &&
+                    (command[i + 1] == '"' || command[i + 1] == '\\' || command[i + 1] == '$' ||
+                     command[i + 1] == '`')) {
+                    ++i;
+                }
+                current.push_back(command[i]);
+            }
+        } else if (c == '\\' && i + 1 < command.size()) {
+            current.push_back(command[++i]);
+        } else {
+            current.push_back(c);
+        }
+    }
+    if (inArg) {
+        args.push_back(std::move(current));
+    }
+    return args;
+}
+
+std::vector<CompileCommand> loadCompileCommands(const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        throw std::runtime_error("Cannot open compilation database '" + path + "'");
+    }
+    json entries;
+    try {
+        in >> entries;
+    } catch (const json::exception& ex) {
+        throw std::runtime_error("Invalid compilation database '" + path + "': " + ex.what());
+    }
+    if (!entries.is_array()) {
+        throw std::runtime_error("Invalid compilation database '" + path + "': expected an array");
+    }
+
+    std::vector<CompileCommand> commands;
+    commands.reserve(entries.size());
+    for (const auto& entry : entries) {
+        if (!entry.is_object() || !entry.contains("file") || !entry["file"].is_string()) {
+            SPDLOG_WARN("Skipping compilation database entry without a file.");
+            continue;
+        }
+        CompileCommand command;
+        if (entry.contains("directory") && entry["directory"].is_string()) {
+            command.directory = entry["directory"].get<std::string>();
+        }
+        command.file = (std::filesystem::path(command.directory) / entry["file"].get<std::string>())
+                           .lexically_normal().string();
+        if (entry.contains("arguments") && entry["arguments"].is_array()) {
+            for (const auto& arg : entry["arguments"]) {
+                if (arg.is_string()) {
+                    command.arguments.push_back(arg.get<std::string>());
+                }
+            }
+        } else if (entry.contains("command") && entry["command"].is_string()) {
+            command.arguments = splitCommandLine(entry["command"].get<std::string>());
+        }
+        if (command.arguments.empty()) {
+            SPDLOG_WARN("Skipping compilation database entry for '{}' without a command.", command.file);
+            continue;
+        }
+        commands.push_back(std::move(command));
+    }
+    SPDLOG_INFO("Loaded {} compile commands from '{}'.", commands.size(), path);
+    return commands;
+}
+
+std::vector<std::string> syntaxOnlyArguments(const CompileCommand& command, const AnalysisConfig& config) {
+    std::vector<std::string> args;
+    args.reserve(command.arguments.size() + 1);
+    if (!config.batchCompiler.empty()) {
+        args = splitCommandLine(config.batchCompiler);
+    } else {
+        args.push_back(command.arguments.front());
+    }
+    for (std::size_t i = 1; i < command.arguments.size(); ++i) {
+        const std::string& arg = command.arguments[i];
+        if (arg == "-o" || arg == "-MF" || arg == "-MT" || arg == "-MQ") {
+            ++i; // Drop the option and its value.
+        } else if (arg == "-c" || arg == "-MD" || arg == "-MMD" || arg == "-fsyntax-only" ||
+                   (arg.size() > 2 && arg.compare(0, 2, "-o") == 0)) {
+            // Not meaningful for a syntax-only compile.
+        } else {
+            args.push_back(arg);
+        }
+    }
+    args.push_back("-fsyntax-only");
+    return args;
+}
+
+void CompileTimings::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        SPDLOG_INFO("No compile timings at '{}', using the database order.", path);
+        return;
+    }
+    json timings;
+    try {
+        in >> timings;
+    } catch (const json::exception& ex) {
+        throw std::runtime_error("Invalid compile timings file '" + path + "': " + ex.what());
+    }
+    if (!timings.is_object()) {
+        throw std::runtime_error("Invalid compile timings file '" + path + "': expected an object");
+    }
+    for (const auto& [file, millis] : timings.items()) {
+        if (millis.is_number_unsigned()) {
+            millis_[file] = millis.get<std::uint64_t>();
+        }
+    }
+    SPDLOG_INFO("Loaded compile timings of {} translation units from '{}'.", millis_.size(), path);
+}
+
+void CompileTimings::save(const std::string& path) const {
+    json timings = json::object();
+    for (const auto& [file, millis] : millis_) {
+        timings[file] = millis;
+    }
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open() || !(out << timings.dump(1) << '\n')) {
+        throw std::runtime_error("Failed to write compile timings to '" + path + "'");
+    }
+}
+
+std::optional<std::uint64_t> CompileTimings::find(const std::string& file) const {
+    auto it = millis_.find(file);
+    if (it == millis_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void runWorkStealing(const std::vector<std::size_t>& order, unsigned workers,
+                     const std::function<void(std::size_t)>& task) {
+    struct WorkDeque {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+    workers = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(workers, order.size())));
+    std::vector<WorkDeque> deques(workers);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        deques[i % workers].tasks.push_back(order[i]);
+    }
+
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+    std::atomic<bool> failed{false};
+
+    auto next = [&](unsigned self) -> std::optional<std::size_t> {
+        {
+            std::lock_guard<std::mutex> lock(deques[self].mutex);
+            if (!deques[self].tasks.empty()) {
+                const std::size_t index = deques[self].tasks.front();
+                deques[self].tasks.pop_front();
+                return index;
+            }
+        }
+        for (unsigned k = 1; k < workers; ++k) {
+            WorkDeque& victim = deques[(self + k) % workers];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                const std::size_t index = victim.tasks.back();
+                victim.tasks.pop_back();
+                return index;
+            }
+        }
+        return std::nullopt; // No task is ever added later, so all work is taken.
+    };
+
+    auto worker = [&](unsigned self) {
+        while (!failed.load(std::memory_order_relaxed)) {
+            const std::optional<std::size_t> index = next(self);
+            if (!index) {
+                return;
+            }
+            try {
+                task(*index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned i = 1; i < workers; ++i) {
+        pool.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+TemplateInsightResult analyzeCompileCommands(const std::vector<CompileCommand>& commands,
+                                             const AnalysisOptions& options,
+                                             const AppConfig& config,
+                                             std::shared_ptr<const IssueCatalog> catalog,
+                                             CompileTimings& timings) {
+    unsigned workers = config.analysis.workerThreads;
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Unknown translation units first (they may be slow), then longest first.
+    std::vector<std::size_t> order(commands.size());
+    std::vector<std::optional<std::uint64_t>> previous(commands.size());
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        order[i] = i;
+        previous[i] = timings.find(commands[i].file);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        if (!previous[a] || !previous[b]) {
+            return !previous[a] && previous[b];
+        }
+        return *previous[a] > *previous[b];
+    });
+    SPDLOG_INFO("Batch analysis of {} translation units on {} workers.", commands.size(), workers);
+
+    AppConfig tuConfig = config;
+    tuConfig.analysis.timeoutMs = 0;
+    std::vector<std::optional<CompactResult>> results(commands.size());
+    std::vector<std::uint64_t> durations(commands.size(), 0);
+    std::atomic<std::size_t> failedToRun{0};
+    const auto batchStart = std::chrono::steady_clock::now();
+
+    runWorkStealing(order, workers, [&](std::size_t i) {
+        const CompileCommand& command = commands[i];
+        DiagnosticsAnalyzer analyzer(options, tuConfig, catalog);
+        const auto start = std::chrono::steady_clock::now();
+        int status = -1;
+        try {
+            status = runCompiler(syntaxOnlyArguments(command, config.analysis), command.directory,
+                                 [&analyzer](std::string_view output) { analyzer.feed(output); });
+        } catch (const std::exception& ex) {
+            SPDLOG_WARN("Failed to compile '{}': {}", command.file, ex.what());
+        }
+        durations[i] = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        if (status == -1 || status == 127) {
+            ++failedToRun;
+            SPDLOG_WARN("Compiler for '{}' could not be run.", command.file);
+        }
+
+        results[i] = analyzer.finishCompact();
+        results[i]->setTranslationUnit(command.file);
+        SPDLOG_DEBUG("Compiled '{}' in {} ms (exit status {}): {} issues.",
+                     command.file, durations[i], status, results[i]->issues().size());
+    });
+
+    ResultMerger merger(config.analysis.maxIssues, catalog);
+    bool merging = true;
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        timings.record(commands[i].file, durations[i]);
+        if (merging) {
+            merging = merger.append(*results[i]);
+        }
+    }
+    SPDLOG_INFO("Batch analysis finished in {} ms ({} compilers failed to run).",
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - batchStart).count(),
+                failedToRun.load());
+    return merger.finish().toResult();
+}
+
+} // namespace template_insight
@@ -0,0 +1,281 @@
+#include "binary_format.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace template_insight {
+
+namespace {
+
+constexpr char kMagic[] = {'T', 'I', 'B'};
+
+enum : std::uint8_t {
+    kHasLocation = 1u << 0,
+    kHasLink = 1u << 1,
+    kHasTranslationUnit = 1u << 2,
+    kHasDuplicates = 1u << 3,
+};
+
+void appendVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/// Body writer that collects strings into the table as it goes.
+class Encoder {
+public:
+    void putString(const std::string& s) {
+        auto [it, inserted] = ids_.try_emplace(s, static_cast<std::uint32_t>(table_.size()));
+        if (inserted) {
+            table_.push_back(s);
+        }
+        appendVarint(body_, it->second);
+    }
+    void putLocation(const SourceLocation& loc) {
+        putString(loc.file);
+        appendVarint(body_, static_cast<std::uint64_t>(std::max(loc.line, 0)));
+        appendVarint(body_, static_cast<std::uint64_t>(std::max(loc.column, 0)));
+    }
+    void putVarint(std::uint64_t value) { appendVarint(body_, value); }
+    void putByte(std::uint8_t value) { body_.push_back(static_cast<char>(value)); }
+
+    std::string finish() const {
+        std::string out(kMagic, sizeof(kMagic));
+        out.push_back(static_cast<char>(kBinaryFormatVersion));
+        appendVarint(out, table_.size());
+        for (std::string_view s : table_) {
+            appendVarint(out, s.size());
+            out.append(s);
+        }
+        out.append(body_);
+        return out;
+    }
+
+private:
+    std::string body_;
+    std::vector<std::string_view> table_;
+    std::unordered_map<std::string_view, std::uint32_t> ids_;
+};
+
+class Decoder {
+public:
+    explicit Decoder(std::string_view data) : data_(data) {}
+
+    std::uint8_t byte() {
+        if (pos_ >= data_.size()) {
+            fail("unexpected end of data");
+        }
+        return static_cast<std::uint8_t>(data_[pos_++]);
+    }
+    std::uint64_t varint() {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const std::uint8_t b = byte();
+            value |= std::uint64_t{b & 0x7fu} << shift;
+            if ((b & 0x80) == 0) {
+                return value;
+            }
+        }
+        fail("varint is too long");
+    }
+    /// Element count, bounded by the remaining bytes so corrupt input cannot
+    /// trigger huge allocations (every element takes at least one byte).
+    std::size_t count() {
+        const std::uint64_t n = varint();
+        if (n > data_.size() - pos_) {
+            fail("count exceeds data size");
+        }
+        return static_cast<std::size_t>(n);
+    }
+    std::string_view bytes(std::size_t n) {
+        if (n > data_.size() - pos_) {
+            fail("unexpected end of data");
+        }
+        std::string_view s = data_.substr(pos_, n);
+        pos_ += n;
+        return s;
+    }
+    const std::string& string() {
+        const std::uint64_t id = varint();
+        if (id >= table_.size()) {
+            fail("string index out of range");
+        }
+        return table_[id];
+    }
+    /// Line or column number; the encoder never writes negative ones.
+    int number() {
+        const std::uint64_t n = varint();
+        if (n > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) {
+            fail("number out of range");
+        }
+        return static_cast<int>(n);
+    }
+    /// Index into a table of `size` elements.
+    std::size_t index(std::size_t size, const char* what) {
+        const std::uint64_t i = varint();
+        if (i >= size) {
+            fail(what);
+        }
+        return static_cast<std::size_t>(i);
+    }
+    SourceLocation location() {
+        SourceLocation loc;
+        loc.file = string();
+        loc.line = number();
+        loc.column = number();
+        return loc;
+    }
+    void readStringTable() {
+        table_.resize(count());
+        for (auto& s : table_) {
+            s = bytes(count());
+        }
+    }
+    bool atEnd() const { return pos_ == data_.size(); }
+
+    [[noreturn]] void fail(const char* what) const {
+        throw std::runtime_error(std::string("decodeBinaryResult: ") + what +
+                                 " at offset " + std::to_string(pos_));
+    }
+
+private:
+    std::string_view data_;
+    std::size_t pos_ = 0;
+    std::vector<std::string> table_;
+};
+
+} // namespace
+
+std::string encodeBinaryResult(const TemplateInsightResult& result) {
+    Encoder enc;
+    enc.putVarint(result.issues.size());
+    for (const auto& issue : result.issues) {
+        enc.putString(issue.code);
+        enc.putString(issue.category);
+        enc.putByte(static_cast<std::uint8_t>(issue.severity));
+        enc.putString(issue.shortMessage);
+        enc.putString(issue.detailedMessage);
+        const bool duplicates = issue.occurrences != 1 || !issue.duplicateTranslationUnits.empty();
+        enc.putByte((issue.location ? kHasLocation : 0) | (issue.instantiation ? kHasLink : 0) |
+                    (issue.translationUnit.empty() ? 0 : kHasTranslationUnit) |
+                    (duplicates ? kHasDuplicates : 0));
+        if (issue.location) {
+            enc.putLocation(*issue.location);
+        }
+        if (issue.instantiation) {
+            enc.putVarint(*issue.instantiation);
+        }
+        enc.putVarint(issue.omittedFrames);
+        if (!issue.translationUnit.empty()) {
+            enc.putString(issue.translationUnit);
+        }
+        if (duplicates) {
+            enc.putVarint(issue.occurrences);
+            enc.putVarint(issue.duplicateTranslationUnits.size());
+            for (const auto& unit : issue.duplicateTranslationUnits) {
+                enc.putString(unit);
+            }
+        }
+    }
+
+    enc.putVarint(result.instantiations.size());
+    for (const auto& frame : result.instantiations) {
+        enc.putString(frame.description);
+        enc.putByte((frame.location ? kHasLocation : 0) | (frame.parent ? kHasLink : 0));
+        if (frame.parent) {
+            enc.putVarint(*frame.parent);
+        }
+        if (frame.location) {
+            enc.putLocation(*frame.location);
+        }
+    }
+
+    enc.putByte(static_cast<std::uint8_t>(result.truncation));
+    return enc.finish();
+}
+
+TemplateInsightResult decodeBinaryResult(std::string_view data) {
+    Decoder dec(data);
+    if (dec.bytes(sizeof(kMagic)) != std::string_view(kMagic, sizeof(kMagic))) {
+        dec.fail("not a Template Insight binary result");
+    }
+    const std::uint8_t version = dec.byte();
+    // Earlier versions differ only in never setting the newer flag bits.
+    if (version == 0 || version > kBinaryFormatVersion) {
+        throw std::runtime_error("decodeBinaryResult: unsupported format version " +
+                                 std::to_string(version));
+    }
+
+    dec.readStringTable();
+
+    TemplateInsightResult result;
+    result.issues.resize(dec.count());
+    for (auto& issue : result.issues) {
+        issue.code = dec.string();
+        issue.category = dec.string();
+        const std::uint8_t severity = dec.byte();
+        if (severity > static_cast<std::uint8_t>(Severity::Error)) {
+            dec.fail("invalid severity");
+        }
+        issue.severity = static_cast<Severity>(severity);
+        issue.shortMessage = dec.string();
+        issue.detailedMessage = dec.string();
+        const std::uint8_t flags = dec.byte();
+        if (flags & kHasLocation) {
+            issue.location = dec.location();
+        }
+        if (flags & kHasLink) {
+            // Checked against the frame count once the frames are read.
+            issue.instantiation = static_cast<std::size_t>(dec.varint());
+        }
+        issue.omittedFrames = static_cast<std::size_t>(dec.varint());
+        if (flags & kHasTranslationUnit) {
+            issue.translationUnit = dec.string();
+        }
+        if (flags & kHasDuplicates) {
+            issue.occurrences = static_cast<std::size_t>(dec.varint());
+            issue.duplicateTranslationUnits.resize(dec.count());
+            for (auto& unit : issue.duplicateTranslationUnits) {
+                unit = dec.string();
+            }
+        }
+    }
+
+    result.instantiations.resize(dec.count());
+    for (std::size_t id = 0; id < result.instantiations.size(); ++id) {
+        InstantiationFrame& frame = result.instantiations[id];
+        frame.description = dec.string();
+        const std::uint8_t flags = dec.byte();
+        if (flags & kHasLink) {
+            // Parents precede their children, which also rules out cycles.
+            frame.parent = dec.index(id, "frame parent out of range");
+        }
+        if (flags & kHasLocation) {
+            frame.location = dec.location();
+        }
+    }
+
+    for (const auto& issue : result.issues) {
+        if (issue.instantiation && *issue.instantiation >= result.instantiations.size()) {
+            dec.fail("instantiation index out of range");
+        }
+    }
+
+    const std::uint8_t truncation = dec.byte();
+    if (truncation > static_cast<std::uint8_t>(TruncationReason::Cancelled)) {
+        dec.fail("invalid truncation reason");
+    }
+    result.truncation = static_cast<TruncationReason>(truncation);
+    if (!dec.atEnd()) {
+        dec.fail("trailing data");
+    }
+    return result;
+}
+
+} // namespace template_insight
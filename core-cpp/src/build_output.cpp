@@ -0,0 +1,566 @@
+#include "build_output.hpp"
+
+#include "analyzer.hpp"
+#include "batch_analysis.hpp"
+#include "diagnostic_line.hpp"
+#include "result_merger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <optional>
+
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+namespace {
+
+constexpr std::size_t kNoJob = static_cast<std::size_t>(-1);
+
+bool startsWith(std::string_view s, std::string_view prefix) {
+    return s.substr(0, prefix.size()) == prefix;
+}
+
+bool endsWith(std::string_view s, std::string_view suffix) {
+    return s.size() >= suffix.size() && s.substr(s.size() - suffix.size()) == suffix;
+}
+
+std::string_view trimLineEnd(std::string_view line) {
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+/// Skip the digits at `pos`; false if there are none.
+bool skipDigits(std::string_view s, std::size_t& pos) {
+    const std::size_t begin = pos;
+    while (pos < s.size() && std::isdigit(static_cast<unsigned char>(s[pos]))) {
+        ++pos;
+    }
+    return pos > begin;
+}
+
+/// Description of a ninja status line "[12/500] description".
+std::optional<std::string_view> ninjaStatus(std::string_view line) {
+    std::size_t pos = 1;
+    if (!startsWith(line, "[") || !skipDigits(line, pos) || pos >= line.size() || line[pos] != '/' ||
+        !skipDigits(line, ++pos) || line.substr(pos, 2) != "] ") {
+        return std::nullopt;
+    }
+    return line.substr(pos + 2);
+}
+
+/// Description of a CMake Makefile progress line "[ 42%] description".
+std::optional<std::string_view> cmakeProgress(std::string_view line) {
+    std::size_t pos = 1;
+    if (!startsWith(line, "[")) {
+        return std::nullopt;
+    }
+    while (pos < line.size() && line[pos] == ' ') {
+        ++pos;
+    }
+    if (!skipDigits(line, pos) || line.substr(pos, 3) != "%] ") {
+        return std::nullopt;
+    }
+    return line.substr(pos + 3);
+}
+
+/// Object file of a "Building CXX object <object>" description; empty otherwise.
+std::string_view builtObject(std::string_view description) {
+    constexpr std::string_view marker = " object ";
+    const std::size_t pos = description.find(marker);
+    if (!startsWith(description, "Building ") || pos == std::string_view::npos) {
+        return {};
+    }
+    return description.substr(pos + marker.size());
+}
+
+/// "src/a.cpp" for CMake's "CMakeFiles/app.dir/src/a.cpp.o".
+std::string sourceOfObject(std::string_view object) {
+    const std::size_t dir = object.find(".dir/");
+    if (dir != std::string_view::npos) {
+        object.remove_prefix(dir + 5);
+    }
+    for (std::string_view suffix : {".o", ".obj"}) {
+        if (endsWith(object, suffix)) {
+            object.remove_suffix(suffix.size());
+            break;
+        }
+    }
+    return std::string(object);
+}
+
+/// "app" for CMake's "CMakeFiles/app.dir/src/a.cpp.o"; empty for other objects.
+std::string targetOfObject(std::string_view object) {
+    const std::size_t dir = object.find(".dir/");
+    if (dir == std::string_view::npos) {
+        return {};
+    }
+    const std::size_t slash = object.rfind('/', dir);
+    const std::size_t begin = slash == std::string_view::npos ? 0 : slash + 1;
+    return std::string(object.substr(begin, dir - begin));
+}
+
+bool hasSourceExtension(std::string_view arg) {
+    const std::size_t dot = arg.rfind('.');
+    if (dot == std::string_view::npos) {
+        return false;
+    }
+    static constexpr std::string_view extensions[] = {
+        ".c", ".cc", ".cp", ".cpp", ".cxx", ".c++", ".C", ".m", ".mm", ".cu", ".ixx", ".cppm",
+    };
+    return std::find(std::begin(extensions), std::end(extensions), arg.substr(dot)) != std::end(extensions);
+}
+
+/// Source file of an echoed compile command ("c++ -O2 -c src/a.cpp -o a.o"),
+/// or empty if the line is not one.
+std::string compiledSource(std::string_view line) {
+    // Cheap test first: most lines are not command lines.
+    if (line.find(" -c ") == std::string_view::npos && !endsWith(line, " -c")) {
+        return {};
+    }
+    const std::vector<std::string> args = splitCommandLine(line);
+    bool compiles = false;
+    std::string source;
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "-c") {
+            compiles = true;
+        } else if (hasSourceExtension(args[i]) && (i == 0 || args[i - 1] != "-o")) {
+            source = args[i];
+        }
+    }
+    return compiles ? source : std::string();
+}
+
+/// Source file named at the start of a diagnostic or gcc/clang context line.
+std::string_view sourcePathOf(std::string_view line) {
+    constexpr std::string_view included = "In file included from ";
+    if (startsWith(line, included)) {
+        std::string_view location = line.substr(included.size());
+        while (!location.empty() && (location.back() == ':' || location.back() == ',')) {
+            location.remove_suffix(1);
+        }
+        std::string_view file;
+        int lineNumber = 0;
+        int column = 0;
+        parseLocationPrefix(location, file, lineNumber, column);
+        return file;
+    }
+    if (auto diag = parseDiagnosticLine(line)) {
+        return diag->file;
+    }
+    const std::size_t context = line.find(": In ");
+    return context == std::string_view::npos ? std::string_view() : line.substr(0, context);
+}
+
+/// True if `path` and `unit` name the same file, one possibly relative to a
+/// directory of the other ("../src/a.cpp", "/work/src/a.cpp" and "src/a.cpp").
+bool samePath(std::string_view path, std::string_view unit) {
+    if (path.empty() || unit.empty()) {
+        return false;
+    }
+    while (startsWith(path, "../") || startsWith(path, "./")) {
+        path.remove_prefix(path.find('/') + 1);
+    }
+    const std::string_view& longer = path.size() >= unit.size() ? path : unit;
+    const std::string_view& shorter = path.size() >= unit.size() ? unit : path;
+    if (!endsWith(longer, shorter)) {
+        return false;
+    }
+    const std::size_t before = longer.size() - shorter.size();
+    return before == 0 || longer[before - 1] == '/' || longer[before - 1] == '\\';
+}
+
+/// True for messages of make itself ("make[2]: Entering directory ...").
+bool isMakeMessage(std::string_view line) {
+    const std::size_t colon = line.find(": ");
+    if (colon == std::string_view::npos) {
+        return false;
+    }
+    std::string_view tool = line.substr(0, colon);
+    if (tool.find(' ') != std::string_view::npos) {
+        return false;
+    }
+    if (endsWith(tool, "]")) {
+        tool = tool.substr(0, tool.rfind('['));
+    }
+    return endsWith(tool, "make");
+}
+
+/// Target of make's "*** [file:76: CMakeFiles/app.dir/a.cpp.o] Error 1" line.
+std::string_view failedMakeTarget(std::string_view line) {
+    const std::size_t begin = line.find("*** [");
+    const std::size_t end = begin == std::string_view::npos ? begin : line.find(']', begin);
+    if (end == std::string_view::npos) {
+        return {};
+    }
+    std::string_view target = line.substr(begin + 5, end - begin - 5);
+    const std::size_t rule = target.rfind(": ");
+    return rule == std::string_view::npos ? target : target.substr(rule + 2);
+}
+
+} // namespace
+
+// ---------- BuildOutputDemuxer ----------
+
+BuildOutputDemuxer::BuildOutputDemuxer(OutputHandler onOutput, EndHandler onEnd)
+    : onOutput_(std::move(onOutput)), onEnd_(std::move(onEnd)), jobs_(1) {
+}
+
+void BuildOutputDemuxer::feed(std::string_view chunk) {
+    if (ansi_.inSequence() || containsEscape(chunk)) {
+        ansi_.strip(chunk, clean_);
+        chunk = clean_;
+    }
+    std::size_t pos = 0;
+    if (!partialLine_.empty()) {
+        const auto nl = chunk.find('\n');
+        if (nl == std::string_view::npos) {
+            partialLine_.append(chunk);
+            return;
+        }
+        partialLine_.append(chunk.substr(0, nl + 1));
+        onLine(partialLine_);
+        partialLine_.clear();
+        pos = nl + 1;
+    }
+    while (pos < chunk.size()) {
+        const auto nl = chunk.find('\n', pos);
+        if (nl == std::string_view::npos) {
+            partialLine_.assign(chunk.substr(pos));
+            break;
+        }
+        onLine(chunk.substr(pos, nl + 1 - pos));
+        pos = nl + 1;
+    }
+}
+
+void BuildOutputDemuxer::finish() {
+    if (!partialLine_.empty()) {
+        onLine(partialLine_);
+        partialLine_.clear();
+    }
+    while (!openJobs_.empty()) {
+        endJob(openJobs_.front());
+    }
+    endJob(0);
+}
+
+void BuildOutputDemuxer::onLine(std::string_view line) {
+    const std::string_view text = trimLineEnd(line);
+
+    if (auto status = ninjaStatus(text)) {
+        // ninja prints the status line of a job, then all of its output.
+        ninja_ = true;
+        expectCommand_ = false;
+        if (current_ != 0) {
+            endJob(current_);
+        }
+        current_ = startJob(builtObject(*status));
+        return;
+    }
+    if (startsWith(text, "ninja: ")) {
+        // "ninja: Entering directory ...", "ninja: build stopped ...".
+        if (ninja_ && current_ != 0) {
+            endJob(current_);
+        }
+        return;
+    }
+    if (ninja_) {
+        if (startsWith(text, "FAILED: ")) {
+            Job& job = jobs_[current_];
+            const std::string_view outputs = text.substr(8);
+            const std::string_view output = outputs.substr(0, outputs.find(' '));
+            if (current_ != 0 && job.translationUnit.empty() && (endsWith(output, ".o") || endsWith(output, ".obj"))) {
+                job.translationUnit = sourceOfObject(output);
+            }
+            expectCommand_ = true;
+            return;
+        }
+        if (expectCommand_) {
+            expectCommand_ = false;
+            std::string source = compiledSource(text);
+            if (!source.empty()) {
+                if (current_ != 0) {
+                    jobs_[current_].translationUnit = std::move(source);
+                }
+                return;
+            }
+        }
+        onOutput_(current_, line);
+        return;
+    }
+
+    if (auto progress = cmakeProgress(text)) {
+        const std::string_view object = builtObject(*progress);
+        if (!object.empty()) {
+            current_ = startJob(object);
+        } else if (startsWith(*progress, "Built target ")) {
+            const std::string_view target = progress->substr(13);
+            const std::vector<std::size_t> open(openJobs_.begin(), openJobs_.end());
+            for (std::size_t job : open) {
+                if (jobs_[job].target == target) {
+                    endJob(job);
+                }
+            }
+        }
+        return;
+    }
+    if (isMakeMessage(text)) {
+        const std::string_view target = failedMakeTarget(text);
+        for (std::size_t job : openJobs_) {
+            if (!target.empty() && jobs_[job].object == target) {
+                endJob(job);
+                break;
+            }
+        }
+        return;
+    }
+    if (std::string source = compiledSource(text); !source.empty()) {
+        // A verbose CMake build echoes the command of a job it announced.
+        std::size_t job = jobForPath(source);
+        if (job == kNoJob) {
+            job = startJob({});
+            jobs_[job].translationUnit = std::move(source);
+        }
+        current_ = job;
+        return;
+    }
+
+    if (!openJobs_.empty()) {
+        const std::size_t job = jobForPath(sourcePathOf(text));
+        if (job != kNoJob) {
+            current_ = job;
+        }
+    }
+    onOutput_(current_, line);
+}
+
+std::size_t BuildOutputDemuxer::startJob(std::string_view object) {
+    Job job;
+    if (!object.empty()) {
+        job.translationUnit = sourceOfObject(object);
+        job.object = std::string(object);
+        job.target = targetOfObject(object);
+    }
+    jobs_.push_back(std::move(job));
+    openJobs_.push_back(jobs_.size() - 1);
+    if (openJobs_.size() > kMaxOpenJobs) {
+        endJob(openJobs_.front());
+    }
+    return jobs_.size() - 1;
+}
+
+void BuildOutputDemuxer::endJob(std::size_t job) {
+    if (!jobs_[job].open) {
+        return;
+    }
+    jobs_[job].open = false;
+    const auto it = std::find(openJobs_.begin(), openJobs_.end(), job);
+    if (it != openJobs_.end()) {
+        openJobs_.erase(it);
+    }
+    if (current_ == job) {
+        current_ = 0;
+    }
+    onEnd_(job);
+}
+
+std::size_t BuildOutputDemuxer::jobForPath(std::string_view path) const {
+    if (path.empty()) {
+        return kNoJob;
+    }
+    // Newest first: a recently started job is the likeliest to be printing.
+    for (auto it = openJobs_.rbegin(); it != openJobs_.rend(); ++it) {
+        if (samePath(path, jobs_[*it].translationUnit)) {
+            return *it;
+        }
+    }
+    return kNoJob;
+}
+
+// ---------- BuildOutputAnalyzer ----------
+
+struct BuildOutputAnalyzer::Job {
+    std::unique_ptr<DiagnosticsAnalyzer> analyzer;
+    /// Output not yet fed to the analyzer.
+    std::string pending;
+    std::string translationUnit;
+    /// Queued for, or being fed by, a worker.
+    bool scheduled = false;
+    bool ended = false;
+    bool finished = false;
+    std::optional<CompactResult> result;
+};
+
+BuildOutputAnalyzer::BuildOutputAnalyzer(const AnalysisOptions& options,
+                                         const AppConfig& config,
+                                         std::shared_ptr<const IssueCatalog> catalog,
+                                         unsigned workers)
+    : options_(options),
+      config_(config),
+      catalog_(std::move(catalog)),
+      demuxer_([this](std::size_t job, std::string_view line) { addOutput(job, line); },
+               [this](std::size_t job) { endJob(job); }) {
+    // Jobs live as long as the build; each one is small, so no job times out.
+    config_.analysis.timeoutMs = 0;
+    if (workers > 1) {
+        workers_.reserve(workers);
+        for (unsigned i = 0; i < workers; ++i) {
+            workers_.emplace_back([this] { workerLoop(); });
+        }
+    }
+}
+
+BuildOutputAnalyzer::~BuildOutputAnalyzer() {
+    stopWorkers();
+}
+
+void BuildOutputAnalyzer::feed(std::string_view chunk) {
+    demuxer_.feed(chunk);
+}
+
+BuildOutputAnalyzer::Job& BuildOutputAnalyzer::job(std::size_t index) {
+    while (jobs_.size() <= index) {
+        jobs_.push_back(std::make_unique<Job>());
+        ++unfinished_;
+    }
+    return *jobs_[index];
+}
+
+void BuildOutputAnalyzer::addOutput(std::size_t index, std::string_view line) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Job& j = job(index);
+    jobDrained_.wait(lock, [&] { return j.pending.size() < kMaxPendingBytes || failure_; });
+    j.pending.append(line);
+    if (j.pending.size() >= kBatchBytes) {
+        schedule(index, lock);
+    }
+}
+
+void BuildOutputAnalyzer::endJob(std::size_t index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Job& j = job(index);
+    j.translationUnit = demuxer_.translationUnit(index);
+    j.ended = true;
+    if (!j.analyzer && j.pending.empty() && !j.scheduled) {
+        // Quiet jobs (most of a successful build) need no analyzer.
+        j.finished = true;
+        --unfinished_;
+        return;
+    }
+    schedule(index, lock);
+}
+
+void BuildOutputAnalyzer::schedule(std::size_t index, std::unique_lock<std::mutex>& lock) {
+    Job& j = *jobs_[index];
+    if (j.scheduled) {
+        return;
+    }
+    j.scheduled = true;
+    if (workers_.empty()) {
+        drain(index, lock);
+        return;
+    }
+    queue_.push_back(index);
+    workAvailable_.notify_one();
+}
+
+/// Feed a scheduled job's pending output (without holding the lock) until
+/// none is left, and finish the job once it ended.
+void BuildOutputAnalyzer::drain(std::size_t index, std::unique_lock<std::mutex>& lock) {
+    Job& j = *jobs_[index];
+    while (!j.finished && (!j.pending.empty() || j.ended)) {
+        std::string text;
+        text.swap(j.pending);
+        const bool ended = j.ended;
+        lock.unlock();
+        std::optional<CompactResult> result;
+        std::exception_ptr failure;
+        try {
+            if (!j.analyzer) {
+                j.analyzer = std::make_unique<DiagnosticsAnalyzer>(options_, config_, catalog_);
+            }
+            j.analyzer->feed(text);
+            if (ended) {
+                result = j.analyzer->finishCompact();
+                j.analyzer.reset();
+            }
+        } catch (...) {
+            failure = std::current_exception();
+        }
+        lock.lock();
+        jobDrained_.notify_all();
+        if (failure) {
+            if (!failure_) {
+                failure_ = failure;
+            }
+            break;
+        }
+        if (result) {
+            j.result = std::move(result);
+            j.finished = true;
+            --unfinished_;
+        }
+    }
+    j.scheduled = false;
+}
+
+void BuildOutputAnalyzer::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        workAvailable_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+            return;
+        }
+        const std::size_t index = queue_.front();
+        queue_.pop_front();
+        drain(index, lock);
+    }
+}
+
+void BuildOutputAnalyzer::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+TemplateInsightResult BuildOutputAnalyzer::finish() {
+    return finishCompact().toResult();
+}
+
+CompactResult BuildOutputAnalyzer::finishCompact() {
+    demuxer_.finish();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobDrained_.wait(lock, [this] { return unfinished_ == 0 || failure_; });
+    }
+    stopWorkers();
+    if (failure_) {
+        std::rethrow_exception(failure_);
+    }
+
+    ResultMerger merger(config_.analysis.maxIssues, catalog_);
+    for (const auto& j : jobs_) {
+        if (!j->result) {
+            continue; // No output.
+        }
+        j->result->setTranslationUnit(j->translationUnit);
+        if (!merger.append(*j->result)) {
+            break;
+        }
+    }
+    SPDLOG_INFO("Build output analysis: {} jobs.", jobs_.size() - 1);
+    CompactResult result = merger.finish();
+    TEMPLATE_INSIGHT_COUNT(result.stats, Counter::EscapeSequences, demuxer_.escapeSequences());
+    return result;
+}
+
+} // namespace template_insight
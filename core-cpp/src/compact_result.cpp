@@ -0,0 +1,86 @@
+#include "compact_result.hpp"
+
+#include <stdexcept>
+
+namespace template_insight {
+
+CompactResult::CompactResult(std::shared_ptr<const IssueCatalog> catalog) : catalog_(std::move(catalog)) {
+}
+
+CompactResult CompactResult::fromResult(TemplateInsightResult&& result,
+                                        std::shared_ptr<const IssueCatalog> catalog) {
+    CompactResult compact(std::move(catalog));
+    compact.issues_.reserve(result.issues.size());
+    for (const auto& issue : result.issues) {
+        const std::optional<IssueKindId> kind = compact.catalog_->findId(issue.code);
+        if (!kind) {
+            throw std::runtime_error("CompactResult: issue code '" + issue.code + "' is not in the catalog");
+        }
+        CompactIssue record;
+        record.kind = *kind;
+        record.severity = issue.severity;
+        if (issue.location) {
+            record.file = compact.internFile(issue.location->file);
+            record.line = issue.location->line;
+            record.column = issue.location->column;
+        }
+        if (issue.instantiation) {
+            record.instantiation = static_cast<std::uint32_t>(*issue.instantiation);
+        }
+        record.omittedFrames = static_cast<std::uint32_t>(issue.omittedFrames);
+        if (!issue.translationUnit.empty()) {
+            record.translationUnit = compact.internFile(issue.translationUnit);
+        }
+        compact.issues_.push_back(record);
+    }
+    compact.instantiations_ = std::move(result.instantiations);
+    compact.truncation = result.truncation;
+    compact.stats = std::move(result.stats);
+    return compact;
+}
+
+void CompactResult::setTranslationUnit(std::string_view file) {
+    const StringInterner::Id id = internFile(file);
+    for (auto& issue : issues_) {
+        issue.translationUnit = id;
+    }
+}
+
+TemplateIssue CompactResult::toIssue(const CompactIssue& compact) const {
+    const IssueKind& kind = catalog_->kind(compact.kind);
+    TemplateIssue issue;
+    issue.code            = kind.code;
+    issue.category        = kind.category;
+    issue.severity        = compact.severity;
+    issue.shortMessage    = kind.defaultShortMessage;
+    issue.detailedMessage = kind.defaultDetailedMessage;
+    if (compact.file != CompactIssue::kNone) {
+        issue.location = SourceLocation{std::string(files_.str(compact.file)), compact.line, compact.column};
+    }
+    if (compact.instantiation != CompactIssue::kNone) {
+        issue.instantiation = compact.instantiation;
+    }
+    issue.omittedFrames = compact.omittedFrames;
+    if (compact.translationUnit != CompactIssue::kNone) {
+        issue.translationUnit = std::string(files_.str(compact.translationUnit));
+    }
+    return issue;
+}
+
+TemplateInsightResult CompactResult::toResult() && {
+    TemplateInsightResult result;
+    result.issues.reserve(issues_.size());
+    for (const auto& issue : issues_) {
+        result.issues.push_back(toIssue(issue));
+    }
+    result.instantiations = std::move(instantiations_);
+    result.truncation = truncation;
+    result.stats = std::move(stats);
+    return result;
+}
+
+TemplateInsightResult CompactResult::toResult() const& {
+    return CompactResult(*this).toResult();
+}
+
+} // namespace template_insight
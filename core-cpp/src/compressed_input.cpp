@@ -0,0 +1,261 @@
+#include "compressed_input.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#ifdef TEMPLATE_INSIGHT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef TEMPLATE_INSIGHT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace template_insight {
+
+namespace {
+
+/// Read size for compressed input.
+constexpr std::size_t kInputSize = 64 * 1024;
+
+} // namespace
+
+Compression detectCompression(std::string_view head) {
+    if (head.substr(0, 2) == std::string_view("\x1f\x8b", 2)) {
+        return Compression::Gzip;
+    }
+    if (head.substr(0, 4) == std::string_view("\x28\xb5\x2f\xfd", 4)) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+const char* compressionName(Compression compression) {
+    switch (compression) {
+        case Compression::None: return "none";
+        case Compression::Gzip: return "gzip";
+        case Compression::Zstd: return "zstd";
+    }
+    return "unknown";
+}
+
+bool compressionSupported(Compression compression) {
+    switch (compression) {
+        case Compression::None:
+            return true;
+        case Compression::Gzip:
+#ifdef TEMPLATE_INSIGHT_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Compression::Zstd:
+#ifdef TEMPLATE_INSIGHT_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+DecompressingStreamBuf::DecompressingStreamBuf(std::istream& compressed, Compression compression,
+                                               std::size_t blockSize)
+    : in_(compressed), compression_(compression), blockSize_(blockSize) {
+    if (compression == Compression::None || !compressionSupported(compression)) {
+        throw std::runtime_error(std::string("DecompressingStreamBuf: ") + compressionName(compression) +
+                                 " input is not supported by this build");
+    }
+    thread_ = std::thread([this] { run(); });
+}
+
+DecompressingStreamBuf::~DecompressingStreamBuf() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+}
+
+DecompressingStreamBuf::int_type DecompressingStreamBuf::underflow() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!current_.empty()) {
+        free_.push_back(std::move(current_));
+        current_.clear();
+    }
+    changed_.wait(lock, [this] { return !full_.empty() || done_; });
+    if (full_.empty()) {
+        setg(nullptr, nullptr, nullptr);
+        if (failure_) {
+            std::rethrow_exception(failure_);
+        }
+        return traits_type::eof();
+    }
+    current_ = std::move(full_.front());
+    full_.pop_front();
+    changed_.notify_all();
+    setg(current_.data(), current_.data(), current_.data() + current_.size());
+    return traits_type::to_int_type(current_[0]);
+}
+
+void DecompressingStreamBuf::run() {
+    try {
+        if (compression_ == Compression::Gzip) {
+            inflateGzip();
+        } else {
+            decompressZstd();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        failure_ = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+    }
+    changed_.notify_all();
+}
+
+std::vector<char> DecompressingStreamBuf::takeBlock() {
+    std::vector<char> block;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            block = std::move(free_.back());
+            free_.pop_back();
+        }
+    }
+    block.resize(blockSize_);
+    return block;
+}
+
+/// Queue the first `size` bytes of `block`, waiting while the queue is full.
+/// @return false if the buffer is being destroyed.
+bool DecompressingStreamBuf::publish(std::vector<char>& block, std::size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return full_.size() < kQueueBlocks || stop_; });
+    if (stop_) {
+        return false;
+    }
+    block.resize(size);
+    full_.push_back(std::move(block));
+    changed_.notify_all();
+    return true;
+}
+
+void DecompressingStreamBuf::inflateGzip() {
+#ifdef TEMPLATE_INSIGHT_HAVE_ZLIB
+    z_stream zs{};
+    // 16 + MAX_WBITS: gzip header and trailer.
+    if (::inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK) {
+        throw std::runtime_error("DecompressingStreamBuf: cannot initialize zlib");
+    }
+    struct Cleanup {
+        z_stream& zs;
+        ~Cleanup() { ::inflateEnd(&zs); }
+    } cleanup{zs};
+
+    std::vector<char> input(kInputSize);
+    std::vector<char> block = takeBlock();
+    std::size_t filled = 0;
+    bool memberEnd = false;
+    bool needInput = true;
+    while (true) {
+        if (needInput && zs.avail_in == 0) {
+            in_.read(input.data(), static_cast<std::streamsize>(input.size()));
+            const auto got = static_cast<std::size_t>(in_.gcount());
+            if (got == 0) {
+                break;
+            }
+            zs.next_in = reinterpret_cast<Bytef*>(input.data());
+            zs.avail_in = static_cast<uInt>(got);
+        }
+        if (memberEnd) {
+            // Another gzip member follows (as written by `cat a.gz b.gz`).
+            ::inflateReset(&zs);
+            memberEnd = false;
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(block.data() + filled);
+        zs.avail_out = static_cast<uInt>(block.size() - filled);
+        const int rc = ::inflate(&zs, Z_NO_FLUSH);
+        filled = block.size() - zs.avail_out;
+        if (rc == Z_STREAM_END) {
+            memberEnd = true;
+        } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            throw std::runtime_error(std::string("DecompressingStreamBuf: corrupt gzip input: ") +
+                                     (zs.msg != nullptr ? zs.msg : "inflate failed"));
+        }
+        // With a full block, zlib may still hold output for the input it has
+        // (except at the end of a member).
+        needInput = zs.avail_out > 0 || memberEnd;
+        if (filled == block.size()) {
+            if (!publish(block, filled)) {
+                return;
+            }
+            block = takeBlock();
+            filled = 0;
+        }
+    }
+    if (!memberEnd) {
+        throw std::runtime_error("DecompressingStreamBuf: gzip input ends unexpectedly");
+    }
+    if (filled > 0) {
+        publish(block, filled);
+    }
+#endif
+}
+
+void DecompressingStreamBuf::decompressZstd() {
+#ifdef TEMPLATE_INSIGHT_HAVE_ZSTD
+    ZSTD_DStream* ds = ::ZSTD_createDStream();
+    if (ds == nullptr) {
+        throw std::runtime_error("DecompressingStreamBuf: cannot initialize zstd");
+    }
+    struct Cleanup {
+        ZSTD_DStream* ds;
+        ~Cleanup() { ::ZSTD_freeDStream(ds); }
+    } cleanup{ds};
+
+    std::vector<char> input(kInputSize);
+    ZSTD_inBuffer in{input.data(), 0, 0};
+    std::vector<char> block = takeBlock();
+    std::size_t filled = 0;
+    std::size_t frameRemaining = 0; // 0 once a frame is complete
+    bool needInput = true;
+    while (true) {
+        if (needInput && in.pos == in.size) {
+            in_.read(input.data(), static_cast<std::streamsize>(input.size()));
+            const auto got = static_cast<std::size_t>(in_.gcount());
+            if (got == 0) {
+                break;
+            }
+            in = ZSTD_inBuffer{input.data(), got, 0};
+        }
+        ZSTD_outBuffer out{block.data(), block.size(), filled};
+        const std::size_t rc = ::ZSTD_decompressStream(ds, &out, &in);
+        if (::ZSTD_isError(rc)) {
+            throw std::runtime_error(std::string("DecompressingStreamBuf: corrupt zstd input: ") +
+                                     ::ZSTD_getErrorName(rc));
+        }
+        frameRemaining = rc;
+        filled = out.pos;
+        // With a full block, zstd may still hold output for the input it has.
+        needInput = filled < block.size();
+        if (filled == block.size()) {
+            if (!publish(block, filled)) {
+                return;
+            }
+            block = takeBlock();
+            filled = 0;
+        }
+    }
+    if (frameRemaining != 0) {
+        throw std::runtime_error("DecompressingStreamBuf: zstd input ends unexpectedly");
+    }
+    if (filled > 0) {
+        publish(block, filled);
+    }
+#endif
+}
+
+} // namespace template_insight
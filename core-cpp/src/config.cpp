@@ -34,6 +34,10 @@ static AnalysisConfig parseAnalysisConfig(const json& jAnalysis) {
     if (jAnalysis.contains("max_template_depth") && jAnalysis["max_template_depth"].is_number_integer()) {
         cfg.maxTemplateDepth = jAnalysis["max_template_depth"].get<int>();
     }
+    if (jAnalysis.contains("type_name_abbreviation_length") &&
+        jAnalysis["type_name_abbreviation_length"].is_number_unsigned()) {
+        cfg.typeNameAbbreviationLength = jAnalysis["type_name_abbreviation_length"].get<std::size_t>();
+    }
     if (jAnalysis.contains("enable_optimizations") && jAnalysis["enable_optimizations"].is_boolean()) {
         cfg.enableOptimizations = jAnalysis["enable_optimizations"].get<bool>();
     }
@@ -50,6 +54,45 @@ static AnalysisConfig parseAnalysisConfig(const json& jAnalysis) {
     if (jAnalysis.contains("max_issues") && jAnalysis["max_issues"].is_number_unsigned()) {
         cfg.maxIssues = jAnalysis["max_issues"].get<std::size_t>();
     }
+    if (jAnalysis.contains("worker_threads") && jAnalysis["worker_threads"].is_number_unsigned()) {
+        cfg.workerThreads = jAnalysis["worker_threads"].get<unsigned>();
+    }
+    if (jAnalysis.contains("parallel_chunk_bytes") && jAnalysis["parallel_chunk_bytes"].is_number_unsigned()) {
+        cfg.parallelChunkBytes = jAnalysis["parallel_chunk_bytes"].get<std::size_t>();
+    }
+    if (jAnalysis.contains("demultiplex_build_output") && jAnalysis["demultiplex_build_output"].is_boolean()) {
+        cfg.demultiplexBuildOutput = jAnalysis["demultiplex_build_output"].get<bool>();
+    }
+    if (jAnalysis.contains("cache_max_bytes") && jAnalysis["cache_max_bytes"].is_number_unsigned()) {
+        cfg.cacheMaxBytes = jAnalysis["cache_max_bytes"].get<std::size_t>();
+    }
+    if (jAnalysis.contains("cache_file") && jAnalysis["cache_file"].is_string()) {
+        cfg.cacheFile = jAnalysis["cache_file"].get<std::string>();
+    }
+    if (jAnalysis.contains("deduplicate_issues") && jAnalysis["deduplicate_issues"].is_boolean()) {
+        cfg.deduplicateIssues = jAnalysis["deduplicate_issues"].get<bool>();
+    }
+    if (jAnalysis.contains("max_duplicate_units") && jAnalysis["max_duplicate_units"].is_number_unsigned()) {
+        cfg.maxDuplicateUnits = jAnalysis["max_duplicate_units"].get<std::size_t>();
+    }
+    if (jAnalysis.contains("compiler") && jAnalysis["compiler"].is_string()) {
+        cfg.compiler = jAnalysis["compiler"].get<std::string>();
+    }
+    if (jAnalysis.contains("batch_compiler") && jAnalysis["batch_compiler"].is_string()) {
+        cfg.batchCompiler = jAnalysis["batch_compiler"].get<std::string>();
+    }
+    if (jAnalysis.contains("batch_timings_file") && jAnalysis["batch_timings_file"].is_string()) {
+        cfg.batchTimingsFile = jAnalysis["batch_timings_file"].get<std::string>();
+    }
+    if (jAnalysis.contains("profile_top_n") && jAnalysis["profile_top_n"].is_number_unsigned()) {
+        cfg.profileTopN = jAnalysis["profile_top_n"].get<std::size_t>();
+    }
+    if (jAnalysis.contains("follow_settle_ms") && jAnalysis["follow_settle_ms"].is_number_integer()) {
+        cfg.followSettleMs = jAnalysis["follow_settle_ms"].get<int>();
+    }
+    if (jAnalysis.contains("follow_idle_timeout_ms") && jAnalysis["follow_idle_timeout_ms"].is_number_integer()) {
+        cfg.followIdleTimeoutMs = jAnalysis["follow_idle_timeout_ms"].get<int>();
+    }
     if (jAnalysis.contains("issue_kinds_file") && jAnalysis["issue_kinds_file"].is_string()) {
         cfg.issueKindsFile = jAnalysis["issue_kinds_file"].get<std::string>();
     }
@@ -68,6 +111,12 @@ static OutputConfig parseOutputConfig(const json& jOutput) {
     if (jOutput.contains("output_file") && jOutput["output_file"].is_string()) {
         cfg.outputFile = jOutput["output_file"].get<std::string>();
     }
+    if (jOutput.contains("stats") && jOutput["stats"].is_boolean()) {
+        cfg.writeStats = jOutput["stats"].get<bool>();
+    }
+    if (jOutput.contains("trace_file") && jOutput["trace_file"].is_string()) {
+        cfg.traceFile = jOutput["trace_file"].get<std::string>();
+    }
 
     return cfg;
 }
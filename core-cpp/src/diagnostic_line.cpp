@@ -0,0 +1,122 @@
+#include "diagnostic_line.hpp"
+
+#include <cstring>
+
+namespace template_insight {
+
+namespace {
+
+struct KindKeyword {
+    std::string_view text;
+    DiagnosticKind kind;
+};
+
+constexpr KindKeyword kKindKeywords[] = {
+    {"error:", DiagnosticKind::Error},
+    {"warning:", DiagnosticKind::Warning},
+    {"note:", DiagnosticKind::Note},
+    {"fatal error:", DiagnosticKind::FatalError},
+    {"remark:", DiagnosticKind::Remark},
+};
+
+/// Match a kind keyword at the start of `s`; returns its length or 0.
+std::size_t matchKind(std::string_view s, DiagnosticKind& kind) {
+    if (s.empty()) {
+        return 0;
+    }
+    // Cheap first-byte filter before comparing keywords.
+    const char c = s.front();
+    if (c != 'e' && c != 'w' && c != 'n' && c != 'f' && c != 'r') {
+        return 0;
+    }
+    for (const auto& keyword : kKindKeywords) {
+        if (s.size() >= keyword.text.size() && s.compare(0, keyword.text.size(), keyword.text) == 0) {
+            kind = keyword.kind;
+            return keyword.text.size();
+        }
+    }
+    return 0;
+}
+
+/// Parse a trailing ":<digits>" of `s`; on success shrink `s` and store the value.
+bool takeTrailingNumber(std::string_view& s, int& value) {
+    std::size_t i = s.size();
+    while (i > 0 && s[i - 1] >= '0' && s[i - 1] <= '9') {
+        --i;
+    }
+    if (i == s.size() || i == 0 || s[i - 1] != ':' || s.size() - i > 9) {
+        return false;
+    }
+    int v = 0;
+    for (std::size_t j = i; j < s.size(); ++j) {
+        v = v * 10 + (s[j] - '0');
+    }
+    value = v;
+    s = s.substr(0, i - 1);
+    return true;
+}
+
+std::string_view skipSpaces(std::string_view s) {
+    std::size_t i = 0;
+    while (i < s.size() && s[i] == ' ') {
+        ++i;
+    }
+    return s.substr(i);
+}
+
+} // namespace
+
+void parseLocationPrefix(std::string_view text, std::string_view& file, int& line, int& column) {
+    line = 0;
+    column = 0;
+    int first = 0;
+    if (takeTrailingNumber(text, first)) {
+        int second = 0;
+        if (takeTrailingNumber(text, second)) {
+            line = second;
+            column = first;
+        } else {
+            line = first;
+        }
+    }
+    file = text;
+}
+
+std::optional<DiagnosticLine> parseDiagnosticLine(std::string_view text) {
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+
+    DiagnosticLine result;
+
+    // "kind: msg" without a location.
+    if (std::size_t n = matchKind(text, result.kind)) {
+        result.message = skipSpaces(text.substr(n));
+        return result;
+    }
+
+    // Walk the ": " separators; the first one followed by a kind keyword ends the location.
+    const char* const begin = text.data();
+    const char* const end = begin + text.size();
+    const char* p = begin;
+    while (p < end) {
+        const void* hit = std::memchr(p, ':', static_cast<std::size_t>(end - p));
+        if (hit == nullptr) {
+            return std::nullopt;
+        }
+        const char* colon = static_cast<const char*>(hit);
+        if (colon + 1 < end && colon[1] == ' ') {
+            const std::string_view rest(colon + 2, static_cast<std::size_t>(end - colon - 2));
+            if (std::size_t n = matchKind(rest, result.kind)) {
+                parseLocationPrefix(std::string_view(begin, static_cast<std::size_t>(colon - begin)),
+                                    result.file, result.line, result.column);
+                result.message = skipSpaces(rest.substr(n));
+                return result;
+            }
+        }
+        p = colon + 1;
+    }
+    return std::nullopt;
+}
+
+} // namespace template_insight
@@ -0,0 +1,72 @@
+#include "dialect.hpp"
+
+#include <initializer_list>
+
+namespace template_insight {
+
+namespace {
+
+bool containsAny(std::string_view text, std::initializer_list<std::string_view> needles) {
+    for (std::string_view needle : needles) {
+        if (text.find(needle) != std::string_view::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+const char* dialectName(Dialect dialect) {
+    switch (dialect) {
+        case Dialect::Generic: return "generic";
+        case Dialect::Clang:   return "clang";
+        case Dialect::Gcc:     return "gcc";
+    }
+    return "unknown";
+}
+
+std::optional<Dialect> dialectFromCompiler(std::string_view compiler) {
+    if (compiler == "auto") {
+        return std::nullopt;
+    }
+    if (compiler == "clang" || compiler == "clang++" || compiler == "apple-clang") {
+        return Dialect::Clang;
+    }
+    if (compiler == "gcc" || compiler == "g++") {
+        return Dialect::Gcc;
+    }
+    return Dialect::Generic;
+}
+
+std::optional<Dialect> detectDialect(std::string_view head) {
+    head = head.substr(0, kDialectProbeBytes);
+    const bool clang = containsAny(head, {
+        " requested here",
+        " error generated.",
+        " errors generated.",
+        " warning generated.",
+        " warnings generated.",
+        "note: candidate template ignored",
+    });
+    // Not ": In function ": GNU ld prints it too ("a.o: In function `main':"),
+    // and a link error must not make the clang output after it parse as gcc.
+    const bool gcc = containsAny(head, {
+        "required from ",
+        ": In instantiation of ",
+        "has no member named ",
+        "note: candidate: ",
+    });
+    if (clang && gcc) {
+        return Dialect::Generic;
+    }
+    if (clang) {
+        return Dialect::Clang;
+    }
+    if (gcc) {
+        return Dialect::Gcc;
+    }
+    return std::nullopt;
+}
+
+} // namespace template_insight
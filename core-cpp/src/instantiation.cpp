@@ -0,0 +1,279 @@
+#include "instantiation.hpp"
+
+#include "diagnostic_line.hpp"
+#include "dialect.hpp"
+
+#include <functional>
+
+namespace template_insight {
+
+namespace {
+
+bool startsWith(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool endsWith(std::string_view s, std::string_view suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r' || s.back() == '\n')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+/// Strip one pair of surrounding quotes ('...' or `...').
+std::string_view unquote(std::string_view s) {
+    if (s.size() >= 2 && (s.front() == '\'' || s.front() == '`') && s.back() == '\'') {
+        return s.substr(1, s.size() - 2);
+    }
+    return s;
+}
+
+/// Parse the number in "...skipping 42 ..." style messages.
+std::size_t parseSkipCount(std::string_view s) {
+    const auto pos = s.find("skipping ");
+    if (pos == std::string_view::npos) {
+        return 0;
+    }
+    std::size_t n = 0;
+    for (std::size_t i = pos + 9; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+        n = n * 10 + static_cast<std::size_t>(s[i] - '0');
+    }
+    return n;
+}
+
+std::uint64_t hashFrame(std::optional<std::size_t> parent, std::string_view description,
+                        std::string_view file, int line, int column) {
+    std::uint64_t h = std::hash<std::string_view>{}(description);
+    auto mix = [&h](std::uint64_t v) { h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+    mix(parent ? *parent + 1 : 0);
+    mix(std::hash<std::string_view>{}(file));
+    mix(static_cast<std::uint64_t>(line) << 32 | static_cast<std::uint32_t>(column));
+    return h;
+}
+
+/// Clang-style context notes and the suffix that ends them.
+constexpr std::string_view kClangFramePrefixes[] = {
+    "in instantiation of ",
+    "while substituting ",
+    "while checking ",
+};
+
+/// gcc-style "required ..." markers; the text after the marker names the outer frame.
+constexpr std::string_view kGccRequiredMarkers[] = {
+    "recursively required from ",
+    "required from ",
+    "required by substitution of ",
+    "recursively required by substitution of ",
+};
+
+} // namespace
+
+BacktraceNoteParser::BacktraceNoteParser(std::vector<BacktraceFrame>& frames) : frames_(frames) {
+    frames_.clear();
+}
+
+template <class Policy>
+void BacktraceNoteParser::noteIn(std::string_view message, std::string_view file, int line, int column) {
+    message = trim(message);
+    if (startsWith(message, "(skipping ") || startsWith(message, "[ skipping ")) {
+        skipped_ += parseSkipCount(message);
+        return;
+    }
+
+    if constexpr (Policy::kBacktraceNotes) {
+        for (std::string_view prefix : kClangFramePrefixes) {
+            if (startsWith(message, prefix)) {
+                if (prefix == kClangFramePrefixes[0]) {
+                    message.remove_prefix(prefix.size());
+                }
+                for (std::string_view suffix : {std::string_view(" requested here"), std::string_view(" required here")}) {
+                    if (endsWith(message, suffix)) {
+                        message.remove_suffix(suffix.size());
+                    }
+                }
+                frames_.push_back({message, file, line, column});
+                return;
+            }
+        }
+    }
+    if constexpr (Policy::kBacktraceContextLines) {
+        noteGcc(message, file, line, column);
+    }
+}
+
+/// gcc's "In instantiation of '...':" and "required from ..." forms.
+void BacktraceNoteParser::noteGcc(std::string_view message, std::string_view file, int line, int column) {
+    constexpr std::string_view inInstantiation = "In instantiation of ";
+    if (startsWith(message, inInstantiation)) {
+        std::string_view what = message.substr(inInstantiation.size());
+        if (endsWith(what, ":")) {
+            what.remove_suffix(1);
+        }
+        gccPending_ = unquote(what);
+        return;
+    }
+
+    for (std::string_view marker : kGccRequiredMarkers) {
+        if (!startsWith(message, marker)) {
+            continue;
+        }
+        if (gccPending_) {
+            frames_.push_back({*gccPending_, file, line, column});
+        }
+        std::string_view outer = trim(message.substr(marker.size()));
+        if (outer == "here") {
+            gccPending_.reset();
+        } else {
+            if (endsWith(outer, ":")) {
+                outer.remove_suffix(1);
+            }
+            gccPending_ = unquote(outer);
+        }
+        return;
+    }
+}
+
+void BacktraceNoteParser::note(std::string_view message, std::string_view file, int line, int column) {
+    noteIn<GenericDialect>(message, file, line, column);
+}
+
+template void BacktraceNoteParser::noteIn<ClangDialect>(std::string_view, std::string_view, int, int);
+template void BacktraceNoteParser::noteIn<GccDialect>(std::string_view, std::string_view, int, int);
+template void BacktraceNoteParser::noteIn<GenericDialect>(std::string_view, std::string_view, int, int);
+
+template <class Policy>
+std::size_t parseInstantiationBacktrace(std::string_view block, std::vector<BacktraceFrame>& frames) {
+    BacktraceNoteParser parser(frames);
+
+    for (std::size_t pos = 0; pos < block.size();) {
+        std::size_t nl = block.find('\n', pos);
+        nl = nl == std::string_view::npos ? block.size() : nl + 1;
+        const std::string_view line = trim(block.substr(pos, nl - pos));
+        pos = nl;
+
+        if (auto diag = parseDiagnosticLine(line)) {
+            if (diag->kind == DiagnosticKind::Note) {
+                parser.noteIn<Policy>(diag->message, diag->file, diag->line, diag->column);
+            }
+            continue;
+        }
+
+        if constexpr (Policy::kBacktraceContextLines) {
+            if (startsWith(line, "[ skipping ")) {
+                parser.noteIn<Policy>(line, {}, 0, 0);
+                continue;
+            }
+
+            // gcc context lines: "file:line:col:   required from ..." and
+            // "file: In instantiation of '...':".
+            const auto inst = line.find(": In instantiation of ");
+            if (inst != std::string_view::npos) {
+                parser.noteIn<Policy>(line.substr(inst + 2), {}, 0, 0);
+                continue;
+            }
+            for (std::string_view marker : kGccRequiredMarkers) {
+                const auto at = line.find(marker);
+                if (at == std::string_view::npos) {
+                    continue;
+                }
+                std::string_view location = trim(line.substr(0, at));
+                if (endsWith(location, ":")) {
+                    location.remove_suffix(1);
+                }
+                std::string_view file;
+                int lineNo = 0;
+                int column = 0;
+                parseLocationPrefix(location, file, lineNo, column);
+                parser.noteIn<Policy>(line.substr(at), file, lineNo, column);
+                break;
+            }
+        }
+    }
+    return parser.skipped();
+}
+
+template std::size_t parseInstantiationBacktrace<ClangDialect>(std::string_view, std::vector<BacktraceFrame>&);
+template std::size_t parseInstantiationBacktrace<GccDialect>(std::string_view, std::vector<BacktraceFrame>&);
+template std::size_t parseInstantiationBacktrace<GenericDialect>(std::string_view, std::vector<BacktraceFrame>&);
+
+std::size_t parseInstantiationBacktrace(std::string_view block, std::vector<BacktraceFrame>& frames) {
+    return parseInstantiationBacktrace<GenericDialect>(block, frames);
+}
+
+std::optional<std::size_t> InstantiationTreeBuilder::insert(const std::vector<BacktraceFrame>& frames,
+                                                            int maxDepth,
+                                                            std::size_t& omitted) {
+    if (frames.empty() || maxDepth <= 0) {
+        omitted += frames.size();
+        return std::nullopt;
+    }
+
+    const std::size_t depth = static_cast<std::size_t>(maxDepth);
+    const std::size_t total = frames.size();
+    // Keep `keepOuter` outermost and `keepInner` innermost frames.
+    const std::size_t keepInner = total <= depth ? total : depth / 2;
+    const std::size_t keepOuter = total <= depth ? 0 : depth - keepInner;
+    omitted += total - keepInner - keepOuter;
+
+    std::optional<std::size_t> node;
+    // frames are innermost first; insert from the outermost end.
+    for (std::size_t i = 0; i < keepOuter; ++i) {
+        node = insertView(node, frames[total - 1 - i]);
+    }
+    for (std::size_t i = keepInner; i > 0; --i) {
+        node = insertView(node, frames[i - 1]);
+    }
+    return node;
+}
+
+std::size_t InstantiationTreeBuilder::insertView(std::optional<std::size_t> parent, const BacktraceFrame& frame) {
+    const std::uint64_t h = hashFrame(parent, frame.description, frame.file, frame.line, frame.column);
+    auto range = index_.equal_range(h);
+    for (auto it = range.first; it != range.second; ++it) {
+        const InstantiationFrame& existing = frames_[it->second];
+        const bool sameLocation = existing.location
+            ? (existing.location->file == frame.file && existing.location->line == frame.line &&
+               existing.location->column == frame.column)
+            : frame.line == 0 && frame.file.empty();
+        if (existing.parent == parent && existing.description == frame.description && sameLocation) {
+            return it->second;
+        }
+    }
+
+    InstantiationFrame node;
+    node.description = std::string(frame.description);
+    if (frame.line > 0 || !frame.file.empty()) {
+        node.location = SourceLocation{std::string(files_.internView(frame.file)), frame.line, frame.column};
+    }
+    node.parent = parent;
+    const std::size_t id = frames_.size();
+    frames_.push_back(std::move(node));
+    index_.emplace(h, id);
+    return id;
+}
+
+std::size_t InstantiationTreeBuilder::insertFrame(std::optional<std::size_t> parent, const InstantiationFrame& frame) {
+    BacktraceFrame view{frame.description, {}, 0, 0};
+    if (frame.location) {
+        view.file = frame.location->file;
+        view.line = frame.location->line;
+        view.column = frame.location->column;
+    }
+    return insertView(parent, view);
+}
+
+std::vector<InstantiationFrame> InstantiationTreeBuilder::take() {
+    index_.clear();
+    std::vector<InstantiationFrame> frames = std::move(frames_);
+    frames_.clear();
+    return frames;
+}
+
+} // namespace template_insight
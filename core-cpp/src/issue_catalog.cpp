@@ -0,0 +1,86 @@
+#include "issue_catalog.hpp"
+
+#include "content_hash.hpp"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+IssueCatalog::IssueCatalog(const IssueRegistry& registry, const std::vector<std::string>& enabledCodes) {
+    // Built-in kinds keep their well-known order (and thus their ids and match
+    // priority); kinds only known to the registry follow, ordered by code.
+    for (const auto& builtin : builtinIssueKinds()) {
+        const IssueKind* custom = registry.find(builtin.code);
+        kinds_.push_back(custom != nullptr ? *custom : builtin);
+        if (kinds_.back().patterns.empty()) {
+            kinds_.back().patterns = builtin.patterns;
+        }
+    }
+    const std::size_t builtinCount = kinds_.size();
+    for (const auto& kind : registry.all()) {
+        const auto builtinEnd = kinds_.begin() + static_cast<std::ptrdiff_t>(builtinCount);
+        if (std::none_of(kinds_.begin(), builtinEnd, [&](const IssueKind& k) { return k.code == kind.code; })) {
+            kinds_.push_back(kind);
+        }
+    }
+    std::sort(kinds_.begin() + static_cast<std::ptrdiff_t>(builtinCount), kinds_.end(),
+              [](const IssueKind& a, const IssueKind& b) { return a.code < b.code; });
+
+    // Compile one matcher from the patterns of all enabled kinds. Disabled
+    // kinds never enter the automaton, so they cost nothing during scanning.
+    std::vector<IssuePattern> patterns;
+    for (IssueKindId id = 0; id < kinds_.size(); ++id) {
+        const IssueKind& kind = kinds_[id];
+        byCode_.emplace(kind.code, id);
+        const bool enabled = enabledCodes.empty() ||
+            std::find(enabledCodes.begin(), enabledCodes.end(), kind.code) != enabledCodes.end();
+        fingerprint_ = combineHash(fingerprint_, hashBytes(kind.code));
+        fingerprint_ = combineHash(fingerprint_, hashBytes(kind.category));
+        fingerprint_ = combineHash(fingerprint_, static_cast<std::uint64_t>(kind.defaultSeverity));
+        fingerprint_ = combineHash(fingerprint_, hashBytes(kind.defaultShortMessage));
+        fingerprint_ = combineHash(fingerprint_, hashBytes(kind.defaultDetailedMessage));
+        fingerprint_ = combineHash(fingerprint_, enabled);
+        enabled_.push_back(enabled);
+        if (!enabled) {
+            continue;
+        }
+        for (const auto& text : kind.patterns) {
+            if (!text.empty()) {
+                patterns.push_back({kind.code, text});
+                patternKinds_.push_back(id);
+                fingerprint_ = combineHash(fingerprint_, hashBytes(text));
+            }
+        }
+    }
+    matcher_ = PatternMatcher(std::move(patterns));
+    SPDLOG_DEBUG("Compiled issue catalog: {} kinds, {} patterns.", kinds_.size(), matcher_.patternCount());
+}
+
+std::shared_ptr<const IssueCatalog> IssueCatalog::load(const AnalysisConfig& config) {
+    IssueRegistry registry;
+    if (!config.issueKindsFile.empty()) {
+        try {
+            registry.loadFromJsonFile(config.issueKindsFile);
+            SPDLOG_INFO("Loaded issue kinds from '{}'", config.issueKindsFile);
+        } catch (const std::exception& ex) {
+            SPDLOG_WARN("Failed to load issue kinds file '{}': {}. Falling back to built-in defaults.",
+                        config.issueKindsFile, ex.what());
+            registry = IssueRegistry{};
+        }
+    } else {
+        SPDLOG_INFO("No issue_kinds_file specified. Using built-in issue defaults.");
+    }
+    return std::make_shared<const IssueCatalog>(registry, config.enabledIssueCodes);
+}
+
+std::optional<IssueKindId> IssueCatalog::findId(std::string_view code) const {
+    auto it = byCode_.find(code);
+    if (it == byCode_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+} // namespace template_insight
@@ -0,0 +1,127 @@
+#include "issue_dedup.hpp"
+
+#include "content_hash.hpp"
+#include "string_interner.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+namespace {
+
+constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+
+struct IssueKey {
+    StringInterner::Id code;
+    StringInterner::Id file;
+    int line;
+    int column;
+    std::size_t instantiation;
+
+    bool operator==(const IssueKey& o) const {
+        return code == o.code && file == o.file && line == o.line && column == o.column &&
+               instantiation == o.instantiation;
+    }
+};
+
+struct IssueKeyHash {
+    std::size_t operator()(const IssueKey& k) const {
+        std::uint64_t h = combineHash(k.code, k.file);
+        h = combineHash(h, static_cast<std::uint64_t>(static_cast<std::uint32_t>(k.line)) << 32 |
+                               static_cast<std::uint32_t>(k.column));
+        return static_cast<std::size_t>(combineHash(h, k.instantiation));
+    }
+};
+
+/// Interns paths, normalizing each distinct spelling only once.
+class PathNormalizer {
+public:
+    StringInterner::Id normalize(const std::string& path) {
+        const StringInterner::Id raw = spellings_.intern(path);
+        if (raw >= normalized_.size()) {
+            normalized_.resize(raw + 1, kNone);
+        }
+        if (normalized_[raw] == kNone) {
+            normalized_[raw] = paths_.intern(std::filesystem::path(path).lexically_normal().generic_string());
+        }
+        return normalized_[raw];
+    }
+
+private:
+    StringInterner spellings_;
+    StringInterner paths_;
+    std::vector<StringInterner::Id> normalized_;
+};
+
+} // namespace
+
+std::size_t deduplicateIssues(TemplateInsightResult& result, std::size_t maxListedUnits) {
+    TEMPLATE_INSIGHT_TRACE_PHASE(result.stats, Phase::Filter);
+    StringInterner codes;
+    StringInterner units;
+    PathNormalizer paths;
+    std::unordered_map<IssueKey, std::size_t, IssueKeyHash> firstByKey;
+    firstByKey.reserve(result.issues.size());
+    // (kept issue index, translation unit id) pairs already accounted for.
+    std::unordered_set<std::uint64_t> listedUnits;
+
+    auto unitKey = [&](std::size_t kept, const std::string& unit) {
+        return static_cast<std::uint64_t>(kept) << 32 | units.intern(unit);
+    };
+    auto listUnit = [&](std::size_t kept, const std::string& unit) {
+        TemplateIssue& issue = result.issues[kept];
+        if (unit.empty() || unit == issue.translationUnit ||
+            issue.duplicateTranslationUnits.size() >= maxListedUnits) {
+            return;
+        }
+        if (listedUnits.insert(unitKey(kept, unit)).second) {
+            issue.duplicateTranslationUnits.push_back(unit);
+        }
+    };
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < result.issues.size(); ++i) {
+        TemplateIssue& issue = result.issues[i];
+        const IssueKey key{
+            codes.intern(issue.code),
+            issue.location ? paths.normalize(issue.location->file) : kNone,
+            issue.location ? issue.location->line : 0,
+            issue.location ? issue.location->column : 0,
+            issue.instantiation.value_or(std::numeric_limits<std::size_t>::max()),
+        };
+        auto [it, inserted] = firstByKey.emplace(key, kept);
+        if (inserted) {
+            for (const auto& unit : issue.duplicateTranslationUnits) {
+                listedUnits.insert(unitKey(kept, unit)); // Already aggregated before.
+            }
+            if (kept != i) {
+                result.issues[kept] = std::move(issue);
+            }
+            ++kept;
+            continue;
+        }
+
+        TemplateIssue& first = result.issues[it->second];
+        first.occurrences += issue.occurrences;
+        first.omittedFrames = std::max(first.omittedFrames, issue.omittedFrames);
+        listUnit(it->second, issue.translationUnit);
+        for (const auto& unit : issue.duplicateTranslationUnits) {
+            listUnit(it->second, unit);
+        }
+    }
+
+    const std::size_t removed = result.issues.size() - kept;
+    result.issues.resize(kept);
+    SPDLOG_INFO("Deduplicated issues: {} distinct, {} duplicates merged.", kept, removed);
+    TEMPLATE_INSIGHT_COUNT(result.stats, Counter::MergedDuplicates, removed);
+    return removed;
+}
+
+} // namespace template_insight
@@ -23,6 +23,15 @@ Severity parseSeverity(const std::string& s) {
     return Severity::Error;
 }
 
+std::string severityToString(Severity s) {
+    switch (s) {
+        case Severity::Info:    return "info";
+        case Severity::Warning: return "warning";
+        case Severity::Error:   return "error";
+    }
+    return "unknown";
+}
+
 void IssueRegistry::loadFromJsonFile(const std::string& path) {
     std::ifstream in(path);
     if (!in.is_open()) {
@@ -70,6 +79,14 @@ void IssueRegistry::loadFromJsonFile(const std::string& path) {
             kind.defaultDetailedMessage = item["default_detailed_message"].get<std::string>();
         }
 
+        if (item.contains("patterns") && item["patterns"].is_array()) {
+            for (const auto& pattern : item["patterns"]) {
+                if (pattern.is_string()) {
+                    kind.patterns.push_back(pattern.get<std::string>());
+                }
+            }
+        }
+
         addIssueKind(kind);
     }
 }
@@ -78,12 +95,81 @@ void IssueRegistry::addIssueKind(const IssueKind& kind) {
     kinds_[kind.code] = kind;
 }
 
-std::optional<IssueKind> IssueRegistry::find(const std::string& code) const {
+const IssueKind* IssueRegistry::find(const std::string& code) const {
     auto it = kinds_.find(code);
     if (it == kinds_.end()) {
-        return std::nullopt;
+        return nullptr;
     }
-    return it->second;
+    return &it->second;
+}
+
+std::vector<IssueKind> IssueRegistry::all() const {
+    std::vector<IssueKind> result;
+    result.reserve(kinds_.size());
+    for (const auto& [code, kind] : kinds_) {
+        result.push_back(kind);
+    }
+    return result;
+}
+
+const std::vector<IssueKind>& builtinIssueKinds() {
+    static const std::vector<IssueKind> kinds = {
+        {
+            IssueCodes::NO_MEMBER, "MemberAccess", Severity::Error,
+            "Detected 'no member' error in diagnostics.",
+            "The compiler reported that a type does not have a required member.\n"
+            "This is often caused by using a type that does not meet template "
+            "requirements (e.g., passing an int where a container is expected).",
+            {"no member", "no type named", "is not a member of"}
+        },
+        {
+            IssueCodes::NO_MATCHING_FUNCTION, "OverloadResolution", Severity::Error,
+            "No matching function for template call.",
+            "The template call cannot be resolved to any viable overload with the given arguments.",
+            {"no matching function for call to", "no matching member function for call to",
+             "no matching constructor for initialization of"}
+        },
+        {
+            IssueCodes::TYPE_MISMATCH, "TypeSystem", Severity::Error,
+            "Template parameter type mismatch.",
+            "The deduced template parameter type does not match the required constraints or expected type.",
+            {"cannot convert", "no viable conversion", "invalid conversion from",
+             "cannot initialize a variable of type", "incompatible types"}
+        },
+        {
+            IssueCodes::SUBSTITUTION_FAILURE, "TemplateDeduction", Severity::Error,
+            "Template argument substitution failed.",
+            "Substituting the deduced template arguments into the declaration produced an invalid "
+            "type or expression, so the candidate was discarded (SFINAE).",
+            {"substitution failure", "template argument deduction/substitution failed",
+             "candidate template ignored"}
+        },
+        {
+            IssueCodes::CONSTRAINT_NOT_SATISFIED, "Constraints", Severity::Error,
+            "Template constraints are not satisfied.",
+            "The template arguments do not satisfy the constraints (concepts or requires-clauses) "
+            "of the template.",
+            {"constraints not satisfied", "does not satisfy"}
+        },
+        // The cost kinds are produced from -ftime-trace files, never matched in logs.
+        {
+            IssueCodes::EXPENSIVE_INSTANTIATION, "CompileTime", Severity::Warning,
+            "Template instantiation is expensive to compile.",
+            "Instantiating this template takes a large share of the build's frontend time. "
+            "Consider explicit instantiation (extern template), fewer distinct template "
+            "arguments or moving work out of the template.",
+            {}
+        },
+        {
+            IssueCodes::EXPENSIVE_HEADER, "CompileTime", Severity::Warning,
+            "Header is expensive to compile.",
+            "Parsing this header (including everything it includes) takes a large share of the "
+            "build's frontend time. Consider forward declarations, splitting the header or a "
+            "precompiled header.",
+            {}
+        },
+    };
+    return kinds;
 }
 
 } // namespace template_insight
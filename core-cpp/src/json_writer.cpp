@@ -0,0 +1,439 @@
+#include "json_writer.hpp"
+
+#include "issues.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TEMPLATE_INSIGHT_HAVE_POSIX_IO 1
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+namespace {
+
+bool needsEscape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+/// Length of the leading run of `text` that needs no escaping.
+std::size_t cleanPrefix(std::string_view text) {
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    // Unsigned c < 0x20 <=> (c ^ 0x80) < (0x20 ^ 0x80) as signed bytes.
+    const __m128i flip = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i controlLimit = _mm_set1_epi8(static_cast<char>(0x20 ^ 0x80));
+    for (; i + 16 <= text.size(); i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)),
+            _mm_cmplt_epi8(_mm_xor_si128(bytes, flip), controlLimit));
+        const int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return i + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+#endif
+    while (i < text.size() && !needsEscape(static_cast<unsigned char>(text[i]))) {
+        ++i;
+    }
+    return i;
+}
+
+} // namespace
+
+const char* truncationReasonToString(TruncationReason reason) {
+    switch (reason) {
+        case TruncationReason::None:      return "none";
+        case TruncationReason::MaxIssues: return "max_issues";
+        case TruncationReason::Timeout:   return "timeout";
+        case TruncationReason::Cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+void appendJsonEscaped(std::string& out, std::string_view text) {
+    static constexpr char hex[] = "0123456789abcdef";
+    while (!text.empty()) {
+        const std::size_t clean = cleanPrefix(text);
+        out.append(text.data(), clean);
+        if (clean == text.size()) {
+            return;
+        }
+        const auto c = static_cast<unsigned char>(text[clean]);
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"':  out += "\\\""; break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default: {
+                const char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+                out.append(escaped, sizeof(escaped));
+                break;
+            }
+        }
+        text.remove_prefix(clean + 1);
+    }
+}
+
+#ifdef TEMPLATE_INSIGHT_HAVE_POSIX_IO
+
+OutputBuffer::OutputBuffer(int fd) : fd_(fd) {
+    buffer_.reserve(kFlushThreshold);
+}
+
+OutputBuffer OutputBuffer::openFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("OutputBuffer: failed to open output file '" + path +
+                                 "': " + std::strerror(errno));
+    }
+    OutputBuffer out(fd);
+    out.ownsFd_ = true;
+    return out;
+}
+
+#else
+
+OutputBuffer::OutputBuffer(int fd) : stream_(fd == 2 ? stderr : stdout) {
+    buffer_.reserve(kFlushThreshold);
+}
+
+OutputBuffer OutputBuffer::openFile(const std::string& path) {
+    std::FILE* stream = std::fopen(path.c_str(), "wb");
+    if (stream == nullptr) {
+        throw std::runtime_error("OutputBuffer: failed to open output file '" + path +
+                                 "': " + std::strerror(errno));
+    }
+    OutputBuffer out;
+    out.buffer_.reserve(kFlushThreshold);
+    out.stream_ = stream;
+    out.ownsFd_ = true;
+    return out;
+}
+
+#endif
+
+OutputBuffer::OutputBuffer(OutputBuffer&& other) noexcept
+    : buffer_(std::move(other.buffer_)), fd_(other.fd_), stream_(other.stream_), ownsFd_(other.ownsFd_) {
+    other.fd_ = -1;
+    other.stream_ = nullptr;
+    other.ownsFd_ = false;
+}
+
+OutputBuffer& OutputBuffer::operator=(OutputBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        buffer_ = std::move(other.buffer_);
+        fd_ = other.fd_;
+        stream_ = other.stream_;
+        ownsFd_ = other.ownsFd_;
+        other.fd_ = -1;
+        other.stream_ = nullptr;
+        other.ownsFd_ = false;
+    }
+    return *this;
+}
+
+OutputBuffer::~OutputBuffer() {
+    release();
+}
+
+void OutputBuffer::release() noexcept {
+    try {
+        flush();
+    } catch (const std::exception& ex) {
+        SPDLOG_ERROR("{}", ex.what());
+    }
+    if (ownsFd_) {
+#ifdef TEMPLATE_INSIGHT_HAVE_POSIX_IO
+        ::close(fd_);
+#else
+        std::fclose(stream_);
+#endif
+    }
+    fd_ = -1;
+    stream_ = nullptr;
+    ownsFd_ = false;
+}
+
+void OutputBuffer::appendNumber(std::uint64_t value) {
+    char digits[20];
+    std::size_t n = 0;
+    do {
+        digits[sizeof(digits) - ++n] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    append(std::string_view(digits + sizeof(digits) - n, n));
+}
+
+void OutputBuffer::flush() {
+    if (!bound()) {
+        return;
+    }
+#ifdef TEMPLATE_INSIGHT_HAVE_POSIX_IO
+    std::size_t written = 0;
+    while (written < buffer_.size()) {
+        const ssize_t n = ::write(fd_, buffer_.data() + written, buffer_.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            buffer_.clear();
+            throw std::runtime_error(std::string("OutputBuffer: write failed: ") + std::strerror(errno));
+        }
+        written += static_cast<std::size_t>(n);
+    }
+#else
+    if (std::fwrite(buffer_.data(), 1, buffer_.size(), stream_) != buffer_.size() || std::fflush(stream_) != 0) {
+        buffer_.clear();
+        throw std::runtime_error(std::string("OutputBuffer: write failed: ") + std::strerror(errno));
+    }
+#endif
+    buffer_.clear();
+}
+
+ResultJsonWriter::ResultJsonWriter(OutputBuffer& out, Layout layout)
+    : out_(out), layout_(layout), startMicros_(metricsNowMicros()) {
+}
+
+void ResultJsonWriter::writeHeader() {
+    if (!headerWritten_ && layout_ == Layout::Document) {
+        out_.append("{ \"issues\": [");
+    }
+    headerWritten_ = true;
+}
+
+void ResultJsonWriter::writeLocation(std::string_view file, int line, int column) {
+    out_.append("\"location\":{\"file\":\"");
+    out_.appendEscaped(file);
+    out_.append("\",\"line\":");
+    out_.appendNumber(static_cast<std::uint64_t>(line));
+    out_.append(",\"column\":");
+    out_.appendNumber(static_cast<std::uint64_t>(column));
+    out_.append('}');
+}
+
+void ResultJsonWriter::writeKindFields(std::string_view code, std::string_view category, Severity severity,
+                                       std::string_view shortMessage, std::string_view detailedMessage) {
+    out_.append("\"code\":\"");
+    out_.appendEscaped(code);
+    out_.append("\",\"category\":\"");
+    out_.appendEscaped(category);
+    out_.append("\",\"severity\":\"");
+    out_.appendEscaped(severityToString(severity));
+    out_.append("\",\"shortMessage\":\"");
+    out_.appendEscaped(shortMessage);
+    out_.append("\",\"detailedMessage\":\"");
+    out_.appendEscaped(detailedMessage);
+    out_.append('"');
+}
+
+void ResultJsonWriter::writeIssueFields(const TemplateIssue& issue) {
+    writeKindFields(issue.code, issue.category, issue.severity, issue.shortMessage, issue.detailedMessage);
+    if (issue.location.has_value()) {
+        out_.append(',');
+        writeLocation(issue.location->file, issue.location->line, issue.location->column);
+    }
+    if (issue.instantiation.has_value()) {
+        out_.append(",\"instantiation\":");
+        out_.appendNumber(*issue.instantiation);
+    }
+    if (issue.omittedFrames > 0) {
+        out_.append(",\"omittedFrames\":");
+        out_.appendNumber(issue.omittedFrames);
+    }
+    if (!issue.translationUnit.empty()) {
+        out_.append(",\"translationUnit\":\"");
+        out_.appendEscaped(issue.translationUnit);
+        out_.append('"');
+    }
+    if (issue.occurrences != 1) {
+        out_.append(",\"occurrences\":");
+        out_.appendNumber(issue.occurrences);
+    }
+    if (!issue.duplicateTranslationUnits.empty()) {
+        out_.append(",\"duplicateTranslationUnits\":[");
+        for (std::size_t i = 0; i < issue.duplicateTranslationUnits.size(); ++i) {
+            out_.append(i == 0 ? "\"" : ",\"");
+            out_.appendEscaped(issue.duplicateTranslationUnits[i]);
+            out_.append('"');
+        }
+        out_.append(']');
+    }
+}
+
+void ResultJsonWriter::writeIssueFields(const CompactResult& result, const CompactIssue& issue) {
+    writeKindFields(result.code(issue), result.category(issue), issue.severity,
+                    result.shortMessage(issue), result.detailedMessage(issue));
+    if (issue.file != CompactIssue::kNone) {
+        out_.append(',');
+        writeLocation(result.file(issue), issue.line, issue.column);
+    }
+    if (issue.instantiation != CompactIssue::kNone) {
+        out_.append(",\"instantiation\":");
+        out_.appendNumber(issue.instantiation);
+    }
+    if (issue.omittedFrames > 0) {
+        out_.append(",\"omittedFrames\":");
+        out_.appendNumber(issue.omittedFrames);
+    }
+    if (issue.translationUnit != CompactIssue::kNone) {
+        out_.append(",\"translationUnit\":\"");
+        out_.appendEscaped(result.translationUnit(issue));
+        out_.append('"');
+    }
+}
+
+void ResultJsonWriter::writeStatsFields(const AnalysisStats& stats) {
+    out_.append("\"phaseMicros\":{");
+    for (std::size_t i = 0; i < kPhaseCount; ++i) {
+        const auto phase = static_cast<Phase>(i);
+        std::uint64_t micros = stats.phase(phase);
+        if (phase == Phase::Serialize) {
+            micros += metricsNowMicros() - startMicros_;
+        }
+        out_.append(i == 0 ? "\"" : ",\"");
+        out_.append(phaseName(phase));
+        out_.append("\":");
+        out_.appendNumber(micros);
+    }
+    out_.append("},\"counters\":{");
+    for (std::size_t i = 0; i < kCounterCount; ++i) {
+        out_.append(i == 0 ? "\"" : ",\"");
+        out_.append(counterName(static_cast<Counter>(i)));
+        out_.append("\":");
+        out_.appendNumber(stats.counters[i]);
+    }
+    out_.append('}');
+}
+
+void ResultJsonWriter::writeFrame(std::size_t id, const InstantiationFrame& frame) {
+    if (layout_ == Layout::Ndjson) {
+        out_.append("{\"type\":\"frame\",\"id\":");
+        out_.appendNumber(id);
+        out_.append(",\"description\":\"");
+    } else {
+        out_.append(id > 0 ? ", {\"description\":\"" : "{\"description\":\"");
+    }
+    out_.appendEscaped(frame.description);
+    out_.append('"');
+    if (frame.parent.has_value()) {
+        out_.append(",\"parent\":");
+        out_.appendNumber(*frame.parent);
+    }
+    if (frame.location.has_value()) {
+        out_.append(',');
+        writeLocation(frame.location->file, frame.location->line, frame.location->column);
+    }
+    out_.append('}');
+    if (layout_ == Layout::Ndjson) {
+        out_.append('\n');
+    }
+}
+
+template <class WriteFields>
+void ResultJsonWriter::writeIssueObject(const std::vector<InstantiationFrame>& frames, WriteFields&& writeFields) {
+    if (layout_ == Layout::Ndjson) {
+        // Frames first, so the reader can resolve the issue's instantiation.
+        for (; framesWritten_ < frames.size(); ++framesWritten_) {
+            writeFrame(framesWritten_, frames[framesWritten_]);
+        }
+        out_.append("{\"type\":\"issue\",");
+        writeFields();
+        out_.append("}\n");
+        out_.flush();
+    } else {
+        writeHeader();
+        out_.append(issuesWritten_ > 0 ? ", {" : "{");
+        writeFields();
+        out_.append('}');
+    }
+    ++issuesWritten_;
+}
+
+void ResultJsonWriter::writeIssue(const TemplateIssue& issue, const std::vector<InstantiationFrame>& frames) {
+    writeIssueObject(frames, [&] { writeIssueFields(issue); });
+}
+
+void ResultJsonWriter::writeIssue(const CompactResult& result, const CompactIssue& issue,
+                                  const std::vector<InstantiationFrame>& frames) {
+    writeIssueObject(frames, [&] { writeIssueFields(result, issue); });
+}
+
+void ResultJsonWriter::finish(const TemplateInsightResult& result) {
+    for (const auto& issue : result.issues) {
+        writeIssue(issue, result.instantiations);
+    }
+    writeTail(result.instantiations, result.truncation, result.stats);
+}
+
+void ResultJsonWriter::finish(const CompactResult& result) {
+    for (const auto& issue : result.issues()) {
+        writeIssue(result, issue, result.instantiations());
+    }
+    writeTail(result.instantiations(), result.truncation, result.stats);
+}
+
+void ResultJsonWriter::writeTail(const std::vector<InstantiationFrame>& frames, TruncationReason truncation,
+                                 const AnalysisStats& statistics) {
+    const bool truncated = truncation != TruncationReason::None;
+    const bool stats = writeStats_ && !statistics.empty();
+    if (layout_ == Layout::Ndjson) {
+        for (; framesWritten_ < frames.size(); ++framesWritten_) {
+            writeFrame(framesWritten_, frames[framesWritten_]);
+        }
+        if (stats) {
+            out_.append("{\"type\":\"stats\",");
+            writeStatsFields(statistics);
+            out_.append("}\n");
+        }
+        out_.append("{\"type\":\"summary\",\"issues\":");
+        out_.appendNumber(issuesWritten_);
+        out_.append(truncated ? ",\"truncated\":true,\"truncationReason\":\"" : ",\"truncated\":false");
+        if (truncated) {
+            out_.append(truncationReasonToString(truncation));
+            out_.append('"');
+        }
+        out_.append("}\n");
+    } else {
+        writeHeader();
+        out_.append(']');
+
+        // Instantiation frames are shared between issues and emitted once.
+        if (!frames.empty()) {
+            out_.append(", \"instantiations\": [");
+            for (std::size_t i = 0; i < frames.size(); ++i) {
+                writeFrame(i, frames[i]);
+            }
+            out_.append(']');
+        }
+        if (truncated) {
+            out_.append(", \"truncated\": true, \"truncationReason\": \"");
+            out_.append(truncationReasonToString(truncation));
+            out_.append('"');
+        }
+        if (stats) {
+            out_.append(", \"stats\": {");
+            writeStatsFields(statistics);
+            out_.append('}');
+        }
+        out_.append(" }");
+    }
+    out_.flush();
+}
+
+} // namespace template_insight
@@ -0,0 +1,255 @@
+#include "log_follower.hpp"
+
+#include "analyzer.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TEMPLATE_INSIGHT_HAVE_POSIX_IO 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <filesystem>
+#include <fstream>
+#endif
+
+#if defined(__linux__)
+#define TEMPLATE_INSIGHT_HAVE_INOTIFY 1
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+namespace {
+
+/// Read size for appended log data.
+constexpr std::size_t kReadSize = 64 * 1024;
+
+/// Longest wait for a change before the stop flag and timers are checked again.
+constexpr int kPollIntervalMs = 100;
+
+/// Read end of the followed file, remembering how far it has been read.
+///
+/// Without POSIX I/O the file is read through an std::ifstream, and only a
+/// file that shrank counts as replaced.
+class FollowedFile {
+public:
+    explicit FollowedFile(std::string path) : path_(std::move(path)) {
+        if (!reopen()) {
+            throw std::runtime_error("followLog: failed to open log file: " + path_);
+        }
+    }
+    ~FollowedFile() { close(); }
+    FollowedFile(const FollowedFile&) = delete;
+    FollowedFile& operator=(const FollowedFile&) = delete;
+
+    /// Open the file at the path (again) and read it from the start.
+    /// Keeps the current file if the path cannot be opened.
+    bool reopen() {
+#ifdef TEMPLATE_INSIGHT_HAVE_POSIX_IO
+        const int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        close();
+        fd_ = fd;
+#else
+        std::ifstream in(path_, std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        in_ = std::move(in);
+#endif
+        offset_ = 0;
+        return true;
+    }
+
+    /// Read the next appended bytes into `buffer`; 0 if there are none yet.
+    std::size_t read(std::vector<char>& buffer) {
+#ifdef TEMPLATE_INSIGHT_HAVE_POSIX_IO
+        ssize_t got;
+        do {
+            got = ::read(fd_, buffer.data(), buffer.size());
+        } while (got < 0 && errno == EINTR);
+        if (got < 0) {
+            throw std::runtime_error("followLog: failed to read log file " + path_ + ": " + std::strerror(errno));
+        }
+#else
+        in_.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const std::streamsize got = in_.gcount();
+        if (in_.bad()) {
+            throw std::runtime_error("followLog: failed to read log file " + path_);
+        }
+        // End of file only means nothing was appended yet.
+        in_.clear();
+#endif
+        offset_ += static_cast<std::size_t>(got);
+        return static_cast<std::size_t>(got);
+    }
+
+    /// True if the file shrank below what was read, or the path now names a
+    /// different file. A path that does not exist (yet) is not a replacement.
+    bool replaced() const {
+#ifdef TEMPLATE_INSIGHT_HAVE_POSIX_IO
+        struct stat current {};
+        if (::fstat(fd_, &current) == 0 && static_cast<std::size_t>(current.st_size) < offset_) {
+            return true;
+        }
+        struct stat named {};
+        return ::stat(path_.c_str(), &named) == 0 &&
+               (named.st_dev != current.st_dev || named.st_ino != current.st_ino);
+#else
+        std::error_code ec;
+        const std::uintmax_t size = std::filesystem::file_size(path_, ec);
+        return !ec && size < offset_;
+#endif
+    }
+
+private:
+    void close() {
+#ifdef TEMPLATE_INSIGHT_HAVE_POSIX_IO
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+#endif
+    }
+
+    std::string path_;
+#ifdef TEMPLATE_INSIGHT_HAVE_POSIX_IO
+    int fd_ = -1;
+#else
+    std::ifstream in_;
+#endif
+    std::size_t offset_ = 0;
+};
+
+/// Waits until the followed file may have changed: inotify on Linux (falling
+/// back to a sleep if it is unavailable), a sleep elsewhere.
+class ChangeWaiter {
+public:
+    explicit ChangeWaiter(const std::string& path) {
+#ifdef TEMPLATE_INSIGHT_HAVE_INOTIFY
+        fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd_ < 0) {
+            SPDLOG_WARN("inotify unavailable ({}). Polling the log file instead.", std::strerror(errno));
+        }
+#endif
+        watch(path);
+    }
+    ~ChangeWaiter() {
+#ifdef TEMPLATE_INSIGHT_HAVE_INOTIFY
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+#endif
+    }
+    ChangeWaiter(const ChangeWaiter&) = delete;
+    ChangeWaiter& operator=(const ChangeWaiter&) = delete;
+
+    /// Watch the file now at `path` (after it was reopened).
+    void watch(const std::string& path) {
+#ifdef TEMPLATE_INSIGHT_HAVE_INOTIFY
+        if (fd_ < 0) {
+            return;
+        }
+        if (wd_ >= 0) {
+            ::inotify_rm_watch(fd_, wd_);
+        }
+        wd_ = ::inotify_add_watch(fd_, path.c_str(), IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+        if (wd_ < 0) {
+            SPDLOG_WARN("Cannot watch '{}' ({}). Polling it instead.", path, std::strerror(errno));
+        }
+#else
+        (void)path;
+#endif
+    }
+
+    /// Return after a change or after `timeoutMs`, whichever comes first.
+    void wait(int timeoutMs) {
+#ifdef TEMPLATE_INSIGHT_HAVE_INOTIFY
+        if (wd_ >= 0) {
+            pollfd pfd{fd_, POLLIN, 0};
+            if (::poll(&pfd, 1, timeoutMs) > 0) {
+                // Only the wake-up matters; the caller looks at the file itself.
+                alignas(inotify_event) char events[4096];
+                while (::read(fd_, events, sizeof(events)) > 0) {
+                }
+            }
+            return;
+        }
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    }
+
+private:
+    int fd_ = -1;
+    int wd_ = -1;
+};
+
+} // namespace
+
+CompactResult followLog(const std::string& path,
+                        const AnalysisOptions& options,
+                        const AppConfig& config,
+                        std::shared_ptr<const IssueCatalog> catalog,
+                        const CompactIssueSink& sink,
+                        const std::atomic<bool>& stop) {
+    // A build can run for hours; only the caller decides when to stop.
+    AppConfig followConfig = config;
+    followConfig.analysis.timeoutMs = 0;
+    DiagnosticsAnalyzer analyzer(options, followConfig, std::move(catalog));
+    analyzer.setCompactIssueSink(sink);
+
+    FollowedFile file(path);
+    ChangeWaiter waiter(path);
+    SPDLOG_INFO("Following log file '{}'.", path);
+
+    using Clock = std::chrono::steady_clock;
+    const auto settle = std::chrono::milliseconds(config.analysis.followSettleMs);
+    const auto idleTimeout = std::chrono::milliseconds(config.analysis.followIdleTimeoutMs);
+    std::vector<char> buffer(kReadSize);
+    auto lastGrowth = Clock::now();
+    bool flushed = true;
+    while (!stop.load(std::memory_order_relaxed) && !analyzer.stopped()) {
+        const std::size_t got = file.read(buffer);
+        if (got > 0) {
+            analyzer.feed(std::string_view(buffer.data(), got));
+            lastGrowth = Clock::now();
+            flushed = false;
+            continue;
+        }
+        if (file.replaced() && file.reopen()) {
+            SPDLOG_INFO("Log file '{}' was truncated or replaced. Reading it from the start.", path);
+            // The old content ended where it was; its last line is not
+            // continued by the new one.
+            analyzer.restartInput();
+            flushed = true;
+            waiter.watch(path);
+            continue;
+        }
+
+        const auto idle = Clock::now() - lastGrowth;
+        if (!flushed && idle >= settle) {
+            analyzer.flushOpenBlock();
+            flushed = true;
+        }
+        if (idleTimeout.count() > 0 && idle >= idleTimeout) {
+            SPDLOG_INFO("Log file '{}' has not grown for {} ms. Stopping.", path, idleTimeout.count());
+            break;
+        }
+        waiter.wait(kPollIntervalMs);
+    }
+    return analyzer.finishCompact();
+}
+
+} // namespace template_insight
@@ -0,0 +1,221 @@
+#include "log_prepass.hpp"
+
+#include <cstring>
+
+// The vector kernels use GCC/Clang target attributes, so they are built
+// without raising the baseline of the whole library; other compilers and
+// targets use the scalar kernel.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TEMPLATE_INSIGHT_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define TEMPLATE_INSIGHT_X86_KERNELS 0
+#endif
+
+namespace template_insight {
+
+namespace {
+
+constexpr char kEscape = '\x1b';
+
+void indexScalar(std::string_view text, std::size_t from, std::vector<std::uint32_t>& ends) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    for (const char* p = begin + from; p < end;) {
+        const void* hit = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+        if (hit == nullptr) {
+            break;
+        }
+        const char* nl = static_cast<const char*>(hit);
+        ends.push_back(static_cast<std::uint32_t>(nl - begin));
+        p = nl + 1;
+    }
+}
+
+#if TEMPLATE_INSIGHT_X86_KERNELS
+
+/// Append `base` plus the position of every set bit of `mask`.
+inline void appendBits(std::uint64_t mask, std::size_t base, std::vector<std::uint32_t>& ends) {
+    while (mask != 0) {
+        ends.push_back(static_cast<std::uint32_t>(base + static_cast<std::size_t>(__builtin_ctzll(mask))));
+        mask &= mask - 1;
+    }
+}
+
+// Both kernels compare 64 bytes per step and turn the result into one bit
+// mask, so most steps (no newline) cost a few instructions.
+
+void indexSse2(std::string_view text, std::vector<std::uint32_t>& ends) {
+    const char* data = text.data();
+    const __m128i newline = _mm_set1_epi8('\n');
+    auto maskOf = [&](std::size_t at) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + at));
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline))));
+    };
+    std::size_t i = 0;
+    for (; i + 64 <= text.size(); i += 64) {
+        appendBits(maskOf(i) | maskOf(i + 16) << 16 | maskOf(i + 32) << 32 | maskOf(i + 48) << 48, i, ends);
+    }
+    indexScalar(text, i, ends);
+}
+
+__attribute__((target("avx2"))) void indexAvx2(std::string_view text, std::vector<std::uint32_t>& ends) {
+    const char* data = text.data();
+    const __m256i newline = _mm256_set1_epi8('\n');
+    std::size_t i = 0;
+    for (; i + 64 <= text.size(); i += 64) {
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+        const auto lowMask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline)));
+        const auto highMask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)));
+        appendBits(static_cast<std::uint64_t>(highMask) << 32 | lowMask, i, ends);
+    }
+    indexScalar(text, i, ends);
+}
+
+#endif
+
+} // namespace
+
+ScanKernel detectScanKernel() {
+#if TEMPLATE_INSIGHT_X86_KERNELS
+    static const ScanKernel kernel = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? ScanKernel::Avx2 : ScanKernel::Sse2;
+    }();
+    return kernel;
+#else
+    return ScanKernel::Scalar;
+#endif
+}
+
+const char* scanKernelName(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::Scalar: return "scalar";
+        case ScanKernel::Sse2:   return "sse2";
+        case ScanKernel::Avx2:   return "avx2";
+    }
+    return "unknown";
+}
+
+void indexLineEnds(std::string_view text, std::vector<std::uint32_t>& ends) {
+    indexLineEnds(text, ends, detectScanKernel());
+}
+
+void indexLineEnds(std::string_view text, std::vector<std::uint32_t>& ends, ScanKernel kernel) {
+    switch (kernel) {
+#if TEMPLATE_INSIGHT_X86_KERNELS
+        case ScanKernel::Avx2:
+            indexAvx2(text, ends);
+            return;
+        case ScanKernel::Sse2:
+            indexSse2(text, ends);
+            return;
+#endif
+        default:
+            indexScalar(text, 0, ends);
+            return;
+    }
+}
+
+bool containsEscape(std::string_view text) {
+    // glibc's memchr is vectorized already.
+    return std::memchr(text.data(), kEscape, text.size()) != nullptr;
+}
+
+void AnsiStripper::strip(std::string_view chunk, std::string& out) {
+    out.clear();
+    out.reserve(chunk.size());
+    const char* p = chunk.data();
+    const char* end = p + chunk.size();
+    while (p < end) {
+        if (state_ == State::Text) {
+            const void* hit = std::memchr(p, kEscape, static_cast<std::size_t>(end - p));
+            const char* stop = hit != nullptr ? static_cast<const char*>(hit) : end;
+            out.append(p, stop);
+            if (hit == nullptr) {
+                break;
+            }
+            ++sequences_;
+            state_ = State::Escape;
+            p = stop + 1;
+            continue;
+        }
+
+        const auto c = static_cast<unsigned char>(*p);
+        if (c == '\n') {
+            // Malformed sequence: the line ends anyway.
+            state_ = State::Text;
+            continue;
+        }
+        ++p;
+        switch (state_) {
+            case State::Escape:
+                if (c == '[') {
+                    state_ = State::Csi;
+                } else if (c == ']') {
+                    state_ = State::Osc;
+                } else if (c == static_cast<unsigned char>(kEscape)) {
+                    ++sequences_;
+                } else {
+                    state_ = c >= 0x20 && c <= 0x2f ? State::Intermediate : State::Text;
+                }
+                break;
+            case State::Intermediate:
+                if (c < 0x20 || c > 0x2f) {
+                    state_ = State::Text;
+                }
+                break;
+            case State::Csi:
+                // Parameter and intermediate bytes until the final byte.
+                if (c >= 0x40 && c <= 0x7e) {
+                    state_ = State::Text;
+                } else if (c == static_cast<unsigned char>(kEscape)) {
+                    ++sequences_;
+                    state_ = State::Escape;
+                }
+                break;
+            case State::Osc:
+                if (c == 0x07) {
+                    state_ = State::Text;
+                } else if (c == static_cast<unsigned char>(kEscape)) {
+                    state_ = State::OscEscape;
+                }
+                break;
+            case State::OscEscape:
+                // ESC \ terminates the OSC; any other ESC starts a new sequence.
+                if (c == '\\') {
+                    state_ = State::Text;
+                } else {
+                    ++sequences_;
+                    state_ = State::Escape;
+                    --p;
+                }
+                break;
+            case State::Text:
+                break;
+        }
+    }
+}
+
+std::string stripAnsiEscapes(std::string_view text) {
+    std::string out;
+    AnsiStripper().strip(text, out);
+    return out;
+}
+
+std::string_view strippedPrefix(std::string_view text, std::size_t size, std::string& scratch) {
+    if (!containsEscape(text.substr(0, size))) {
+        return text.substr(0, size);
+    }
+    AnsiStripper ansi;
+    std::string piece;
+    scratch.clear();
+    for (std::size_t pos = 0; pos < text.size() && scratch.size() < size; pos += size) {
+        ansi.strip(text.substr(pos, size), piece);
+        scratch += piece;
+    }
+    return std::string_view(scratch).substr(0, size);
+}
+
+} // namespace template_insight
@@ -1,17 +1,136 @@
+#include "analysis_cache.hpp"
 #include "api.hpp"
+#include "batch_analysis.hpp"
+#include "binary_format.hpp"
 #include "config.hpp"
+#include "issue_catalog.hpp"
+#include "issue_dedup.hpp"
+#include "json_writer.hpp"
+#include "log_follower.hpp"
+#include "mapped_file.hpp"
+#include "metrics.hpp"
+#include "server.hpp"
+#include "time_trace.hpp"
 
+#include <atomic>
+#include <csignal>
 #include <iostream>
-#include <sstream>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 
 #include <spdlog/spdlog.h>
 
 using namespace template_insight;
 
+namespace {
+
+/// Command-line options of the CLI.
+struct CliOptions {
+    /// Path to a log file to analyze. If empty, diagnostics are read from stdin.
+    std::string logPath;
+
+    /// Log file that is still being written; issues are reported as NDJSON
+    /// while it grows (see followLog()).
+    std::string followPath;
+
+    /// Stay resident and serve framed analysis requests on stdin/stdout.
+    bool server = false;
+
+    /// Compilation database whose translation units are compiled and analyzed.
+    std::string compileCommands;
+
+    /// Build directory whose clang -ftime-trace files are profiled instead of
+    /// analyzing diagnostics.
+    std::string timeTraceDir;
+
+    /// Include analysis statistics in JSON output (overrides output.stats).
+    bool stats = false;
+
+    /// Chrome trace-event file for the analysis statistics (overrides output.trace_file).
+    std::string traceFile;
+};
+
+void printUsage(const char* argv0) {
+    std::cerr << "Usage: " << argv0
+              << " [--log <path> | --follow <path> | --server | --compile-commands <path> | --time-trace <dir>]"
+                 " [--stats] [--trace <path>]\n"
+              << "  --log <path>               Analyze the given log file (memory-mapped) instead of stdin.\n"
+              << "                             gzip and zstd logs (on stdin too) are decompressed on the fly.\n"
+              << "  --follow <path>            Analyze a log while it is being written and report issues\n"
+              << "                             as NDJSON as they appear, until interrupted.\n"
+              << "  --server                   Serve length-prefixed JSON analysis requests on stdin/stdout.\n"
+              << "  --compile-commands <path>  Compile every translation unit of a compile_commands.json\n"
+              << "                             syntax-only and analyze the diagnostics.\n"
+              << "  --time-trace <dir>         Report the most expensive templates and headers from the\n"
+              << "                             clang -ftime-trace files below <dir>.\n"
+              << "  --stats                    Include phase timings and counters in JSON output.\n"
+              << "  --trace <path>             Write phase timings as a Chrome trace-event file.\n";
+}
+
+/// Parse command-line arguments.
+/// @throws std::invalid_argument on unknown or incomplete options.
+CliOptions parseCliOptions(int argc, char** argv) {
+    CliOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--log") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("--log requires a path");
+            }
+            opts.logPath = argv[++i];
+        } else if (arg == "--follow") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("--follow requires a path");
+            }
+            opts.followPath = argv[++i];
+        } else if (arg == "--compile-commands") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("--compile-commands requires a path");
+            }
+            opts.compileCommands = argv[++i];
+        } else if (arg == "--time-trace") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("--time-trace requires a directory");
+            }
+            opts.timeTraceDir = argv[++i];
+        } else if (arg == "--trace") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("--trace requires a path");
+            }
+            opts.traceFile = argv[++i];
+        } else if (arg == "--stats") {
+            opts.stats = true;
+        } else if (arg == "--server") {
+            opts.server = true;
+        } else {
+            throw std::invalid_argument("unknown option '" + arg + "'");
+        }
+    }
+    return opts;
+}
+
+/// Set by SIGINT/SIGTERM to end --follow gracefully.
+std::atomic<bool> stopRequested{false};
+
+/// The first SIGINT/SIGTERM ends following and lets the summary be written;
+/// a second one terminates as usual.
+void requestStop(int signal) {
+    stopRequested.store(true);
+    std::signal(signal, SIG_DFL);
+}
+
+} // namespace
+
 int main(int argc, char** argv) {
-    (void)argc;
-    (void)argv;
+    CliOptions cliOpts;
+    try {
+        cliOpts = parseCliOptions(argc, argv);
+    } catch (const std::invalid_argument& ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        printUsage(argv[0]);
+        return 2;
+    }
 
     try {
         // For now, we use a fixed config path. In the future you may want
@@ -28,29 +147,163 @@ int main(int argc, char** argv) {
             appCfg = AppConfig{};
         }
 
+        if (cliOpts.stats) {
+            appCfg.output.writeStats = true;
+        }
+        if (!cliOpts.traceFile.empty()) {
+            appCfg.output.traceFile = cliOpts.traceFile;
+        }
+
         // Initialize logging *before* analysis so all steps are logged.
         initLogging(appCfg.logger);
 
         SPDLOG_INFO("Template Insight CLI starting...");
         SPDLOG_INFO("Config file: {}", configPath);
 
-        // Read diagnostics from stdin.
-        std::ostringstream buffer;
-        buffer << std::cin.rdbuf();
-        const std::string logText = buffer.str();
+        // Follow mode reports issues while the build runs: one NDJSON line
+        // each, so nothing can wait for the complete result.
+        const bool follow = !cliOpts.followPath.empty();
+        if (follow && appCfg.output.format != "ndjson") {
+            SPDLOG_INFO("Follow mode writes NDJSON; ignoring output format '{}'.", appCfg.output.format);
+            appCfg.output.format = "ndjson";
+        }
+        if (follow && appCfg.analysis.deduplicateIssues) {
+            SPDLOG_WARN("Issue deduplication is not available in follow mode.");
+            appCfg.analysis.deduplicateIssues = false;
+        }
 
-        if (logText.empty()) {
-            SPDLOG_WARN("No input received from stdin. Nothing to analyze.");
+        if (cliOpts.server) {
+            // Config, issue catalog and logger stay warm for all requests.
+            AnalysisServer server(appCfg, appCfg.analysis.workerThreads);
+            server.serve(std::cin, std::cout);
+            SPDLOG_INFO("Template Insight CLI finished successfully.");
+            return 0;
         }
 
         AnalysisOptions options;
-        options.compiler = "clang"; // You can later drive this from config as well.
+        options.compiler = appCfg.analysis.compiler;
 
-        TemplateInsightResult analysisResult =
-            analyzeDiagnostics(logText, options, appCfg);
+        OutputBuffer out = appCfg.output.outputFile.empty()
+            ? OutputBuffer::standardOutput()
+            : OutputBuffer::openFile(appCfg.output.outputFile);
 
-        std::string json = serializeToJson(analysisResult);
-        std::cout << json << std::endl;
+        // JSON issues are written as they are found; the binary format needs
+        // the complete result for its string table, and deduplication needs
+        // all issues before the first one can be written.
+        const bool binary = appCfg.output.format == "binary";
+        const bool ndjson = appCfg.output.format == "ndjson";
+        const bool dedup = appCfg.analysis.deduplicateIssues;
+        std::optional<ResultJsonWriter> writer;
+        CompactIssueSink sink;
+        if (!binary) {
+            writer.emplace(out, ndjson ? ResultJsonWriter::Layout::Ndjson
+                                       : ResultJsonWriter::Layout::Document);
+            writer->setWriteStats(appCfg.output.writeStats);
+        }
+        AnalysisStats cliStats;
+        auto loadCatalog = [&]() {
+            TEMPLATE_INSIGHT_TRACE_PHASE(cliStats, Phase::RegistryLoad);
+            return IssueCatalog::load(appCfg.analysis);
+        };
+        if (writer && !dedup) {
+            sink = [&writer](const CompactResult& result, const CompactIssue& issue,
+                             const std::vector<InstantiationFrame>& frames) {
+                writer->writeIssue(result, issue, frames);
+            };
+        } else if (writer) {
+            SPDLOG_INFO("Issue deduplication is enabled; issues are written when analysis ends.");
+        }
+
+        // Log analyses produce a CompactResult, written as it is unless the
+        // binary format or deduplication needs the public representation.
+        std::optional<CompactResult> compactResult;
+        TemplateInsightResult analysisResult;
+        if (!cliOpts.compileCommands.empty()) {
+            CompileTimings timings;
+            if (!appCfg.analysis.batchTimingsFile.empty()) {
+                try {
+                    timings.load(appCfg.analysis.batchTimingsFile);
+                } catch (const std::exception& ex) {
+                    SPDLOG_WARN("{}. Scheduling without previous timings.", ex.what());
+                }
+            }
+            analysisResult = analyzeCompileCommands(loadCompileCommands(cliOpts.compileCommands), options,
+                                                    appCfg, loadCatalog(), timings);
+            if (!appCfg.analysis.batchTimingsFile.empty()) {
+                timings.save(appCfg.analysis.batchTimingsFile);
+            }
+        } else if (!cliOpts.timeTraceDir.empty()) {
+            const std::vector<std::string> traces = findTimeTraceFiles(cliOpts.timeTraceDir);
+            if (traces.empty()) {
+                SPDLOG_WARN("No time trace files found below '{}'.", cliOpts.timeTraceDir);
+            }
+            analysisResult = profileTimeTraces(traces, appCfg.analysis, *loadCatalog());
+        } else if (follow) {
+            std::signal(SIGINT, requestStop);
+            std::signal(SIGTERM, requestStop);
+            compactResult = followLog(cliOpts.followPath, options, appCfg, loadCatalog(), sink, stopRequested);
+        } else if (!cliOpts.logPath.empty()) {
+            // Zero-copy path: the analyzer scans the mapped file directly.
+            MappedFile log = MappedFile::open(cliOpts.logPath);
+            SPDLOG_INFO("Analyzing log file '{}' ({} bytes, {}).",
+                        cliOpts.logPath, log.view().size(), log.isMapped() ? "mmap" : "buffered");
+            if (log.view().empty()) {
+                SPDLOG_WARN("Log file '{}' is empty. Nothing to analyze.", cliOpts.logPath);
+            }
+            const std::shared_ptr<const IssueCatalog> catalog = loadCatalog();
+            std::unique_ptr<AnalysisCache> cache;
+            if (appCfg.analysis.cacheMaxBytes > 0) {
+                cache = std::make_unique<AnalysisCache>(appCfg.analysis.cacheMaxBytes);
+                if (!appCfg.analysis.cacheFile.empty()) {
+                    try {
+                        cache->load(appCfg.analysis.cacheFile, catalog);
+                    } catch (const std::exception& ex) {
+                        SPDLOG_WARN("{}. Starting with an empty analysis cache.", ex.what());
+                    }
+                }
+            }
+            compactResult = analyzeDiagnosticsCompact(log.view(), options, appCfg, catalog, sink, cache.get());
+            if (cache && !appCfg.analysis.cacheFile.empty()) {
+                cache->save(appCfg.analysis.cacheFile);
+            }
+        } else {
+            // Stream diagnostics from stdin; the analyzer only buffers the open diagnostic.
+            if (std::cin.peek() == std::char_traits<char>::eof()) {
+                SPDLOG_WARN("No input received from stdin. Nothing to analyze.");
+            }
+            compactResult = analyzeDiagnosticsStreamCompact(std::cin, options, appCfg, sink);
+        }
+
+        if (compactResult && (binary || dedup)) {
+            analysisResult = std::move(*compactResult).toResult();
+            compactResult.reset();
+        }
+        AnalysisStats& stats = compactResult ? compactResult->stats : analysisResult.stats;
+        stats.merge(cliStats);
+        if (dedup) {
+            deduplicateIssues(analysisResult, appCfg.analysis.maxDuplicateUnits);
+        }
+        {
+            TEMPLATE_INSIGHT_TRACE_PHASE(stats, Phase::Serialize);
+            if (binary) {
+                out.append(encodeBinaryResult(analysisResult));
+                out.flush();
+            } else {
+                if (compactResult) {
+                    writer->finish(*compactResult);
+                } else {
+                    writer->finish(analysisResult);
+                }
+                if (!ndjson) {
+                    out.append('\n');
+                    out.flush();
+                }
+            }
+        }
+        if (!appCfg.output.traceFile.empty()) {
+            writeChromeTrace(stats, appCfg.output.traceFile);
+            SPDLOG_INFO("Wrote analysis trace to '{}'.", appCfg.output.traceFile);
+        }
 
         SPDLOG_INFO("Template Insight CLI finished successfully.");
         return 0;
@@ -0,0 +1,97 @@
+#include "mapped_file.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TEMPLATE_INSIGHT_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace template_insight {
+
+MappedFile::~MappedFile() {
+    reset();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        reset();
+        mapped_ = other.mapped_;
+        size_ = other.size_;
+        buffer_ = std::move(other.buffer_);
+        data_ = mapped_ ? other.data_ : buffer_.data();
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+void MappedFile::reset() noexcept {
+#ifdef TEMPLATE_INSIGHT_HAVE_MMAP
+    if (mapped_ && data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+}
+
+MappedFile MappedFile::open(const std::string& path) {
+    MappedFile file;
+
+#ifdef TEMPLATE_INSIGHT_HAVE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("MappedFile: failed to open log file: " + path);
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        const auto size = static_cast<std::size_t>(st.st_size);
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            ::madvise(addr, size, MADV_SEQUENTIAL);
+            ::close(fd);
+            file.data_ = static_cast<const char*>(addr);
+            file.size_ = size;
+            file.mapped_ = true;
+            SPDLOG_DEBUG("Memory-mapped log file '{}' ({} bytes).", path, size);
+            return file;
+        }
+        SPDLOG_WARN("mmap of '{}' failed. Falling back to buffered read.", path);
+    }
+    ::close(fd);
+#endif
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("MappedFile: failed to open log file: " + path);
+    }
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    if (in.bad()) {
+        throw std::runtime_error("MappedFile: failed to read log file: " + path);
+    }
+    file.buffer_ = buffer.str();
+    file.data_ = file.buffer_.data();
+    file.size_ = file.buffer_.size();
+    SPDLOG_DEBUG("Read log file '{}' into buffer ({} bytes).", path, file.size_);
+    return file;
+}
+
+} // namespace template_insight
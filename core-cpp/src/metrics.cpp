@@ -0,0 +1,92 @@
+#include "metrics.hpp"
+
+#include "json_writer.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+namespace template_insight {
+
+const char* phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::RegistryLoad: return "registryLoad";
+        case Phase::Scan:         return "scan";
+        case Phase::Parse:        return "parse";
+        case Phase::Filter:       return "filter";
+        case Phase::Serialize:    return "serialize";
+    }
+    return "unknown";
+}
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+        case Counter::BytesScanned:       return "bytesScanned";
+        case Counter::Lines:              return "lines";
+        case Counter::EscapeSequences:    return "escapeSequences";
+        case Counter::Blocks:             return "blocks";
+        case Counter::PatternMatches:     return "patternMatches";
+        case Counter::Issues:             return "issues";
+        case Counter::UnclassifiedBlocks: return "unclassifiedBlocks";
+        case Counter::MergedDuplicates:   return "mergedDuplicates";
+        case Counter::CacheHits:          return "cacheHits";
+        case Counter::CacheMisses:        return "cacheMisses";
+    }
+    return "unknown";
+}
+
+void AnalysisStats::addSpan(const char* name, std::uint64_t startMicros, std::uint64_t durationMicros) {
+    const auto thread = static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    spans.push_back(Span{name, thread, startMicros, durationMicros});
+}
+
+bool AnalysisStats::empty() const {
+    auto zero = [](std::uint64_t v) { return v == 0; };
+    return spans.empty() && std::all_of(phaseMicros.begin(), phaseMicros.end(), zero) &&
+           std::all_of(counters.begin(), counters.end(), zero);
+}
+
+void AnalysisStats::merge(const AnalysisStats& other) {
+    for (std::size_t i = 0; i < kPhaseCount; ++i) {
+        phaseMicros[i] += other.phaseMicros[i];
+    }
+    for (std::size_t i = 0; i < kCounterCount; ++i) {
+        counters[i] += other.counters[i];
+    }
+    spans.insert(spans.end(), other.spans.begin(), other.spans.end());
+}
+
+void writeChromeTrace(const AnalysisStats& stats, const std::string& path) {
+    OutputBuffer out = OutputBuffer::openFile(path);
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    std::uint64_t end = 0;
+    for (std::size_t i = 0; i < stats.spans.size(); ++i) {
+        const AnalysisStats::Span& span = stats.spans[i];
+        out.append(i == 0 ? "\n{\"name\":\"" : ",\n{\"name\":\"");
+        out.appendEscaped(span.name);
+        out.append("\",\"cat\":\"analysis\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+        out.appendNumber(span.thread);
+        out.append(",\"ts\":");
+        out.appendNumber(span.startMicros);
+        out.append(",\"dur\":");
+        out.appendNumber(span.durationMicros);
+        out.append('}');
+        end = std::max(end, span.startMicros + span.durationMicros);
+    }
+
+    // Counters are totals, shown once at the end of the trace.
+    out.append(stats.spans.empty() ? "\n" : ",\n");
+    out.append("{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":");
+    out.appendNumber(end);
+    out.append(",\"args\":{");
+    for (std::size_t i = 0; i < kCounterCount; ++i) {
+        out.append(i == 0 ? "\"" : ",\"");
+        out.append(counterName(static_cast<Counter>(i)));
+        out.append("\":");
+        out.appendNumber(stats.counters[i]);
+    }
+    out.append("}}\n]}\n");
+    out.flush();
+}
+
+} // namespace template_insight
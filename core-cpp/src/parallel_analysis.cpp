@@ -0,0 +1,123 @@
+#include "analysis_cache.hpp"
+#include "analyzer.hpp"
+#include "result_merger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+CompactResult analyzeInParallel(std::string_view logText,
+                                const DiagnosticsAnalyzer& prototype,
+                                const AnalysisConfig& config,
+                                unsigned workers,
+                                AnalysisCache* cache) {
+    const auto started = std::chrono::steady_clock::now();
+    const std::size_t chunkBytes = std::max<std::size_t>(config.parallelChunkBytes, 1);
+
+    // Split at block boundaries near every multiple of chunkBytes.
+    std::vector<std::string_view> chunks;
+    for (std::size_t begin = 0; begin < logText.size();) {
+        std::size_t end = DiagnosticsAnalyzer::nextBlockBoundary(logText, std::min(begin + chunkBytes, logText.size()));
+        if (end <= begin) {
+            end = logText.size();
+        }
+        chunks.push_back(logText.substr(begin, end - begin));
+        begin = end;
+    }
+    workers = static_cast<unsigned>(std::min<std::size_t>(workers, chunks.size()));
+
+    // Every chunk is parsed as the dialect of the log as a whole.
+    DiagnosticsAnalyzer base = prototype;
+    base.resolveDialect(logText);
+    SPDLOG_INFO("Parallel analysis: {} bytes in {} chunks on {} workers.",
+                logText.size(), chunks.size(), workers);
+
+    std::vector<std::optional<CompactResult>> results(chunks.size());
+    std::atomic<std::size_t> nextChunk{0};
+    std::exception_ptr failure;
+
+    // Completed prefix of chunks. Once it alone exceeds maxIssues or ends in a
+    // truncated chunk, later chunks cannot contribute and are not started.
+    std::mutex progressMutex;
+    std::vector<bool> done(chunks.size(), false);
+    std::size_t prefixEnd = 0;
+    std::size_t prefixIssues = 0;
+
+    auto worker = [&]() {
+        try {
+            for (std::size_t i = nextChunk++; i < chunks.size(); i = nextChunk++) {
+                DiagnosticsAnalyzer analyzer = base;
+                // AnalysisConfig::timeoutMs bounds the analysis as a whole.
+                analyzer.chargeTime(std::chrono::steady_clock::now() - started);
+                AnalysisStats chunkStats;
+                {
+                    TEMPLATE_INSIGHT_TRACE_SPAN(chunkStats, "chunk");
+                    if (cache != nullptr) {
+                        results[i] = analyzeWithCache(chunks[i], analyzer, config, *cache);
+                    } else {
+                        analyzer.feed(chunks[i]);
+                        results[i] = analyzer.finishCompact();
+                    }
+                }
+                results[i]->stats.merge(chunkStats);
+
+                std::lock_guard<std::mutex> lock(progressMutex);
+                done[i] = true;
+                for (; prefixEnd < chunks.size() && done[prefixEnd]; ++prefixEnd) {
+                    prefixIssues += results[prefixEnd]->issues().size();
+                    if (prefixIssues > config.maxIssues ||
+                        results[prefixEnd]->truncation != TruncationReason::None) {
+                        nextChunk = chunks.size();
+                    }
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            nextChunk = chunks.size();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i) {
+        pool.emplace_back(worker);
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    // Merge in input order; this also applies maxIssues across chunks.
+    // Chunks that were not started (see above) come after a stopping one.
+    ResultMerger merger(config.maxIssues, prototype.catalog());
+    for (auto& part : results) {
+        if (!part || !merger.append(*part)) {
+            break;
+        }
+    }
+    if (merger.truncation() != TruncationReason::None) {
+        SPDLOG_INFO("Parallel analysis stopped early; merged result is partial.");
+    }
+    if (cache != nullptr) {
+        const AnalysisCache::Stats stats = cache->stats();
+        SPDLOG_INFO("Analysis cache: {} hits, {} misses; {} entries, {} bytes, {} evictions in total.",
+                    stats.hits, stats.misses, stats.entries, stats.bytes, stats.evictions);
+    }
+    return merger.finish();
+}
+
+} // namespace template_insight
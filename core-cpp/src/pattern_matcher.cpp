@@ -0,0 +1,95 @@
+#include "pattern_matcher.hpp"
+
+#include <algorithm>
+#include <queue>
+
+namespace template_insight {
+
+PatternMatcher::PatternMatcher(std::vector<IssuePattern> patterns) {
+    patterns.erase(std::remove_if(patterns.begin(), patterns.end(),
+                                  [](const IssuePattern& p) { return p.text.empty(); }),
+                   patterns.end());
+    patterns_ = std::move(patterns);
+    if (patterns_.empty()) {
+        return;
+    }
+
+    // Byte classes: class 0 is "does not occur in any pattern".
+    bool used[256] = {};
+    for (const auto& p : patterns_) {
+        for (char c : p.text) {
+            used[static_cast<unsigned char>(c)] = true;
+        }
+    }
+    classCount_ = 1;
+    for (int b = 0; b < 256; ++b) {
+        classOf_[b] = used[b] ? static_cast<std::uint8_t>(classCount_++) : 0;
+    }
+
+    // Trie (goto function); kNone marks a missing edge until failure links are known.
+    constexpr State kNone = ~State{0};
+    std::vector<State> next(classCount_, kNone);
+    std::vector<std::vector<std::uint32_t>> out(1);
+
+    for (std::uint32_t index = 0; index < patterns_.size(); ++index) {
+        State state = 0;
+        for (char c : patterns_[index].text) {
+            const std::size_t slot = state * classCount_ + classOf_[static_cast<unsigned char>(c)];
+            if (next[slot] == kNone) {
+                next[slot] = static_cast<State>(out.size());
+                out.emplace_back();
+                next.resize(out.size() * classCount_, kNone);
+            }
+            state = next[slot];
+        }
+        out[state].push_back(index);
+    }
+
+    // Breadth-first construction of failure links, folded directly into a
+    // complete transition table (so scanning never follows failure links).
+    const std::size_t stateCount = out.size();
+    std::vector<State> fail(stateCount, 0);
+    std::queue<State> queue;
+    for (std::size_t cls = 0; cls < classCount_; ++cls) {
+        State& target = next[cls];
+        if (target == kNone) {
+            target = 0;
+        } else {
+            fail[target] = 0;
+            queue.push(target);
+        }
+    }
+    while (!queue.empty()) {
+        const State state = queue.front();
+        queue.pop();
+        const auto& inherited = out[fail[state]];
+        out[state].insert(out[state].end(), inherited.begin(), inherited.end());
+
+        for (std::size_t cls = 0; cls < classCount_; ++cls) {
+            State& target = next[state * classCount_ + cls];
+            const State viaFail = next[fail[state] * classCount_ + cls];
+            if (target == kNone) {
+                target = viaFail;
+            } else {
+                fail[target] = viaFail;
+                queue.push(target);
+            }
+        }
+    }
+
+    transitions_ = std::move(next);
+    outputBegin_.reserve(stateCount + 1);
+    for (const auto& matches : out) {
+        outputBegin_.push_back(static_cast<std::uint32_t>(outputs_.size()));
+        // All matches of a state end at the same byte; report the one that starts first.
+        std::vector<std::uint32_t> sorted = matches;
+        std::sort(sorted.begin(), sorted.end(), [this](std::uint32_t a, std::uint32_t b) {
+            return patterns_[a].text.size() > patterns_[b].text.size() ||
+                   (patterns_[a].text.size() == patterns_[b].text.size() && a < b);
+        });
+        outputs_.insert(outputs_.end(), sorted.begin(), sorted.end());
+    }
+    outputBegin_.push_back(static_cast<std::uint32_t>(outputs_.size()));
+}
+
+} // namespace template_insight
@@ -0,0 +1,72 @@
+#include "result_merger.hpp"
+
+namespace template_insight {
+
+ResultMerger::ResultMerger(std::size_t maxIssues, std::shared_ptr<const IssueCatalog> catalog)
+    : maxIssues_(maxIssues), result_(std::move(catalog)) {
+}
+
+StringInterner::Id ResultMerger::remapString(const CompactResult& part, StringInterner::Id id) {
+    if (id == CompactIssue::kNone) {
+        return id;
+    }
+    if (id >= stringRemap_.size()) {
+        stringRemap_.resize(id + 1, CompactIssue::kNone);
+    }
+    if (stringRemap_[id] == CompactIssue::kNone) {
+        stringRemap_[id] = result_.internFile(part.interned(id));
+    }
+    return stringRemap_[id];
+}
+
+bool ResultMerger::append(const CompactResult& part) {
+    // The part was analyzed either way, so its time counts.
+    result_.stats.merge(part.stats);
+    if (truncation_ != TruncationReason::None) {
+        return false;
+    }
+    const std::vector<InstantiationFrame>& frames = part.instantiations();
+    remap_.assign(frames.size(), std::nullopt);
+    stringRemap_.clear();
+
+    for (CompactIssue issue : part.issues()) {
+        if (full()) {
+            truncation_ = TruncationReason::MaxIssues;
+            return false;
+        }
+
+        if (issue.instantiation != CompactIssue::kNone) {
+            // Collect the not yet merged frames of this stack (inner to outer) ...
+            path_.clear();
+            std::optional<std::size_t> node = issue.instantiation;
+            while (node && !remap_[*node]) {
+                path_.push_back(*node);
+                node = frames[*node].parent;
+            }
+            // ... and insert them outermost first, exactly as the analyzer did.
+            std::optional<std::size_t> parent = node ? remap_[*node] : std::nullopt;
+            for (auto it = path_.rbegin(); it != path_.rend(); ++it) {
+                parent = tree_.insertFrame(parent, frames[*it]);
+                remap_[*it] = parent;
+            }
+            issue.instantiation = static_cast<std::uint32_t>(*remap_[issue.instantiation]);
+        }
+        issue.file = remapString(part, issue.file);
+        issue.translationUnit = remapString(part, issue.translationUnit);
+
+        result_.add(issue);
+    }
+
+    truncation_ = part.truncation;
+    return truncation_ == TruncationReason::None;
+}
+
+CompactResult ResultMerger::finish() {
+    CompactResult merged = std::move(result_);
+    result_ = CompactResult(merged.catalog());
+    merged.instantiations() = tree_.take();
+    merged.truncation = truncation_;
+    return merged;
+}
+
+} // namespace template_insight
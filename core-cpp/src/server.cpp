@@ -0,0 +1,211 @@
+#include "server.hpp"
+
+#include "analysis_cache.hpp"
+#include "analyzer.hpp"
+#include "api.hpp"
+#include "issue_dedup.hpp"
+#include "json_writer.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+using nlohmann::json;
+
+void writeFrame(std::ostream& out, std::string_view payload) {
+    const auto n = static_cast<std::uint32_t>(payload.size());
+    const char header[4] = {
+        static_cast<char>((n >> 24) & 0xff),
+        static_cast<char>((n >> 16) & 0xff),
+        static_cast<char>((n >> 8) & 0xff),
+        static_cast<char>(n & 0xff),
+    };
+    out.write(header, sizeof(header));
+    out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+    out.flush();
+}
+
+bool readFrame(std::istream& in, std::string& payload) {
+    unsigned char header[4];
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (in.gcount() == 0) {
+        return false;
+    }
+    if (in.gcount() != sizeof(header)) {
+        throw std::runtime_error("AnalysisServer: truncated frame header");
+    }
+    const std::size_t n = (std::size_t{header[0]} << 24) | (std::size_t{header[1]} << 16) |
+                          (std::size_t{header[2]} << 8) | std::size_t{header[3]};
+    if (n > AnalysisServer::kMaxFrameBytes) {
+        throw std::runtime_error("AnalysisServer: frame of " + std::to_string(n) + " bytes is too large");
+    }
+    payload.resize(n);
+    in.read(payload.data(), static_cast<std::streamsize>(n));
+    if (static_cast<std::size_t>(in.gcount()) != n) {
+        throw std::runtime_error("AnalysisServer: truncated frame payload");
+    }
+    return true;
+}
+
+AnalysisServer::AnalysisServer(AppConfig config, unsigned concurrency)
+    : config_(std::move(config)),
+      concurrency_(concurrency == 0 ? std::max(1u, std::thread::hardware_concurrency()) : concurrency),
+      catalog_(IssueCatalog::load(config_.analysis)) {
+    // Requests already run concurrently; don't also split each log across cores.
+    config_.analysis.workerThreads = 1;
+
+    if (config_.analysis.cacheMaxBytes > 0) {
+        cache_ = std::make_unique<AnalysisCache>(config_.analysis.cacheMaxBytes);
+        if (!config_.analysis.cacheFile.empty()) {
+            try {
+                cache_->load(config_.analysis.cacheFile, catalog_);
+            } catch (const std::exception& ex) {
+                SPDLOG_WARN("{}. Starting with an empty analysis cache.", ex.what());
+            }
+        }
+    }
+}
+
+AnalysisServer::~AnalysisServer() = default;
+
+std::string AnalysisServer::handle(std::string_view request) const {
+    json id = nullptr;
+    try {
+        const json j = json::parse(request);
+        if (!j.is_object()) {
+            throw std::runtime_error("request must be a JSON object");
+        }
+        if (j.contains("id")) {
+            id = j["id"];
+        }
+
+        AnalysisOptions options;
+        options.compiler = config_.analysis.compiler;
+        if (j.contains("compiler") && j["compiler"].is_string()) {
+            options.compiler = j["compiler"].get<std::string>();
+        }
+
+        std::optional<CompactResult> result;
+        if (j.contains("log") && j["log"].is_string()) {
+            result = analyzeDiagnosticsCompact(j["log"].get_ref<const std::string&>(), options, config_, catalog_,
+                                               {}, cache_.get());
+        } else if (j.contains("log_file") && j["log_file"].is_string()) {
+            MappedFile log = MappedFile::open(j["log_file"].get<std::string>());
+            result = analyzeDiagnosticsCompact(log.view(), options, config_, catalog_, {}, cache_.get());
+        } else {
+            throw std::runtime_error("request needs a 'log' or 'log_file' string");
+        }
+
+        // Statistics are written per request when the request or the config asks for them.
+        const bool stats = config_.output.writeStats ||
+            (j.contains("stats") && j["stats"].is_boolean() && j["stats"].get<bool>());
+        OutputBuffer out;
+        out.append("{\"id\":");
+        out.append(id.dump());
+        out.append(",\"result\":");
+        ResultJsonWriter writer(out, ResultJsonWriter::Layout::Document);
+        writer.setWriteStats(stats);
+        if (config_.analysis.deduplicateIssues) {
+            // Deduplication works on the public representation.
+            TemplateInsightResult deduplicated = std::move(*result).toResult();
+            deduplicateIssues(deduplicated, config_.analysis.maxDuplicateUnits);
+            writer.finish(deduplicated);
+        } else {
+            writer.finish(*result);
+        }
+        out.append('}');
+        return std::move(out.str());
+    } catch (const std::exception& ex) {
+        SPDLOG_WARN("AnalysisServer: request failed: {}", ex.what());
+        // The message may quote bytes of a malformed request; never let it fail the reply.
+        return json{{"id", id}, {"error", ex.what()}}.dump(-1, ' ', false, json::error_handler_t::replace);
+    }
+}
+
+void AnalysisServer::serve(std::istream& in, std::ostream& out) {
+    SPDLOG_INFO("AnalysisServer: serving with {} workers.", concurrency_);
+
+    std::mutex mutex;
+    std::condition_variable queueChanged;
+    std::deque<std::string> queue;
+    bool closed = false;
+    const std::size_t maxQueued = 2 * static_cast<std::size_t>(concurrency_);
+    std::mutex outMutex;
+
+    auto worker = [&]() {
+        for (;;) {
+            std::string request;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queueChanged.wait(lock, [&] { return closed || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                request = std::move(queue.front());
+                queue.pop_front();
+            }
+            queueChanged.notify_all();
+
+            // An exception leaving a worker would terminate the process; drop the frame instead.
+            try {
+                const std::string response = handle(request);
+                std::lock_guard<std::mutex> lock(outMutex);
+                writeFrame(out, response);
+            } catch (const std::exception& ex) {
+                SPDLOG_ERROR("AnalysisServer: failed to answer a request: {}", ex.what());
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(concurrency_);
+    for (unsigned i = 0; i < concurrency_; ++i) {
+        pool.emplace_back(worker);
+    }
+
+    try {
+        std::string payload;
+        while (readFrame(in, payload)) {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Bounded queue: stop reading while the workers are saturated.
+            queueChanged.wait(lock, [&] { return queue.size() < maxQueued; });
+            queue.push_back(std::move(payload));
+            lock.unlock();
+            queueChanged.notify_all();
+        }
+    } catch (const std::exception& ex) {
+        SPDLOG_ERROR("AnalysisServer: {}. Stopping.", ex.what());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    queueChanged.notify_all();
+    for (auto& t : pool) {
+        t.join();
+    }
+    if (cache_ && !config_.analysis.cacheFile.empty()) {
+        try {
+            cache_->save(config_.analysis.cacheFile);
+        } catch (const std::exception& ex) {
+            SPDLOG_WARN("{}", ex.what());
+        }
+    }
+    SPDLOG_INFO("AnalysisServer: input closed, shutting down.");
+}
+
+} // namespace template_insight
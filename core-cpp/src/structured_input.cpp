@@ -0,0 +1,363 @@
+#include "structured_input.hpp"
+
+#include "analyzer.hpp"
+
+#include <istream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+using nlohmann::json;
+
+namespace {
+
+std::string_view skipWhitespace(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r' ||
+                          s.front() == '\n' || s.front() == '\xef' || s.front() == '\xbb' ||
+                          s.front() == '\xbf')) {
+        s.remove_prefix(1); // Whitespace and a UTF-8 byte order mark.
+    }
+    return s;
+}
+
+std::optional<DiagnosticKind> parseKind(std::string_view s) {
+    if (s == "error")                   return DiagnosticKind::Error;
+    if (s == "fatal error")             return DiagnosticKind::FatalError;
+    if (s == "warning")                 return DiagnosticKind::Warning;
+    if (s == "note")                    return DiagnosticKind::Note;
+    if (s == "remark" || s == "none")   return DiagnosticKind::Remark;
+    return std::nullopt;
+}
+
+/// "file:///home/u/a%20b.cpp" -> "/home/u/a b.cpp".
+std::string uriToPath(std::string_view uri) {
+    constexpr std::string_view scheme = "file://";
+    if (uri.compare(0, scheme.size(), scheme) == 0) {
+        uri.remove_prefix(scheme.size());
+    }
+    auto hexValue = [](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    std::string path;
+    path.reserve(uri.size());
+    for (std::size_t i = 0; i < uri.size(); ++i) {
+        if (uri[i] == '%' && i + 2 < uri.size() && hexValue(uri[i + 1]) >= 0 && hexValue(uri[i + 2]) >= 0) {
+            path.push_back(static_cast<char>(hexValue(uri[i + 1]) * 16 + hexValue(uri[i + 2])));
+            i += 2;
+        } else {
+            path.push_back(uri[i]);
+        }
+    }
+    return path;
+}
+
+/// SAX handler that turns SARIF / gcc JSON into StructuredDiagnostics.
+///
+/// Every open JSON object gets a role derived from its parent's role and its
+/// key; scalar values are interpreted by the role of the object holding them.
+class DiagnosticsSaxHandler final : public nlohmann::json_sax<json> {
+public:
+    DiagnosticsSaxHandler(InputFormat format, DiagnosticsAnalyzer& analyzer)
+        : format_(format), analyzer_(analyzer) {}
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t value) override { return number(value); }
+    bool number_unsigned(number_unsigned_t value) override { return number(static_cast<std::int64_t>(value)); }
+    bool number_float(number_float_t, const string_t&) override { return true; }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& value) override {
+        const std::string_view key = valueName();
+        switch (top()) {
+            case Role::Diagnostic:
+            case Role::Note:
+                if (key == (format_ == InputFormat::Sarif ? "level" : "kind")) {
+                    if (auto kind = parseKind(value); kind && top() == Role::Diagnostic) {
+                        diagnostic_.kind = *kind;
+                    }
+                } else if (key == "message" && format_ == InputFormat::GccJson) {
+                    ownerMessage() = std::move(value);
+                }
+                break;
+            case Role::Message:
+                if (key == "text") {
+                    ownerMessage() = std::move(value);
+                }
+                break;
+            case Role::Position:
+                if (key == "file") {
+                    ownerLocation().file = std::move(value);
+                }
+                break;
+            case Role::Artifact:
+                if (key == "uri") {
+                    ownerLocation().file = uriToPath(value);
+                }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        stack_.push_back({childRole(valueName()), false, {}});
+        if (top() == Role::Diagnostic) {
+            diagnostic_ = StructuredDiagnostic{};
+        } else if (top() == Role::Note) {
+            diagnostic_.notes.emplace_back();
+        } else if (top() == Role::Location) {
+            // Only the first location of a diagnostic or note is used.
+            auto& location = ownerLocationSlot();
+            if (location) {
+                stack_.back().role = Role::Ignored;
+            } else {
+                location.emplace();
+            }
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        const Role role = top();
+        stack_.pop_back();
+        if (role == Role::Diagnostic) {
+            return finishDiagnostic();
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        stack_.push_back({top() == Role::Ignored ? Role::Ignored : Role::None, true, std::string(valueName())});
+        return true;
+    }
+
+    bool end_array() override {
+        stack_.pop_back();
+        return true;
+    }
+
+    bool key(string_t& value) override {
+        stack_.back().key = std::move(value);
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+        throw std::runtime_error("Structured diagnostics: invalid JSON at byte " + std::to_string(position) +
+                                 ": " + ex.what());
+    }
+
+    /// Hand over the last SARIF diagnostic, which may still collect notes.
+    void flush() {
+        if (hasPending_) {
+            analyzer_.addDiagnostic(pending_);
+            hasPending_ = false;
+        }
+    }
+
+private:
+    enum class Role {
+        None,       ///< Not interesting, but its children may be.
+        Ignored,    ///< Skip the whole subtree.
+        Diagnostic, ///< gcc diagnostic / SARIF result.
+        Note,       ///< gcc child diagnostic / SARIF related location.
+        Message,    ///< SARIF message object ("text").
+        Location,   ///< gcc locations[] / SARIF locations[] element.
+        Physical,   ///< SARIF physicalLocation.
+        Artifact,   ///< SARIF artifactLocation ("uri").
+        Position    ///< gcc caret / SARIF region.
+    };
+
+    struct Level {
+        Role role;
+        bool isArray;
+        /// Object: last key seen. Array: the key the array is stored under.
+        std::string key;
+    };
+
+    Role top() const { return stack_.empty() ? Role::None : stack_.back().role; }
+
+    /// Name of the value about to start: its key, or for array elements the
+    /// key of the array followed by "[]".
+    std::string_view valueName() {
+        if (stack_.empty()) {
+            return {};
+        }
+        if (stack_.back().isArray) {
+            elementName_ = stack_.back().key + "[]";
+            return elementName_;
+        }
+        return stack_.back().key;
+    }
+
+    /// Nearest enclosing diagnostic or note role (from the object level up).
+    Role owner() const {
+        for (auto it = stack_.rbegin(); it != stack_.rend(); ++it) {
+            if (it->role == Role::Diagnostic || it->role == Role::Note) {
+                return it->role;
+            }
+        }
+        return Role::None;
+    }
+
+    std::string& ownerMessage() {
+        return owner() == Role::Note ? diagnostic_.notes.back().message : diagnostic_.message;
+    }
+    std::optional<SourceLocation>& ownerLocationSlot() {
+        return owner() == Role::Note ? diagnostic_.notes.back().location : diagnostic_.location;
+    }
+    SourceLocation& ownerLocation() {
+        auto& slot = ownerLocationSlot();
+        if (!slot) {
+            slot.emplace();
+        }
+        return *slot;
+    }
+
+    Role childRole(std::string_view name) const {
+        const Role parent = top();
+        const bool sarif = format_ == InputFormat::Sarif;
+        if (parent == Role::Ignored) {
+            return Role::Ignored;
+        }
+        if (stack_.empty()) {
+            return Role::None;
+        }
+        if (!sarif && stack_.size() == 1 && stack_.back().isArray) {
+            return Role::Diagnostic; // Top-level array of gcc diagnostics.
+        }
+        if (sarif && name == "results[]" && stack_.size() >= 2 &&
+            stack_[stack_.size() - 2].role == Role::None) {
+            return Role::Diagnostic; // runs[].results[]
+        }
+        // Array levels carry no role; look at the object holding the array.
+        Role holder = parent;
+        if (stack_.back().isArray && stack_.size() >= 2) {
+            holder = stack_[stack_.size() - 2].role;
+        }
+        const bool inOwner = holder == Role::Diagnostic || holder == Role::Note;
+        if (inOwner && name == (sarif ? "relatedLocations[]" : "children[]")) {
+            return Role::Note;
+        }
+        if (inOwner && name == "locations[]") {
+            return Role::Location;
+        }
+        if (sarif && inOwner && name == "message") {
+            return Role::Message;
+        }
+        if (sarif && (holder == Role::Location || holder == Role::Note) && name == "physicalLocation") {
+            return Role::Physical;
+        }
+        if (sarif && holder == Role::Physical && name == "artifactLocation") {
+            return Role::Artifact;
+        }
+        if (sarif && holder == Role::Physical && name == "region") {
+            return Role::Position;
+        }
+        if (!sarif && holder == Role::Location && name == "caret") {
+            return Role::Position;
+        }
+        return inOwner || holder == Role::Location ? Role::Ignored : Role::None;
+    }
+
+    bool number(std::int64_t value) {
+        if (top() != Role::Position) {
+            return true;
+        }
+        const std::string_view key = valueName();
+        const int v = static_cast<int>(value);
+        if (key == (format_ == InputFormat::Sarif ? "startLine" : "line")) {
+            ownerLocation().line = v;
+        } else if (key == (format_ == InputFormat::Sarif ? "startColumn" : "column")) {
+            ownerLocation().column = v;
+        }
+        return true;
+    }
+
+    bool finishDiagnostic() {
+        if (format_ == InputFormat::GccJson) {
+            analyzer_.addDiagnostic(diagnostic_);
+        } else if (diagnostic_.kind == DiagnosticKind::Note || diagnostic_.kind == DiagnosticKind::Remark) {
+            // clang reports each note as a result of its own.
+            if (hasPending_) {
+                pending_.notes.push_back({std::move(diagnostic_.message), std::move(diagnostic_.location)});
+                for (auto& note : diagnostic_.notes) {
+                    pending_.notes.push_back(std::move(note));
+                }
+            }
+        } else {
+            flush();
+            pending_ = std::move(diagnostic_);
+            hasPending_ = true;
+        }
+        return !analyzer_.stopped();
+    }
+
+    InputFormat format_;
+    DiagnosticsAnalyzer& analyzer_;
+    std::vector<Level> stack_;
+    std::string elementName_;
+    StructuredDiagnostic diagnostic_;
+    /// SARIF: the last error/warning, kept until its trailing notes are read.
+    StructuredDiagnostic pending_;
+    bool hasPending_ = false;
+};
+
+template <typename Input>
+void parseStructured(Input&& input, InputFormat format, DiagnosticsAnalyzer& analyzer) {
+    if (format == InputFormat::Text) {
+        throw std::invalid_argument("feedStructuredDiagnostics: text input is not structured");
+    }
+    DiagnosticsSaxHandler handler(format, analyzer);
+    json::sax_parse(std::forward<Input>(input), &handler);
+    handler.flush();
+}
+
+} // namespace
+
+InputFormat resolveInputFormat(const std::string& compiler, std::string_view head) {
+    if (compiler == "sarif") {
+        return InputFormat::Sarif;
+    }
+    if (compiler == "gcc-json") {
+        return InputFormat::GccJson;
+    }
+
+    head = skipWhitespace(head);
+    if (head.empty()) {
+        return InputFormat::Text;
+    }
+    if (head.front() == '{') {
+        // SARIF logs are objects; no text diagnostic starts with '{'.
+        return InputFormat::Sarif;
+    }
+    if (head.front() == '[') {
+        // gcc JSON is an array of objects; "[1/20] Building ..." is build noise.
+        const std::string_view rest = skipWhitespace(head.substr(1));
+        if (!rest.empty() && (rest.front() == '{' || rest.front() == ']')) {
+            return InputFormat::GccJson;
+        }
+    }
+    return InputFormat::Text;
+}
+
+void feedStructuredDiagnostics(std::string_view text, InputFormat format, DiagnosticsAnalyzer& analyzer) {
+    SPDLOG_INFO("Parsing {} structured diagnostics ({} bytes).",
+                format == InputFormat::Sarif ? "SARIF" : "gcc JSON", text.size());
+    parseStructured(text, format, analyzer);
+}
+
+void feedStructuredDiagnostics(std::istream& in, InputFormat format, DiagnosticsAnalyzer& analyzer) {
+    SPDLOG_INFO("Parsing {} structured diagnostics from a stream.",
+                format == InputFormat::Sarif ? "SARIF" : "gcc JSON");
+    parseStructured(in, format, analyzer);
+}
+
+} // namespace template_insight
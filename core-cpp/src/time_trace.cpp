@@ -0,0 +1,366 @@
+#include "time_trace.hpp"
+
+#include "issue_catalog.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+namespace template_insight {
+
+using nlohmann::json;
+
+/// SAX handler reading the "traceEvents" array of one trace file.
+///
+/// Complete events ("ph": "X") carry their duration; "Source" events of newer
+/// clang versions come as nested begin/end pairs ("b" / "e") instead.
+class TimeTraceProfile::Handler final : public nlohmann::json_sax<json> {
+public:
+    explicit Handler(TimeTraceProfile& profile) : profile_(profile) {}
+
+    bool sawEvents() const { return sawEvents_; }
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t value) override { return number(static_cast<double>(value)); }
+    bool number_unsigned(number_unsigned_t value) override { return number(static_cast<double>(value)); }
+    bool number_float(number_float_t value, const string_t&) override { return number(value); }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& value) override {
+        if (inEvent()) {
+            if (key_ == "name") {
+                event_.name = std::move(value);
+            } else if (key_ == "ph") {
+                event_.phase = value.empty() ? '\0' : value.front();
+            }
+        } else if (inArgs() && key_ == "detail") {
+            event_.detail = std::move(value);
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        ++depth_;
+        if (depth_ == 1) {
+            level_ = Level::Root;
+        } else if (level_ == Level::Events && depth_ == 3) {
+            level_ = Level::Event;
+            event_ = Event{};
+        } else if (level_ == Level::Event && depth_ == 4 && key_ == "args") {
+            level_ = Level::Args;
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        --depth_;
+        if (level_ == Level::Args && depth_ == 3) {
+            level_ = Level::Event;
+        } else if (level_ == Level::Event && depth_ == 2) {
+            level_ = Level::Events;
+            finishEvent();
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (depth_ == 0) {
+            return false; // A trace file is an object; stop reading anything else.
+        }
+        ++depth_;
+        if (level_ == Level::Root && depth_ == 2 && key_ == "traceEvents") {
+            level_ = Level::Events;
+            sawEvents_ = true;
+        }
+        return true;
+    }
+
+    bool end_array() override {
+        --depth_;
+        if (level_ == Level::Events && depth_ == 1) {
+            level_ = Level::Root;
+        }
+        return true;
+    }
+
+    bool key(string_t& value) override {
+        key_ = std::move(value);
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+        throw std::runtime_error("invalid JSON at byte " + std::to_string(position) + ": " + ex.what());
+    }
+
+private:
+    enum class Level { Root, Events, Event, Args };
+
+    struct Event {
+        std::string name;
+        std::string detail;
+        char phase = '\0';
+        double timestamp = 0;
+        double duration = 0;
+        std::int64_t thread = 0;
+    };
+
+    /// Directly inside an event object (not in a nested value).
+    bool inEvent() const { return level_ == Level::Event && depth_ == 3; }
+    bool inArgs() const { return level_ == Level::Args && depth_ == 4; }
+
+    bool number(double value) {
+        if (inEvent()) {
+            if (key_ == "dur") {
+                event_.duration = value;
+            } else if (key_ == "ts") {
+                event_.timestamp = value;
+            } else if (key_ == "tid") {
+                event_.thread = static_cast<std::int64_t>(value);
+            }
+        }
+        return true;
+    }
+
+    void finishEvent() {
+        if (event_.phase == 'X') {
+            const auto microseconds = static_cast<std::uint64_t>(std::max(event_.duration, 0.0));
+            if (event_.name == "InstantiateClass" || event_.name == "InstantiateFunction") {
+                profile_.add(profile_.instantiations_, event_.detail, microseconds);
+            } else if (event_.name == "Source") {
+                profile_.add(profile_.headers_, event_.detail, microseconds);
+            } else if (event_.name == "Frontend") {
+                profile_.frontendMicroseconds_ += microseconds;
+            }
+        } else if (event_.name == "Source" && event_.phase == 'b') {
+            open_.push_back({event_.thread, event_.timestamp, std::move(event_.detail)});
+        } else if (event_.name == "Source" && event_.phase == 'e') {
+            // Begin/end pairs nest, so the end closes the latest begin of its thread.
+            for (auto it = open_.rbegin(); it != open_.rend(); ++it) {
+                if (it->thread == event_.thread) {
+                    const double duration = std::max(event_.timestamp - it->timestamp, 0.0);
+                    profile_.add(profile_.headers_, it->detail, static_cast<std::uint64_t>(duration));
+                    open_.erase(std::next(it).base());
+                    break;
+                }
+            }
+        }
+    }
+
+    struct OpenSource {
+        std::int64_t thread;
+        double timestamp;
+        std::string detail;
+    };
+
+    TimeTraceProfile& profile_;
+    Level level_ = Level::Root;
+    int depth_ = 0;
+    bool sawEvents_ = false;
+    std::string key_;
+    Event event_;
+    std::vector<OpenSource> open_;
+};
+
+bool TimeTraceProfile::addFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("cannot open '" + path + "'");
+    }
+    // Aggregated on its own first, so a file that fails halfway adds nothing.
+    TimeTraceProfile file;
+    Handler handler(file);
+    try {
+        json::sax_parse(in, &handler);
+    } catch (const std::exception& ex) {
+        throw std::runtime_error("'" + path + "': " + ex.what());
+    }
+    if (!handler.sawEvents()) {
+        return false;
+    }
+    for (auto* costs : {&file.instantiations_, &file.headers_}) {
+        for (auto& entry : *costs) {
+            entry.second.translationUnits = 1;
+        }
+    }
+    file.files_ = 1;
+    merge(std::move(file));
+    return true;
+}
+
+void TimeTraceProfile::add(std::unordered_map<std::string, Cost>& costs, const std::string& name,
+                           std::uint64_t microseconds) {
+    if (name.empty()) {
+        return;
+    }
+    Cost& cost = costs[name];
+    cost.microseconds += microseconds;
+    ++cost.count;
+}
+
+void TimeTraceProfile::merge(TimeTraceProfile&& other) {
+    auto mergeCosts = [](std::unordered_map<std::string, Cost>& into, std::unordered_map<std::string, Cost>& from) {
+        if (into.empty()) {
+            into.swap(from);
+            return;
+        }
+        for (auto& [name, cost] : from) {
+            Cost& target = into[name];
+            target.microseconds += cost.microseconds;
+            target.count += cost.count;
+            target.translationUnits += cost.translationUnits;
+        }
+    };
+    mergeCosts(instantiations_, other.instantiations_);
+    mergeCosts(headers_, other.headers_);
+    frontendMicroseconds_ += other.frontendMicroseconds_;
+    files_ += other.files_;
+}
+
+std::vector<std::string> findTimeTraceFiles(const std::string& directory) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        throw std::runtime_error("Cannot read directory '" + directory + "': " + ec.message());
+    }
+    for (const fs::recursive_directory_iterator end; it != end; it.increment(ec)) {
+        if (ec) {
+            throw std::runtime_error("Cannot read directory '" + directory + "': " + ec.message());
+        }
+        const fs::path& path = it->path();
+        if (it->is_regular_file(ec) && path.extension() == ".json" && path.filename() != "compile_commands.json") {
+            files.push_back(path.string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+namespace {
+
+std::string formatMilliseconds(std::uint64_t microseconds) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f ms", static_cast<double>(microseconds) / 1000.0);
+    return text;
+}
+
+/// The `topN` most expensive entries of `costs` as issues of kind `code`.
+void reportTop(const std::unordered_map<std::string, TimeTraceProfile::Cost>& costs,
+               const char* code, std::size_t topN, std::uint64_t frontendMicroseconds,
+               const IssueCatalog& catalog, TemplateInsightResult& result) {
+    const std::optional<IssueKindId> id = catalog.findId(code);
+    if (!id || !catalog.enabled(*id) || topN == 0) {
+        return;
+    }
+    using Entry = const std::pair<const std::string, TimeTraceProfile::Cost>*;
+    std::vector<Entry> ranked;
+    ranked.reserve(costs.size());
+    for (const auto& entry : costs) {
+        ranked.push_back(&entry);
+    }
+    const auto byCost = [](Entry a, Entry b) {
+        return a->second.microseconds != b->second.microseconds
+            ? a->second.microseconds > b->second.microseconds
+            : a->first < b->first;
+    };
+    const std::size_t n = std::min(topN, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(n), ranked.end(), byCost);
+
+    const bool header = code == std::string_view(IssueCodes::EXPENSIVE_HEADER);
+    const IssueKind& kind = catalog.kind(*id);
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto& [name, cost] = *ranked[i];
+        TemplateIssue issue;
+        issue.code = kind.code;
+        issue.category = kind.category;
+        issue.severity = kind.defaultSeverity;
+        issue.shortMessage = kind.defaultShortMessage;
+
+        std::string detail = header ? "Parsing '" + name + "' took " : "Instantiating '" + name + "' took ";
+        detail += formatMilliseconds(cost.microseconds);
+        detail += " in " + std::to_string(cost.count) + (header ? " inclusions" : " instantiations");
+        detail += " across " + std::to_string(cost.translationUnits) + " translation units";
+        if (frontendMicroseconds > 0) {
+            char share[48];
+            std::snprintf(share, sizeof(share), " (%.1f%% of frontend time)",
+                          100.0 * static_cast<double>(cost.microseconds) / static_cast<double>(frontendMicroseconds));
+            detail += share;
+        }
+        detail += ".\n";
+        detail += kind.defaultDetailedMessage;
+        issue.detailedMessage = std::move(detail);
+        if (header) {
+            issue.location = SourceLocation{name, 0, 0};
+        }
+        result.issues.push_back(std::move(issue));
+    }
+}
+
+} // namespace
+
+TemplateInsightResult profileTimeTraces(const std::vector<std::string>& files,
+                                        const AnalysisConfig& config,
+                                        const IssueCatalog& catalog) {
+    unsigned workers = config.workerThreads;
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(workers, files.size())));
+    SPDLOG_INFO("Profiling {} time trace files on {} workers.", files.size(), workers);
+
+    // Each worker aggregates into its own profile; only the aggregates are merged.
+    std::vector<TimeTraceProfile> profiles(workers);
+    std::atomic<std::size_t> nextFile{0};
+    std::atomic<std::size_t> failed{0};
+    auto worker = [&](TimeTraceProfile& profile) {
+        for (std::size_t i = nextFile++; i < files.size(); i = nextFile++) {
+            try {
+                if (!profile.addFile(files[i])) {
+                    SPDLOG_DEBUG("'{}' is not a time trace, skipped.", files[i]);
+                }
+            } catch (const std::exception& ex) {
+                ++failed;
+                SPDLOG_WARN("Skipping time trace {}", ex.what());
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned i = 1; i < workers; ++i) {
+        pool.emplace_back(worker, std::ref(profiles[i]));
+    }
+    worker(profiles[0]);
+    for (auto& t : pool) {
+        t.join();
+    }
+    TimeTraceProfile& profile = profiles[0];
+    for (unsigned i = 1; i < workers; ++i) {
+        profile.merge(std::move(profiles[i]));
+    }
+    SPDLOG_INFO("Profiled {} time traces ({} failed): {} templates, {} headers, {} frontend time.",
+                profile.files(), failed.load(), profile.instantiations().size(), profile.headers().size(),
+                formatMilliseconds(profile.frontendMicroseconds()));
+
+    TemplateInsightResult result;
+    reportTop(profile.instantiations(), IssueCodes::EXPENSIVE_INSTANTIATION, config.profileTopN,
+              profile.frontendMicroseconds(), catalog, result);
+    reportTop(profile.headers(), IssueCodes::EXPENSIVE_HEADER, config.profileTopN,
+              profile.frontendMicroseconds(), catalog, result);
+    return result;
+}
+
+} // namespace template_insight
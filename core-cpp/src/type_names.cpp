@@ -0,0 +1,563 @@
+#include "type_names.hpp"
+
+#include <array>
+#include <limits>
+#include <unordered_map>
+
+namespace template_insight {
+
+namespace {
+
+constexpr std::uint64_t kHashBase = 0x100000001b3ULL;
+
+/// Deeper nesting is rejected rather than parsed (the parser is recursive).
+constexpr std::uint32_t kMaxNesting = 1024;
+
+/// Inline namespaces of the standard libraries ("std::__1::vector" is shown as
+/// "std::vector").
+constexpr std::array<std::string_view, 3> kInlineNamespaces = {"__1::", "__cxx11::", "__ndk1::"};
+
+/// Template whose trailing arguments are dropped when they equal the defaults.
+/// In a default, "$N" stands for the N-th argument.
+struct DefaultArguments {
+    std::string_view name;
+    std::size_t firstDefault;
+    std::array<std::string_view, 3> defaults;
+};
+
+constexpr DefaultArguments kDefaultArguments[] = {
+    {"std::vector", 1, {"std::allocator<$0>"}},
+    {"std::deque", 1, {"std::allocator<$0>"}},
+    {"std::list", 1, {"std::allocator<$0>"}},
+    {"std::forward_list", 1, {"std::allocator<$0>"}},
+    {"std::basic_string", 1, {"std::char_traits<$0>", "std::allocator<$0>"}},
+    {"std::basic_string_view", 1, {"std::char_traits<$0>"}},
+    {"std::basic_ostream", 1, {"std::char_traits<$0>"}},
+    {"std::basic_istream", 1, {"std::char_traits<$0>"}},
+    {"std::set", 1, {"std::less<$0>", "std::allocator<$0>"}},
+    {"std::multiset", 1, {"std::less<$0>", "std::allocator<$0>"}},
+    {"std::map", 2, {"std::less<$0>", "std::allocator<std::pair<const $0, $1>>"}},
+    {"std::multimap", 2, {"std::less<$0>", "std::allocator<std::pair<const $0, $1>>"}},
+    {"std::unordered_set", 1, {"std::hash<$0>", "std::equal_to<$0>", "std::allocator<$0>"}},
+    {"std::unordered_multiset", 1, {"std::hash<$0>", "std::equal_to<$0>", "std::allocator<$0>"}},
+    {"std::unordered_map", 2, {"std::hash<$0>", "std::equal_to<$0>", "std::allocator<std::pair<const $0, $1>>"}},
+    {"std::unordered_multimap", 2,
+     {"std::hash<$0>", "std::equal_to<$0>", "std::allocator<std::pair<const $0, $1>>"}},
+    {"std::unique_ptr", 1, {"std::default_delete<$0>"}},
+    {"std::stack", 1, {"std::deque<$0>"}},
+    {"std::queue", 1, {"std::deque<$0>"}},
+};
+
+/// Template-id shown by its typedef name once default arguments are dropped.
+struct Alias {
+    std::string_view name;
+    std::string_view argument;
+    std::string_view alias;
+};
+
+constexpr Alias kAliases[] = {
+    {"std::basic_string", "char", "std::string"},
+    {"std::basic_string", "wchar_t", "std::wstring"},
+    {"std::basic_string", "char8_t", "std::u8string"},
+    {"std::basic_string", "char16_t", "std::u16string"},
+    {"std::basic_string", "char32_t", "std::u32string"},
+    {"std::basic_string_view", "char", "std::string_view"},
+    {"std::basic_string_view", "wchar_t", "std::wstring_view"},
+    {"std::basic_ostream", "char", "std::ostream"},
+    {"std::basic_istream", "char", "std::istream"},
+};
+
+bool isIdentChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/// Polynomial hash of a canonical spelling. Hashes of adjacent pieces combine,
+/// so a node's hash is built from its children's without rereading them.
+struct SpellingHash {
+    std::uint64_t value = 0;
+    std::uint64_t power = 1;
+    std::uint32_t length = 0;
+
+    void add(char c) {
+        value = value * kHashBase + static_cast<unsigned char>(c);
+        power *= kHashBase;
+        ++length;
+    }
+    void add(std::string_view s) {
+        for (const char c : s) {
+            add(c);
+        }
+    }
+    void add(const SpellingHash& h) {
+        value = value * h.power + h.value;
+        power *= h.power;
+        length += h.length;
+    }
+    bool operator==(const SpellingHash& other) const { return value == other.value && length == other.length; }
+    bool operator!=(const SpellingHash& other) const { return !(*this == other); }
+};
+
+SpellingHash hashOf(std::string_view s) {
+    SpellingHash h;
+    h.add(s);
+    return h;
+}
+
+/// Call `fn` with the pieces of `text` that remain once inline namespaces are removed.
+template <typename Fn>
+void forEachNormalizedPiece(std::string_view text, Fn&& fn) {
+    std::size_t start = 0;
+    std::size_t i = 0;
+    while (i + 1 < text.size()) {
+        if (text[i] != ':' || text[i + 1] != ':') {
+            ++i;
+            continue;
+        }
+        i += 2;
+        for (const std::string_view ns : kInlineNamespaces) {
+            if (text.compare(i, ns.size(), ns) == 0) {
+                fn(text.substr(start, i - start));
+                i += ns.size();
+                start = i;
+                break;
+            }
+        }
+    }
+    fn(text.substr(start));
+}
+
+/// Hash of a default-argument pattern with "$N" replaced by `args[N]`.
+bool hashPattern(std::string_view pattern, const std::vector<SpellingHash>& args, SpellingHash& out) {
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] == '$' && i + 1 < pattern.size()) {
+            const std::size_t arg = static_cast<std::size_t>(pattern[++i] - '0');
+            if (arg >= args.size()) {
+                return false;
+            }
+            out.add(args[arg]);
+        } else {
+            out.add(pattern[i]);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+class TypeNameTree::Parser {
+public:
+    explicit Parser(TypeNameTree& tree) : tree_(tree), s_(tree.source_) {}
+
+    bool run() {
+        skipSpaces();
+        const std::optional<NodeId> root = parseNode(true, 0);
+        if (!root) {
+            return false;
+        }
+        tree_.root_ = *root;
+        return true;
+    }
+
+private:
+    using Kind = Item::Kind;
+
+    void skipSpaces() {
+        while (pos_ < s_.size() && isSpace(s_[pos_])) {
+            ++pos_;
+        }
+    }
+
+    /// Length of the operator name at pos_ if it follows the keyword
+    /// "operator" ("operator<<", "operator>", "operator,"), else 0.
+    std::size_t operatorLength() const {
+        constexpr std::string_view kKeyword = "operator";
+        if (pos_ < kKeyword.size() || s_.compare(pos_ - kKeyword.size(), kKeyword.size(), kKeyword) != 0 ||
+            (pos_ > kKeyword.size() && isIdentChar(s_[pos_ - kKeyword.size() - 1]))) {
+            return 0;
+        }
+        for (const std::string_view op : {"<=>", "<<=", ">>=", "<<", ">>", "<=", ">=", "<", ">", ","}) {
+            if (s_.compare(pos_, op.size(), op) == 0) {
+                return op.size();
+            }
+        }
+        return 0;
+    }
+
+    void addText(std::size_t begin, std::size_t end) {
+        if (end > begin) {
+            scratch_.push_back({Kind::Text, 0, static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end)});
+        }
+    }
+
+    /// Parse a node starting at pos_. Template arguments (!top) end before a
+    /// ',' or '>' outside of brackets; the top node runs to the end of the text.
+    std::optional<NodeId> parseNode(bool top, std::uint32_t nesting) {
+        if (nesting > kMaxNesting) {
+            return std::nullopt;
+        }
+        const std::size_t mark = scratch_.size();
+        const std::size_t begin = pos_;
+        std::size_t textBegin = pos_;
+        int brackets = 0;
+        while (pos_ < s_.size()) {
+            const char c = s_[pos_];
+            if (c == '<' || c == '>' || c == ',') {
+                if (const std::size_t op = operatorLength()) {
+                    pos_ += op;
+                    continue;
+                }
+            }
+            if (c == '(' || c == '[' || c == '{') {
+                ++brackets;
+            } else if (c == ')' || c == ']' || c == '}') {
+                if (brackets > 0) {
+                    --brackets;
+                } else if (!top) {
+                    return std::nullopt;
+                }
+            } else if (c == '-' && pos_ + 1 < s_.size() && s_[pos_ + 1] == '>') {
+                pos_ += 2;
+                continue;
+            } else if (!top && brackets == 0 && (c == ',' || c == '>')) {
+                break;
+            } else if (c == '<' && pos_ > 0 && isIdentChar(s_[pos_ - 1])) {
+                addText(textBegin, pos_);
+                if (!parseList(nesting)) {
+                    return std::nullopt;
+                }
+                textBegin = pos_;
+                continue;
+            }
+            ++pos_;
+        }
+        if (!top && pos_ >= s_.size()) {
+            return std::nullopt;
+        }
+        addText(textBegin, pos_);
+        return finishNode(mark, begin);
+    }
+
+    /// Parse "<arg, arg, ...>" at pos_ into the current node's items.
+    bool parseList(std::uint32_t nesting) {
+        scratch_.push_back({Kind::Open, 0, 0, 0});
+        ++pos_;
+        skipSpaces();
+        if (pos_ < s_.size() && s_[pos_] == '>') {
+            ++pos_;
+            scratch_.push_back({Kind::Close, 0, 0, 0});
+            return true;
+        }
+        for (;;) {
+            skipSpaces();
+            const std::optional<NodeId> child = parseNode(false, nesting + 1);
+            if (!child) {
+                return false;
+            }
+            scratch_.push_back({Kind::Child, 0, *child, 0});
+            if (s_[pos_++] == '>') {
+                break;
+            }
+        }
+        scratch_.push_back({Kind::Close, 0, 0, 0});
+        return true;
+    }
+
+    NodeId finishNode(std::size_t mark, std::size_t begin) {
+        std::size_t end = pos_;
+        while (end > begin && isSpace(s_[end - 1])) {
+            --end;
+        }
+        if (scratch_.size() > mark && scratch_.back().kind == Kind::Text) {
+            Item& last = scratch_.back();
+            last.b = static_cast<std::uint32_t>(std::min<std::size_t>(last.b, end));
+            if (last.a >= last.b) {
+                scratch_.pop_back();
+            }
+        }
+
+        Node node;
+        node.begin = static_cast<std::uint32_t>(begin);
+        node.end = static_cast<std::uint32_t>(end);
+        for (std::size_t i = mark; i < scratch_.size(); ++i) {
+            if (scratch_[i].kind == Kind::Open) {
+                resolveList(i);
+                node.templateId = true;
+            }
+        }
+        const SpellingHash hash = hashItems(mark);
+        node.hash = hash.value;
+        node.power = hash.power;
+        node.length = hash.length;
+
+        node.firstItem = static_cast<std::uint32_t>(tree_.items_.size());
+        node.itemCount = static_cast<std::uint32_t>(scratch_.size() - mark);
+        tree_.items_.insert(tree_.items_.end(), scratch_.begin() + static_cast<std::ptrdiff_t>(mark), scratch_.end());
+        scratch_.resize(mark);
+
+        tree_.nodes_.push_back(node);
+        return static_cast<NodeId>(tree_.nodes_.size() - 1);
+    }
+
+    SpellingHash childHash(NodeId id) const {
+        const Node& child = tree_.nodes_[id];
+        return {child.hash, child.power, child.length};
+    }
+
+    /// Decide how many arguments of the list opened at scratch_[open] are
+    /// shown and whether the template-id is replaced by an alias.
+    void resolveList(std::size_t open) {
+        // '<' only opens a list right after an identifier, so text precedes it.
+        const Item& text = scratch_[open - 1];
+        std::uint32_t nameBegin = text.b;
+        while (nameBegin > text.a && (isIdentChar(s_[nameBegin - 1]) || s_[nameBegin - 1] == ':')) {
+            --nameBegin;
+        }
+        name_.clear();
+        forEachNormalizedPiece(s_.substr(nameBegin, text.b - nameBegin), [this](std::string_view piece) {
+            name_.append(piece);
+        });
+
+        args_.clear();
+        for (std::size_t i = open + 1; scratch_[i].kind == Kind::Child; ++i) {
+            args_.push_back(childHash(scratch_[i].a));
+        }
+
+        std::size_t kept = args_.size();
+        for (const DefaultArguments& rule : kDefaultArguments) {
+            if (rule.name != name_) {
+                continue;
+            }
+            while (kept > rule.firstDefault) {
+                const std::size_t index = kept - 1 - rule.firstDefault;
+                SpellingHash expected;
+                if (index >= rule.defaults.size() || rule.defaults[index].empty() ||
+                    !hashPattern(rule.defaults[index], args_, expected) || expected != args_[kept - 1]) {
+                    break;
+                }
+                --kept;
+            }
+            break;
+        }
+
+        Item& item = scratch_[open];
+        item.b = static_cast<std::uint32_t>(kept);
+        if (kept == 1) {
+            for (std::size_t i = 0; i < std::size(kAliases); ++i) {
+                if (kAliases[i].name == name_ && hashOf(kAliases[i].argument) == args_[0]) {
+                    item.alias = static_cast<std::uint8_t>(i + 1);
+                    item.a = text.b - nameBegin;
+                    break;
+                }
+            }
+        }
+    }
+
+    /// Hash of the canonical spelling of the items scratch_[mark...].
+    SpellingHash hashItems(std::size_t mark) const {
+        SpellingHash h;
+        std::size_t kept = 0;
+        std::size_t shown = 0;
+        for (std::size_t i = mark; i < scratch_.size(); ++i) {
+            const Item& item = scratch_[i];
+            switch (item.kind) {
+            case Kind::Text: {
+                std::uint32_t end = item.b;
+                if (i + 1 < scratch_.size() && scratch_[i + 1].alias != 0) {
+                    end -= scratch_[i + 1].a;
+                }
+                forEachNormalizedPiece(s_.substr(item.a, end - item.a), [&h](std::string_view piece) {
+                    h.add(piece);
+                });
+                break;
+            }
+            case Kind::Open:
+                if (item.alias != 0) {
+                    h.add(kAliases[item.alias - 1].alias);
+                    while (scratch_[i].kind != Kind::Close) {
+                        ++i;
+                    }
+                    break;
+                }
+                h.add('<');
+                kept = item.b;
+                shown = 0;
+                break;
+            case Kind::Child:
+                if (shown < kept) {
+                    if (shown > 0) {
+                        h.add(", ");
+                    }
+                    h.add(childHash(item.a));
+                }
+                ++shown;
+                break;
+            case Kind::Close:
+                h.add('>');
+                break;
+            }
+        }
+        return h;
+    }
+
+    TypeNameTree& tree_;
+    std::string_view s_;
+    std::size_t pos_ = 0;
+    /// Items of the nodes being parsed; a node's items move to the tree once it is complete.
+    std::vector<Item> scratch_;
+    std::string name_;
+    std::vector<SpellingHash> args_;
+};
+
+/// Renders a tree in two passes: the first counts how often each long
+/// template-id is shown, the second writes the text, replacing template-ids
+/// shown more than once by back-references.
+class TypeNameTree::Renderer {
+public:
+    Renderer(const TypeNameTree& tree, const TypeNameOptions& options) : tree_(tree), options_(options) {}
+
+    std::string run() {
+        counting_ = true;
+        visit(tree_.root_, 0);
+        counting_ = false;
+        visitItems(tree_.root_, 0);
+        if (!legend_.empty()) {
+            out_ += " [with ";
+            // Definitions may reference further subtrees, which extend the legend.
+            for (std::size_t i = 0; i < legend_.size(); ++i) {
+                if (i > 0) {
+                    out_ += "; ";
+                }
+                out_ += '$';
+                out_ += std::to_string(i + 1);
+                out_ += " = ";
+                visitItems(legend_[i].first, legend_[i].second);
+            }
+            out_ += ']';
+        }
+        return std::move(out_);
+    }
+
+private:
+    using Kind = Item::Kind;
+
+    static std::uint64_t key(const Node& node) { return node.hash ^ (static_cast<std::uint64_t>(node.length) << 40); }
+
+    bool shared(NodeId id) const {
+        const Node& node = tree_.nodes_[id];
+        return id != tree_.root_ && node.templateId && node.length >= options_.minBackReferenceLength;
+    }
+
+    void visit(NodeId id, std::size_t depth) {
+        if (shared(id)) {
+            const std::uint64_t k = key(tree_.nodes_[id]);
+            if (counting_) {
+                if (++counts_[k] > 1) {
+                    return;
+                }
+            } else if (counts_[k] > 1) {
+                auto [it, added] = refs_.emplace(k, legend_.size() + 1);
+                if (added) {
+                    legend_.emplace_back(id, depth);
+                }
+                out_ += '$';
+                out_ += std::to_string(it->second);
+                return;
+            }
+        }
+        visitItems(id, depth);
+    }
+
+    void write(std::string_view text) {
+        if (!counting_) {
+            forEachNormalizedPiece(text, [this](std::string_view piece) { out_.append(piece); });
+        }
+    }
+
+    void visitItems(NodeId id, std::size_t depth) {
+        const Node& node = tree_.nodes_[id];
+        const Item* items = tree_.items_.data() + node.firstItem;
+        std::size_t kept = 0;
+        std::size_t shown = 0;
+        for (std::uint32_t i = 0; i < node.itemCount; ++i) {
+            const Item& item = items[i];
+            switch (item.kind) {
+            case Kind::Text: {
+                std::uint32_t end = item.b;
+                if (i + 1 < node.itemCount && items[i + 1].alias != 0) {
+                    end -= items[i + 1].a;
+                }
+                write(tree_.source_.substr(item.a, end - item.a));
+                break;
+            }
+            case Kind::Open:
+                if (item.alias != 0 || depth + 1 > options_.maxDepth) {
+                    write(item.alias != 0 ? kAliases[item.alias - 1].alias : std::string_view("<...>"));
+                    while (items[i].kind != Kind::Close) {
+                        ++i;
+                    }
+                    break;
+                }
+                write("<");
+                kept = item.b;
+                shown = 0;
+                break;
+            case Kind::Child:
+                if (shown < kept) {
+                    if (shown > 0) {
+                        write(", ");
+                    }
+                    visit(item.a, depth + 1);
+                }
+                ++shown;
+                break;
+            case Kind::Close:
+                write(">");
+                break;
+            }
+        }
+    }
+
+    const TypeNameTree& tree_;
+    const TypeNameOptions& options_;
+    bool counting_ = false;
+    std::unordered_map<std::uint64_t, std::uint32_t> counts_;
+    std::unordered_map<std::uint64_t, std::size_t> refs_;
+    /// Back-referenced nodes with the depth of their first occurrence.
+    std::vector<std::pair<NodeId, std::size_t>> legend_;
+    std::string out_;
+};
+
+std::optional<TypeNameTree> TypeNameTree::parse(std::string_view source) {
+    if (source.size() >= std::numeric_limits<std::uint32_t>::max()) {
+        return std::nullopt;
+    }
+    TypeNameTree tree;
+    tree.source_ = source;
+    if (!Parser(tree).run()) {
+        return std::nullopt;
+    }
+    return tree;
+}
+
+std::string_view TypeNameTree::spelling(NodeId node) const {
+    return source_.substr(nodes_[node].begin, nodes_[node].end - nodes_[node].begin);
+}
+
+std::string TypeNameTree::abbreviate(const TypeNameOptions& options) const {
+    return Renderer(*this, options).run();
+}
+
+std::string abbreviateTypeNames(std::string_view text, const TypeNameOptions& options) {
+    const std::optional<TypeNameTree> tree = TypeNameTree::parse(text);
+    if (!tree) {
+        return std::string(text);
+    }
+    std::string abbreviated = tree->abbreviate(options);
+    return abbreviated.size() < text.size() ? abbreviated : std::string(text);
+}
+
+} // namespace template_insight
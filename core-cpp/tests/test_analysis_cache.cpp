@@ -0,0 +1,96 @@
+#include "analysis_cache.hpp"
+#include "api.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+using namespace template_insight;
+
+namespace {
+
+/// Build log of `blocks` jobs; with `changed` >= 0, the diagnostics of that job differ.
+std::string makeLog(int blocks, int changed = -1) {
+    std::string log;
+    for (int i = 0; i < blocks; ++i) {
+        const std::string n = std::to_string(i);
+        log += "[" + n + "/50] Building CXX object src/f" + n + ".cpp.o\n";
+        if (i % 2 == 0) {
+            log += "src/a.h:" + n + ":7: error: no member named 'begin' in 'int'\n"
+                   "src/main.cpp:3:3: note: in instantiation of function template specialization 'f<int>' requested here\n";
+        } else {
+            log += "src/b.h: In instantiation of 'void g(T) [with T = int]':\n"
+                   "src/f" + n + ".cpp:3:5:   required from here\n"
+                   "src/b.h:4:7: error: no matching function for call to 'k" + std::string(i == changed ? "2" : "") +
+                   "(int&)'\n";
+        }
+    }
+    return log;
+}
+
+} // namespace
+
+TEST(AnalysisCache, ReusesUnchangedRunsAndMatchesUncachedResult) {
+    AppConfig config;
+    config.analysis.workerThreads = 1;
+    config.analysis.maxIssues = 100000;
+    auto catalog = IssueCatalog::load(config.analysis);
+    AnalysisCache cache(64 << 20);
+
+    const std::string first = makeLog(3000);
+    const std::string second = makeLog(3000, 1501); // One job in the middle changed.
+    EXPECT_EQ(serializeToJson(analyzeDiagnostics(first, {}, config, catalog, {}, &cache)),
+              serializeToJson(analyzeDiagnostics(first, {}, config)));
+    const std::size_t runs = cache.stats().misses;
+    EXPECT_GT(runs, 4u);
+    EXPECT_EQ(cache.stats().hits, 0u);
+
+    // Only the runs around the changed job are analyzed again.
+    EXPECT_EQ(serializeToJson(analyzeDiagnostics(second, {}, config, catalog, {}, &cache)),
+              serializeToJson(analyzeDiagnostics(second, {}, config)));
+    EXPECT_LE(cache.stats().misses, runs + 2);
+    EXPECT_GE(cache.stats().hits, runs - 2);
+
+    // A different configuration never reuses these entries.
+    AppConfig other = config;
+    other.analysis.maxTemplateDepth = 1;
+    const std::size_t hits = cache.stats().hits;
+    analyzeDiagnostics(first, {}, other, catalog, {}, &cache);
+    EXPECT_EQ(cache.stats().hits, hits);
+}
+
+TEST(AnalysisCache, EvictsLeastRecentlyUsedAndPersists) {
+    AnalysisConfig config;
+    auto catalog = IssueCatalog::load(config);
+    TemplateInsightResult issue;
+    issue.issues.emplace_back();
+    issue.issues.back().code = IssueCodes::NO_MEMBER;
+    const CompactResult result = CompactResult::fromResult(std::move(issue), catalog);
+    std::size_t entrySize = 0;
+    {
+        AnalysisCache sizing(1 << 20);
+        sizing.insert(1, result);
+        entrySize = sizing.stats().bytes;
+    }
+
+    AnalysisCache cache(2 * entrySize);
+    cache.insert(1, result);
+    cache.insert(2, result);
+    ASSERT_NE(cache.find(1), nullptr); // 2 is now least recently used.
+    cache.insert(3, result);
+    EXPECT_EQ(cache.find(2), nullptr);
+    EXPECT_NE(cache.find(1), nullptr);
+    EXPECT_NE(cache.find(3), nullptr);
+    EXPECT_EQ(cache.stats().evictions, 1u);
+
+    const char* path = "test_analysis_cache.bin";
+    cache.save(path);
+    AnalysisCache restored(2 * entrySize);
+    restored.load(path, catalog);
+    std::remove(path);
+    EXPECT_EQ(restored.stats().entries, 2u);
+    const std::shared_ptr<const CompactResult> entry = restored.find(3);
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->issues().size(), 1u);
+    EXPECT_EQ(entry->code(entry->issues().front()), IssueCodes::NO_MEMBER);
+}
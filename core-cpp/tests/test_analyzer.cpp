@@ -1,7 +1,12 @@
+#include "analyzer.hpp"
 #include "api.hpp"
 #include "config.hpp"
 
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
 
 using namespace template_insight;
 
@@ -52,3 +57,141 @@ TEST(TemplateInsightCore, JsonSerializationProducesNonEmptyOutput) {
     EXPECT_NE(json.find("\"issues\""), std::string::npos);
     EXPECT_NE(json.find("NO_MEMBER"), std::string::npos);
 }
+
+TEST(TemplateInsightCore, ChunkedFeedMatchesWholeBufferAnalysis) {
+    const std::string logText =
+        "[1/3] Building CXX object main.cpp.o\n"
+        "main.cpp:10:5: error: no member named 'begin' in 'int'\n"
+        "    x.begin();\n"
+        "    ~ ^\n"
+        "1 error generated.";
+
+    AnalysisOptions options;
+    AppConfig config;
+
+    // Feed one byte at a time so every line and the diagnostic span chunk boundaries.
+    DiagnosticsAnalyzer analyzer(options, config);
+    for (char c : logText) {
+        analyzer.feed(std::string_view(&c, 1));
+    }
+    TemplateInsightResult chunked = analyzer.finish();
+    TemplateInsightResult whole = analyzeDiagnostics(logText, options, config);
+
+    EXPECT_EQ(serializeToJson(chunked), serializeToJson(whole));
+    ASSERT_EQ(chunked.issues.size(), 1u);
+    EXPECT_EQ(chunked.issues.front().code, IssueCodes::NO_MEMBER);
+}
+
+TEST(TemplateInsightCore, StreamAnalysisReadsFromIstream) {
+    std::istringstream in(
+        "main.cpp:10:5: error: no member named 'begin' in 'int'\n"
+        "    x.begin();\n");
+
+    AnalysisOptions options;
+    AppConfig config;
+
+    TemplateInsightResult result = analyzeDiagnosticsStream(in, options, config);
+
+    ASSERT_EQ(result.issues.size(), 1u);
+    EXPECT_EQ(result.issues.front().code, IssueCodes::NO_MEMBER);
+}
+
+TEST(TemplateInsightCore, DisabledIssueCodesAreNotMatched) {
+    const std::string logText =
+        "main.cpp:10:5: error: no member named 'begin' in 'int'\n"
+        "main.cpp:12:5: error: no matching function for call to 'f'\n";
+
+    AnalysisOptions options;
+    AppConfig config;
+    config.analysis.enabledIssueCodes = {IssueCodes::NO_MATCHING_FUNCTION};
+
+    TemplateInsightResult result = analyzeDiagnostics(logText, options, config);
+
+    ASSERT_EQ(result.issues.size(), 1u);
+    EXPECT_EQ(result.issues.front().code, IssueCodes::NO_MATCHING_FUNCTION);
+    EXPECT_EQ(result.issues.front().category, "OverloadResolution");
+}
+
+TEST(TemplateInsightCore, ReportsEveryDiagnosticWithLocation) {
+    const std::string logText =
+        "main.cpp:10:5: error: no member named 'begin' in 'int'\n"
+        "    x.begin();\n"
+        "    ~ ^\n"
+        "util.h:3:12: error: no member named 'end' in 'int'\n"
+        "util.h:8:1: warning: no matching function for call to 'g'\n"
+        "util.h:2:1: note: candidate template ignored: substitution failure\n";
+
+    AnalysisOptions options;
+    AppConfig config;
+
+    TemplateInsightResult result = analyzeDiagnostics(logText, options, config);
+
+    ASSERT_EQ(result.issues.size(), 3u);
+
+    EXPECT_EQ(result.issues[0].code, IssueCodes::NO_MEMBER);
+    ASSERT_TRUE(result.issues[0].location.has_value());
+    EXPECT_EQ(result.issues[0].location->file, "main.cpp");
+    EXPECT_EQ(result.issues[0].location->line, 10);
+    EXPECT_EQ(result.issues[0].location->column, 5);
+
+    EXPECT_EQ(result.issues[1].code, IssueCodes::NO_MEMBER);
+    ASSERT_TRUE(result.issues[1].location.has_value());
+    EXPECT_EQ(result.issues[1].location->file, "util.h");
+    EXPECT_EQ(result.issues[1].location->line, 3);
+
+    // The header message decides the code, not the notes that follow it.
+    EXPECT_EQ(result.issues[2].code, IssueCodes::NO_MATCHING_FUNCTION);
+    EXPECT_EQ(result.issues[2].severity, Severity::Warning);
+}
+
+TEST(TemplateInsightCore, StopsAtMaxIssuesAndFlagsTruncation) {
+    std::string logText;
+    for (int i = 1; i <= 5; ++i) {
+        logText += "main.cpp:" + std::to_string(i) + ":1: error: no member named 'x' in 'int'\n";
+    }
+
+    AnalysisOptions options;
+    AppConfig config;
+    config.analysis.maxIssues = 2;
+
+    TemplateInsightResult truncated = analyzeDiagnostics(logText, options, config);
+    ASSERT_EQ(truncated.issues.size(), 2u);
+    EXPECT_EQ(truncated.truncation, TruncationReason::MaxIssues);
+    EXPECT_NE(serializeToJson(truncated).find("\"truncationReason\": \"max_issues\""), std::string::npos);
+
+    // Exactly maxIssues issues is a complete result.
+    config.analysis.maxIssues = 5;
+    TemplateInsightResult complete = analyzeDiagnostics(logText, options, config);
+    EXPECT_EQ(complete.issues.size(), 5u);
+    EXPECT_EQ(complete.truncation, TruncationReason::None);
+    EXPECT_EQ(serializeToJson(complete).find("truncated"), std::string::npos);
+}
+
+TEST(TemplateInsightCore, TimeoutAndCancellationStopScanning) {
+    const std::string logText = "main.cpp:1:1: error: no member named 'x' in 'int'\n";
+    AnalysisOptions options;
+
+    AppConfig config;
+    config.analysis.timeoutMs = 50;
+    // Waiting for input does not count against the timeout.
+    DiagnosticsAnalyzer waiting(options, config);
+    waiting.feed(logText);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    waiting.feed(logText);
+    EXPECT_FALSE(waiting.stopped());
+    EXPECT_EQ(waiting.finish().truncation, TruncationReason::None);
+
+    DiagnosticsAnalyzer timed(options, config);
+    timed.chargeTime(std::chrono::milliseconds(60));
+    timed.feed(logText);
+    EXPECT_TRUE(timed.stopped());
+    TemplateInsightResult timedOut = timed.finish();
+    EXPECT_TRUE(timedOut.issues.empty());
+    EXPECT_EQ(timedOut.truncation, TruncationReason::Timeout);
+
+    std::atomic<bool> cancel{true};
+    DiagnosticsAnalyzer cancelled(options, AppConfig{});
+    cancelled.setCancellationFlag(&cancel);
+    cancelled.feed(logText);
+    EXPECT_EQ(cancelled.finish().truncation, TruncationReason::Cancelled);
+}
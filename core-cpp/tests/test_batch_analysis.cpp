@@ -0,0 +1,111 @@
+#include "batch_analysis.hpp"
+#include "issue_catalog.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+
+using namespace template_insight;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+/// Scratch directory, removed at the end of the test.
+class ScratchDir {
+public:
+    explicit ScratchDir(const std::string& name) : root_(fs::temp_directory_path() / name) {
+        fs::remove_all(root_);
+        fs::create_directories(root_);
+    }
+    ~ScratchDir() { fs::remove_all(root_); }
+
+    std::string write(const std::string& name, const std::string& text) const {
+        std::ofstream(root_ / name, std::ios::binary) << text;
+        return (root_ / name).string();
+    }
+    std::string path() const { return root_.string(); }
+
+private:
+    fs::path root_;
+};
+
+} // namespace
+
+TEST(BatchAnalysis, LoadsAndRewritesCompileCommands) {
+    EXPECT_EQ(splitCommandLine(R"(c++ -DNAME="a b" -I'inc dir' x\ y.cpp  -o out.o)"),
+              (std::vector<std::string>{"c++", "-DNAME=a b", "-Iinc dir", "x y.cpp", "-o", "out.o"}));
+
+    ScratchDir dir("template_insight_batch_commands_test");
+    const std::string database = dir.write("compile_commands.json", R"([
+        {"directory": "/build", "file": "../src/a.cpp",
+         "command": "/usr/bin/clang++ -std=c++17 -c ../src/a.cpp -o a.o -MD -MF a.o.d"},
+        {"directory": "/build", "file": "/src/b.cpp",
+         "arguments": ["g++", "-O2", "-c", "/src/b.cpp", "-ob.o"]},
+        {"directory": "/build", "command": "c++ -c nofile.cpp"}
+    ])");
+
+    const std::vector<CompileCommand> commands = loadCompileCommands(database);
+    ASSERT_EQ(commands.size(), 2u);
+    EXPECT_EQ(commands[0].file, "/src/a.cpp");
+    EXPECT_EQ(commands[0].directory, "/build");
+
+    AnalysisConfig config;
+    EXPECT_EQ(syntaxOnlyArguments(commands[0], config),
+              (std::vector<std::string>{"/usr/bin/clang++", "-std=c++17", "../src/a.cpp", "-fsyntax-only"}));
+    config.batchCompiler = "ccache clang++";
+    EXPECT_EQ(syntaxOnlyArguments(commands[1], config),
+              (std::vector<std::string>{"ccache", "clang++", "-O2", "/src/b.cpp", "-fsyntax-only"}));
+
+    EXPECT_THROW(loadCompileCommands(dir.write("bad.json", "{}")), std::runtime_error);
+}
+
+TEST(BatchAnalysis, CompilesTranslationUnitsOnWorkStealingPool) {
+    std::vector<std::atomic<int>> runs(200);
+    std::vector<std::size_t> order(runs.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = order.size() - 1 - i;
+    }
+    runWorkStealing(order, 4, [&](std::size_t i) { ++runs[i]; });
+    for (const auto& count : runs) {
+        EXPECT_EQ(count.load(), 1);
+    }
+
+    // A fake compiler that reports one error in the file it is given.
+    ScratchDir dir("template_insight_batch_run_test");
+    const std::string compiler = dir.write("fake-cc",
+        "#!/bin/sh\n"
+        "for a in \"$@\"; do case $a in *.cpp) f=$a;; esac; done\n"
+        "case $f in *ok.cpp) exit 0;; esac\n"
+        "echo \"$f:3:7: error: no member named 'begin' in 'int'\" >&2\n"
+        "exit 1\n");
+    fs::permissions(compiler, fs::perms::owner_all);
+
+    std::vector<CompileCommand> commands;
+    for (const char* file : {"a.cpp", "ok.cpp", "b.cpp"}) {
+        commands.push_back({dir.path(), dir.path() + "/" + file, {compiler, "-c", file, "-o", "x.o"}});
+    }
+    AppConfig config;
+    config.analysis.workerThreads = 2;
+    CompileTimings timings;
+    timings.record(dir.path() + "/b.cpp", 500); // Previously slowest: scheduled first.
+
+    const TemplateInsightResult result = analyzeCompileCommands(
+        commands, AnalysisOptions{}, config, IssueCatalog::load(config.analysis), timings);
+
+    ASSERT_EQ(result.issues.size(), 2u);
+    EXPECT_EQ(result.issues[0].code, IssueCodes::NO_MEMBER);
+    EXPECT_EQ(result.issues[0].translationUnit, dir.path() + "/a.cpp");
+    ASSERT_TRUE(result.issues[0].location.has_value());
+    EXPECT_EQ(result.issues[0].location->file, "a.cpp");
+    EXPECT_EQ(result.issues[1].translationUnit, dir.path() + "/b.cpp");
+    EXPECT_TRUE(timings.find(dir.path() + "/ok.cpp").has_value());
+
+    const std::string saved = dir.path() + "/timings.json";
+    timings.save(saved);
+    CompileTimings reloaded;
+    reloaded.load(saved);
+    EXPECT_EQ(reloaded.find(dir.path() + "/a.cpp"), timings.find(dir.path() + "/a.cpp"));
+}
@@ -0,0 +1,79 @@
+#include "api.hpp"
+#include "binary_format.hpp"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <stdexcept>
+
+using namespace template_insight;
+
+namespace {
+
+std::string sampleLog(int blocks) {
+    std::string log;
+    for (int i = 0; i < blocks; ++i) {
+        log += "src/widget.cpp:" + std::to_string(10 + i) + ":7: error: no member named 'size' in 'int'\n"
+               "src/main.cpp:42:3: note: in instantiation of function template specialization "
+               "'process<int>' requested here\n";
+        log += "src/other.cpp:" + std::to_string(i + 1) + ":1: warning: cannot convert 'int' to 'S'\n";
+    }
+    return log;
+}
+
+} // namespace
+
+TEST(BinaryFormat, RoundTripsResult) {
+    AppConfig config;
+    config.analysis.maxIssues = 50;
+    const TemplateInsightResult result = analyzeDiagnostics(sampleLog(40), AnalysisOptions{}, config);
+    ASSERT_EQ(result.truncation, TruncationReason::MaxIssues);
+    ASSERT_FALSE(result.instantiations.empty());
+    TemplateInsightResult batch = result;
+    batch.issues[1].translationUnit = "src/widget.cpp";
+
+    const std::string encoded = encodeBinaryResult(result);
+    const TemplateInsightResult decoded = decodeBinaryResult(encoded);
+    EXPECT_EQ(serializeToJson(decoded), serializeToJson(result));
+
+    // Repeated codes, messages and paths are stored once.
+    EXPECT_LT(encoded.size() * 4, serializeToJson(result).size());
+
+    EXPECT_EQ(serializeToJson(decodeBinaryResult(encodeBinaryResult(batch))), serializeToJson(batch));
+
+    // Version 1 payloads (no translation units) still decode.
+    std::string v1 = encoded;
+    v1[3] = 1;
+    EXPECT_EQ(serializeToJson(decodeBinaryResult(v1)), serializeToJson(result));
+}
+
+TEST(BinaryFormat, RejectsMalformedInput) {
+    const std::string encoded = encodeBinaryResult(analyzeDiagnostics(sampleLog(2), AnalysisOptions{}, AppConfig{}));
+
+    EXPECT_THROW(decodeBinaryResult("{ \"issues\": [] }"), std::runtime_error);
+    EXPECT_THROW(decodeBinaryResult(encoded.substr(0, encoded.size() - 1)), std::runtime_error);
+    EXPECT_THROW(decodeBinaryResult(encoded + "x"), std::runtime_error);
+
+    // Line numbers beyond int, links to frames that do not exist.
+    TemplateInsightResult linked;
+    linked.instantiations.resize(1);
+    linked.issues.resize(1);
+    linked.issues[0].location = SourceLocation{"a.cpp", std::numeric_limits<int>::max(), 1};
+    linked.issues[0].instantiation = 0;
+    const std::string valid = encodeBinaryResult(linked);
+    EXPECT_EQ(decodeBinaryResult(valid).issues[0].location->line, std::numeric_limits<int>::max());
+    std::string hugeLine = valid;
+    const std::size_t maxInt = hugeLine.find("\xff\xff\xff\xff\x07");
+    ASSERT_NE(maxInt, std::string::npos);
+    hugeLine[maxInt + 4] = '\x0f';
+    EXPECT_THROW(decodeBinaryResult(hugeLine), std::runtime_error);
+    linked.issues[0].instantiation = 1;
+    EXPECT_THROW(decodeBinaryResult(encodeBinaryResult(linked)), std::runtime_error);
+    linked.issues[0].instantiation = 0;
+    linked.instantiations[0].parent = 0;
+    EXPECT_THROW(decodeBinaryResult(encodeBinaryResult(linked)), std::runtime_error);
+
+    std::string future = encoded;
+    future[3] = static_cast<char>(kBinaryFormatVersion + 1);
+    EXPECT_THROW(decodeBinaryResult(future), std::runtime_error);
+}
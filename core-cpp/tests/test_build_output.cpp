@@ -0,0 +1,82 @@
+#include "build_output.hpp"
+#include "issue_catalog.hpp"
+
+#include <gtest/gtest.h>
+
+#include <map>
+
+using namespace template_insight;
+
+TEST(BuildOutput, RegroupsInterleavedMakeOutputPerJob) {
+    // make -j: the note of b.cpp's error arrives after a.cpp's error started.
+    const std::string log =
+        "[ 10%] Building CXX object CMakeFiles/app.dir/src/a.cpp.o\n"
+        "[ 20%] Building CXX object CMakeFiles/app.dir/src/b.cpp.o\n"
+        "/work/src/b.cpp:4:1: error: no matching function for call to 'g'\n"
+        "/work/src/a.cpp:3:5: error: no member named 'size' in 'int'\n"
+        "    x.size();\n"
+        "/work/src/b.cpp:9:2: note: in instantiation of function template specialization 'h<int>' requested here\n"
+        "make[2]: *** [CMakeFiles/app.dir/build.make:76: CMakeFiles/app.dir/src/a.cpp.o] Error 1\n"
+        "[ 30%] Building CXX object CMakeFiles/app.dir/src/c.cpp.o\n"
+        "In file included from /work/src/c.cpp:1:\n"
+        "/work/include/util.hpp:5:3: error: no member named 'end' in 'int'\n"
+        "make: *** [Makefile:146: all] Error 2\n";
+
+    AppConfig config;
+    config.analysis.workerThreads = 1;
+    config.analysis.demultiplexBuildOutput = true;
+    const TemplateInsightResult result = analyzeDiagnostics(log, AnalysisOptions{}, config);
+
+    ASSERT_EQ(result.issues.size(), 3u);
+    EXPECT_EQ(result.issues[0].code, "NO_MEMBER");
+    EXPECT_EQ(result.issues[0].translationUnit, "src/a.cpp");
+    EXPECT_FALSE(result.issues[0].instantiation.has_value());
+    EXPECT_EQ(result.issues[1].code, "NO_MATCHING_FUNCTION");
+    EXPECT_EQ(result.issues[1].translationUnit, "src/b.cpp");
+    ASSERT_TRUE(result.issues[1].instantiation.has_value());
+    EXPECT_EQ(result.instantiations[*result.issues[1].instantiation].location->file, "/work/src/b.cpp");
+    EXPECT_EQ(result.issues[2].translationUnit, "src/c.cpp");
+    ASSERT_TRUE(result.issues[2].location.has_value());
+    EXPECT_EQ(result.issues[2].location->file, "/work/include/util.hpp");
+}
+
+TEST(BuildOutput, AttributesNinjaJobsAcrossChunksAndWorkers) {
+    const std::string log =
+        "ninja: Entering directory `build'\n"
+        "[1/4] Building CXX object CMakeFiles/app.dir/src/a.cpp.o\n"
+        "[2/4] Building CXX object CMakeFiles/app.dir/src/b.cpp.o\n"
+        "FAILED: CMakeFiles/app.dir/src/b.cpp.o \n"
+        "/usr/bin/c++ -I../include -O2 -o CMakeFiles/app.dir/src/b.cpp.o -c ../src/b.cpp\n"
+        "../src/b.cpp:4:1: error: no matching function for call to 'g'\n"
+        "1 error generated.\n"
+        "[3/4] CXX obj/gen.o\n"
+        "FAILED: obj/gen.o\n"
+        "clang++ -c ../gen/gen.cc -o obj/gen.o\n"
+        "../gen/gen.cc:2:2: error: no member named 'x' in 'int'\n"
+        "ninja: build stopped: subcommand failed.\n";
+
+    std::map<std::size_t, std::string> output;
+    std::vector<std::size_t> ended;
+    BuildOutputDemuxer demuxer([&](std::size_t job, std::string_view line) { output[job].append(line); },
+                               [&](std::size_t job) { ended.push_back(job); });
+    demuxer.feed(log);
+    demuxer.finish();
+    ASSERT_EQ(demuxer.jobCount(), 4u);
+    EXPECT_EQ(demuxer.translationUnit(2), "../src/b.cpp");
+    EXPECT_EQ(demuxer.translationUnit(3), "../gen/gen.cc");
+    EXPECT_EQ(output[2], "../src/b.cpp:4:1: error: no matching function for call to 'g'\n1 error generated.\n");
+    EXPECT_EQ(output.count(0), 0u);
+    EXPECT_EQ(ended, (std::vector<std::size_t>{1, 2, 3, 0}));
+
+    AppConfig config;
+    BuildOutputAnalyzer analyzer(AnalysisOptions{}, config, IssueCatalog::load(config.analysis), 2);
+    for (std::size_t pos = 0; pos < log.size(); pos += 7) {
+        analyzer.feed(std::string_view(log).substr(pos, 7));
+    }
+    const TemplateInsightResult result = analyzer.finish();
+    ASSERT_EQ(result.issues.size(), 2u);
+    EXPECT_EQ(result.issues[0].code, "NO_MATCHING_FUNCTION");
+    EXPECT_EQ(result.issues[0].translationUnit, "../src/b.cpp");
+    EXPECT_EQ(result.issues[1].code, "NO_MEMBER");
+    EXPECT_EQ(result.issues[1].translationUnit, "../gen/gen.cc");
+}
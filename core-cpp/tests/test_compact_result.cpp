@@ -0,0 +1,83 @@
+#include "analyzer.hpp"
+#include "compact_result.hpp"
+#include "json_writer.hpp"
+#include "result_merger.hpp"
+#include "string_interner.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace template_insight;
+
+TEST(CompactResult, ViewsIntoCatalogAndMaterializesOnDemand) {
+    const std::string log =
+        "src/a.h:3:7: error: no member named 'begin' in 'int'\n"
+        "src/main.cpp:9:3: note: in instantiation of function template specialization 'f<int>' requested here\n"
+        "src/a.h:5:1: warning: cannot convert 'int' to 'S'\n"
+        "src/a.h:7:2: error: no member named 'end' in 'int'\n";
+    AppConfig config;
+    auto catalog = IssueCatalog::load(config.analysis);
+
+    DiagnosticsAnalyzer analyzer(AnalysisOptions{}, config, catalog);
+    analyzer.feed(log);
+    CompactResult compact = analyzer.finishCompact();
+
+    ASSERT_EQ(compact.issues().size(), 3u);
+    const CompactIssue& first = compact.issues()[0];
+    const CompactIssue& last = compact.issues()[2];
+    // Messages are views of the catalog, paths are interned once.
+    EXPECT_EQ(compact.code(first).data(), catalog->kind(first.kind).code.data());
+    EXPECT_EQ(compact.file(first), "src/a.h");
+    EXPECT_EQ(compact.file(first).data(), compact.file(last).data());
+    EXPECT_EQ(compact.issues()[1].severity, Severity::Warning);
+    EXPECT_EQ(last.instantiation, CompactIssue::kNone);
+
+    DiagnosticsAnalyzer reference(AnalysisOptions{}, config, catalog);
+    reference.feed(log);
+    const std::string expected = serializeToJson(reference.finish());
+
+    // The writer reads the compact form as it is ...
+    OutputBuffer out;
+    ResultJsonWriter(out, ResultJsonWriter::Layout::Document).finish(compact);
+    EXPECT_EQ(out.str(), expected);
+
+    // ... and so does the merger, re-interning the paths of every part.
+    const std::size_t split = log.find("src/a.h:5");
+    ResultMerger merger(config.analysis.maxIssues, catalog);
+    for (const std::string_view part : {std::string_view(log).substr(0, split), std::string_view(log).substr(split)}) {
+        DiagnosticsAnalyzer analyzer(AnalysisOptions{}, config, catalog);
+        analyzer.feed(part);
+        CompactResult partResult = analyzer.finishCompact();
+        partResult.setTranslationUnit("src/main.cpp");
+        merger.append(std::move(partResult));
+    }
+    const CompactResult merged = merger.finish();
+    ASSERT_EQ(merged.issues().size(), 3u);
+    EXPECT_EQ(merged.file(merged.issues()[2]), "src/a.h");
+    EXPECT_EQ(merged.translationUnit(merged.issues()[2]), "src/main.cpp");
+    EXPECT_EQ(merged.toResult().issues[0].translationUnit, "src/main.cpp");
+
+    EXPECT_EQ(serializeToJson(std::move(compact).toResult()), expected);
+}
+
+TEST(CompactResult, InternerKeepsViewsStableInArena) {
+    StringInterner interner;
+    const std::string_view first = interner.internView("src/a.h");
+    std::vector<std::string_view> views;
+    for (int i = 0; i < 5000; ++i) {
+        views.push_back(interner.internView("src/file" + std::to_string(i) + ".cpp"));
+    }
+    const std::string big(40000, 'x'); // Larger than an arena block.
+    const std::string_view bigView = interner.internView(big);
+
+    EXPECT_EQ(interner.internView("src/a.h").data(), first.data());
+    EXPECT_EQ(views[4321], "src/file4321.cpp");
+    EXPECT_EQ(bigView, big);
+    EXPECT_EQ(interner.size(), 5002u);
+
+    StringInterner copy = interner;
+    EXPECT_EQ(copy.str(0), "src/a.h");
+    EXPECT_NE(copy.str(0).data(), first.data());
+    StringInterner moved = std::move(interner);
+    EXPECT_EQ(moved.str(0).data(), first.data());
+    EXPECT_EQ(moved.intern(big), 5001u);
+}
@@ -0,0 +1,126 @@
+#include "api.hpp"
+#include "compressed_input.hpp"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+using namespace template_insight;
+
+namespace {
+
+const std::string kPlain =
+    "src/a.cpp:3:5: error: no member named 'size' in 'int'\n"
+    "    x.size();\n"
+    "src/b.cpp:7:1: error: no matching function for call to 'f'\n";
+
+// `gzip -n` of the two lines of a.cpp and of the b.cpp line, concatenated.
+const unsigned char kGzip[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x2b, 0x2e,
+    0x4a, 0xd6, 0x4f, 0xd4, 0x4b, 0x2e, 0x28, 0xb0, 0x32, 0xb6, 0x32, 0xb5,
+    0x52, 0x48, 0x2d, 0x2a, 0xca, 0x2f, 0xb2, 0x52, 0xc8, 0xcb, 0x57, 0xc8,
+    0x4d, 0xcd, 0x4d, 0x4a, 0x2d, 0x52, 0xc8, 0x4b, 0xcc, 0x4d, 0x4d, 0x51,
+    0x50, 0x2f, 0xce, 0xac, 0x4a, 0x55, 0x57, 0xc8, 0xcc, 0x53, 0x50, 0xcf,
+    0xcc, 0x2b, 0x51, 0xe7, 0x52, 0x00, 0x82, 0x0a, 0x3d, 0x90, 0xa0, 0x86,
+    0xa6, 0x35, 0x17, 0x00, 0x2a, 0x7d, 0xc4, 0xfa, 0x44, 0x00, 0x00, 0x00,
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x2b, 0x2e,
+    0x4a, 0xd6, 0x4f, 0xd2, 0x4b, 0x2e, 0x28, 0xb0, 0x32, 0xb7, 0x32, 0xb4,
+    0x52, 0x48, 0x2d, 0x2a, 0xca, 0x2f, 0xb2, 0x52, 0xc8, 0xcb, 0x57, 0xc8,
+    0x4d, 0x2c, 0x49, 0xce, 0xc8, 0xcc, 0x4b, 0x57, 0x48, 0x2b, 0xcd, 0x4b,
+    0x2e, 0xc9, 0xcc, 0xcf, 0x53, 0x48, 0xcb, 0x2f, 0x52, 0x48, 0x4e, 0xcc,
+    0xc9, 0x51, 0x28, 0xc9, 0x57, 0x50, 0x4f, 0x53, 0xe7, 0x02, 0x00, 0x2a,
+    0xa8, 0xd8, 0x3f, 0x3b, 0x00, 0x00, 0x00,
+};
+
+// `zstd` of kPlain.
+const unsigned char kZstd[] = {
+    0x28, 0xb5, 0x2f, 0xfd, 0x04, 0x58, 0x25, 0x03, 0x00, 0xd2, 0x46, 0x16,
+    0x19, 0x80, 0xa9, 0x6d, 0xc4, 0x6f, 0xe9, 0xb6, 0x9b, 0x77, 0x03, 0x2b,
+    0x7f, 0x01, 0x23, 0xa9, 0x43, 0x7c, 0xfc, 0x0e, 0x11, 0xb2, 0x9e, 0x68,
+    0x54, 0x3a, 0xc6, 0x90, 0x9d, 0xd7, 0x93, 0xe4, 0xe0, 0x9b, 0xd1, 0x97,
+    0x75, 0xe1, 0x2a, 0xd0, 0x11, 0xab, 0x09, 0x5c, 0x47, 0x70, 0x05, 0xe4,
+    0xc0, 0x56, 0xc6, 0x10, 0x00, 0xe4, 0xa2, 0xca, 0x58, 0xfc, 0xbf, 0xb1,
+    0xb5, 0x6a, 0x5f, 0xbd, 0xe5, 0xa2, 0xca, 0x7e, 0xc8, 0x74, 0xf6, 0x9d,
+    0x48, 0xca, 0x74, 0xde, 0x5f, 0x73, 0x77, 0xfe, 0x08, 0x37, 0x38, 0x45,
+    0x41, 0xe3, 0x1c, 0xd8, 0x2a, 0x02, 0x00, 0x70, 0x93, 0x1c, 0x57, 0x30,
+    0x03, 0x7b, 0x16, 0x45, 0x62,
+};
+
+std::string bytes(const unsigned char* data, std::size_t size) {
+    return std::string(reinterpret_cast<const char*>(data), size);
+}
+
+/// Decompress `compressed` in blocks of 16 bytes.
+std::string decompress(const std::string& compressed, Compression compression) {
+    std::istringstream in(compressed);
+    DecompressingStreamBuf buffer(in, compression, 16);
+    std::istream plain(&buffer);
+    plain.exceptions(std::ios::badbit);
+    return std::string(std::istreambuf_iterator<char>(plain), std::istreambuf_iterator<char>());
+}
+
+/// Analysis of `compressed`, streamed and in memory, finds the issues of kPlain.
+void expectAnalyzedLikePlain(const std::string& compressed) {
+    const TemplateInsightResult expected = analyzeDiagnostics(kPlain, AnalysisOptions{}, AppConfig{});
+    ASSERT_EQ(expected.issues.size(), 2u);
+
+    std::istringstream in(compressed);
+    const TemplateInsightResult streamed = analyzeDiagnosticsStream(in, AnalysisOptions{}, AppConfig{});
+    const TemplateInsightResult inMemory = analyzeDiagnostics(compressed, AnalysisOptions{}, AppConfig{});
+    for (const TemplateInsightResult* result : {&streamed, &inMemory}) {
+        ASSERT_EQ(result->issues.size(), 2u);
+        EXPECT_EQ(result->issues[0].code, expected.issues[0].code);
+        EXPECT_EQ(result->issues[1].code, expected.issues[1].code);
+        EXPECT_EQ(result->issues[1].location->line, 7);
+    }
+}
+
+} // namespace
+
+TEST(CompressedInput, DecompressesGzipInSmallBlocks) {
+    const std::string gzip = bytes(kGzip, sizeof(kGzip));
+    EXPECT_EQ(detectCompression(gzip), Compression::Gzip);
+    EXPECT_EQ(detectCompression(kPlain), Compression::None);
+    if (!compressionSupported(Compression::Gzip)) {
+        GTEST_SKIP() << "built without zlib";
+    }
+
+    EXPECT_EQ(decompress(gzip, Compression::Gzip), kPlain);
+    EXPECT_THROW(decompress(gzip.substr(0, gzip.size() - 5), Compression::Gzip), std::runtime_error);
+
+    // Reading stops early: the destructor must not wait for the queue to drain.
+    std::string large;
+    for (int i = 0; i < 64; ++i) {
+        large += gzip;
+    }
+    std::istringstream in(large);
+    DecompressingStreamBuf buffer(in, Compression::Gzip, 16);
+    EXPECT_EQ(buffer.sgetc(), 's');
+}
+
+TEST(CompressedInput, DecompressesZstdInSmallBlocks) {
+    const std::string zstd = bytes(kZstd, sizeof(kZstd));
+    EXPECT_EQ(detectCompression(zstd), Compression::Zstd);
+    if (!compressionSupported(Compression::Zstd)) {
+        GTEST_SKIP() << "built without libzstd";
+    }
+
+    EXPECT_EQ(decompress(zstd, Compression::Zstd), kPlain);
+    EXPECT_THROW(decompress(zstd.substr(0, zstd.size() - 5), Compression::Zstd), std::runtime_error);
+}
+
+TEST(CompressedInput, AnalyzesGzipLogsLikePlainOnes) {
+    if (!compressionSupported(Compression::Gzip)) {
+        GTEST_SKIP() << "built without zlib";
+    }
+    expectAnalyzedLikePlain(bytes(kGzip, sizeof(kGzip)));
+}
+
+TEST(CompressedInput, AnalyzesZstdLogsLikePlainOnes) {
+    if (!compressionSupported(Compression::Zstd)) {
+        GTEST_SKIP() << "built without libzstd";
+    }
+    expectAnalyzedLikePlain(bytes(kZstd, sizeof(kZstd)));
+}
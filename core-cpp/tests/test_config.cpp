@@ -58,3 +58,104 @@ TEST(ConfigParsing, MinimalConfigIsParsedCorrectly) {
     EXPECT_EQ(cfg.logger.maxFileSize, static_cast<std::size_t>(5 * 1024 * 1024));
     EXPECT_EQ(cfg.logger.maxFiles, static_cast<std::size_t>(3));
 }
+
+TEST(ConfigParsing, EveryAnalysisAndOutputKeyIsParsed) {
+    const char* filename = "test_config_full.json";
+
+    {
+        std::ofstream out(filename);
+        ASSERT_TRUE(out.is_open());
+
+        out <<
+          R"({
+          "analysis": {
+            "worker_threads": 3,
+            "parallel_chunk_bytes": 65536,
+            "cache_max_bytes": 1048576,
+            "cache_file": "analysis.cache",
+            "deduplicate_issues": true,
+            "max_duplicate_units": 7,
+            "compiler": "gcc",
+            "batch_compiler": "ccache clang++",
+            "batch_timings_file": "timings.json",
+            "profile_top_n": 25,
+            "follow_settle_ms": 40,
+            "follow_idle_timeout_ms": 9000,
+            "demultiplex_build_output": true,
+            "type_name_abbreviation_length": 128
+          },
+          "output": {
+            "stats": true,
+            "trace_file": "trace.json"
+          }
+        })";
+    }
+
+    AppConfig cfg = loadConfigFromJsonFile(filename);
+    std::remove(filename);
+
+    EXPECT_EQ(cfg.analysis.workerThreads, 3u);
+    EXPECT_EQ(cfg.analysis.parallelChunkBytes, static_cast<std::size_t>(65536));
+    EXPECT_EQ(cfg.analysis.cacheMaxBytes, static_cast<std::size_t>(1048576));
+    EXPECT_EQ(cfg.analysis.cacheFile, "analysis.cache");
+    EXPECT_TRUE(cfg.analysis.deduplicateIssues);
+    EXPECT_EQ(cfg.analysis.maxDuplicateUnits, static_cast<std::size_t>(7));
+    EXPECT_EQ(cfg.analysis.compiler, "gcc");
+    EXPECT_EQ(cfg.analysis.batchCompiler, "ccache clang++");
+    EXPECT_EQ(cfg.analysis.batchTimingsFile, "timings.json");
+    EXPECT_EQ(cfg.analysis.profileTopN, static_cast<std::size_t>(25));
+    EXPECT_EQ(cfg.analysis.followSettleMs, 40);
+    EXPECT_EQ(cfg.analysis.followIdleTimeoutMs, 9000);
+    EXPECT_TRUE(cfg.analysis.demultiplexBuildOutput);
+    EXPECT_EQ(cfg.analysis.typeNameAbbreviationLength, static_cast<std::size_t>(128));
+    EXPECT_TRUE(cfg.output.writeStats);
+    EXPECT_EQ(cfg.output.traceFile, "trace.json");
+}
+
+TEST(ConfigParsing, WronglyTypedValuesKeepDefaults) {
+    const char* filename = "test_config_wrong_types.json";
+
+    {
+        std::ofstream out(filename);
+        ASSERT_TRUE(out.is_open());
+
+        out <<
+          R"({
+          "analysis": {
+            "worker_threads": -2,
+            "parallel_chunk_bytes": -1,
+            "cache_max_bytes": "1 MiB",
+            "cache_file": 42,
+            "deduplicate_issues": "yes",
+            "max_duplicate_units": -7,
+            "compiler": true,
+            "profile_top_n": 2.5,
+            "follow_settle_ms": "fast",
+            "demultiplex_build_output": 1,
+            "type_name_abbreviation_length": -128
+          },
+          "output": {
+            "stats": "true",
+            "trace_file": ["trace.json"]
+          }
+        })";
+    }
+
+    AppConfig cfg = loadConfigFromJsonFile(filename);
+    std::remove(filename);
+
+    const AppConfig defaults;
+    EXPECT_EQ(cfg.analysis.workerThreads, defaults.analysis.workerThreads);
+    EXPECT_EQ(cfg.analysis.parallelChunkBytes, defaults.analysis.parallelChunkBytes);
+    EXPECT_EQ(cfg.analysis.cacheMaxBytes, defaults.analysis.cacheMaxBytes);
+    EXPECT_EQ(cfg.analysis.cacheFile, defaults.analysis.cacheFile);
+    EXPECT_EQ(cfg.analysis.deduplicateIssues, defaults.analysis.deduplicateIssues);
+    EXPECT_EQ(cfg.analysis.maxDuplicateUnits, defaults.analysis.maxDuplicateUnits);
+    EXPECT_EQ(cfg.analysis.compiler, defaults.analysis.compiler);
+    EXPECT_EQ(cfg.analysis.profileTopN, defaults.analysis.profileTopN);
+    EXPECT_EQ(cfg.analysis.followSettleMs, defaults.analysis.followSettleMs);
+    EXPECT_EQ(cfg.analysis.demultiplexBuildOutput, defaults.analysis.demultiplexBuildOutput);
+    EXPECT_EQ(cfg.analysis.typeNameAbbreviationLength, defaults.analysis.typeNameAbbreviationLength);
+    EXPECT_EQ(cfg.output.writeStats, defaults.output.writeStats);
+    EXPECT_EQ(cfg.output.traceFile, defaults.output.traceFile);
+}
@@ -0,0 +1,59 @@
+#include "diagnostic_line.hpp"
+#include "string_interner.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace template_insight;
+
+TEST(DiagnosticLine, ParsesClangAndGccPrefixes) {
+    auto full = parseDiagnosticLine("src/main.cpp:10:5: error: no member named 'begin' in 'int'\n");
+    ASSERT_TRUE(full.has_value());
+    EXPECT_EQ(full->file, "src/main.cpp");
+    EXPECT_EQ(full->line, 10);
+    EXPECT_EQ(full->column, 5);
+    EXPECT_EQ(full->kind, DiagnosticKind::Error);
+    EXPECT_EQ(full->message, "no member named 'begin' in 'int'");
+
+    auto lineOnly = parseDiagnosticLine("a.h:7: warning: unused variable 'x'");
+    ASSERT_TRUE(lineOnly.has_value());
+    EXPECT_EQ(lineOnly->file, "a.h");
+    EXPECT_EQ(lineOnly->line, 7);
+    EXPECT_EQ(lineOnly->column, 0);
+    EXPECT_EQ(lineOnly->kind, DiagnosticKind::Warning);
+
+    auto windows = parseDiagnosticLine("C:\\src\\a.cpp:3:14: fatal error: 'x.h' file not found\r\n");
+    ASSERT_TRUE(windows.has_value());
+    EXPECT_EQ(windows->file, "C:\\src\\a.cpp");
+    EXPECT_EQ(windows->line, 3);
+    EXPECT_EQ(windows->column, 14);
+    EXPECT_EQ(windows->kind, DiagnosticKind::FatalError);
+
+    auto tool = parseDiagnosticLine("clang: error: linker command failed");
+    ASSERT_TRUE(tool.has_value());
+    EXPECT_EQ(tool->file, "clang");
+    EXPECT_EQ(tool->line, 0);
+
+    auto bare = parseDiagnosticLine("note: candidate template ignored");
+    ASSERT_TRUE(bare.has_value());
+    EXPECT_TRUE(bare->file.empty());
+    EXPECT_EQ(bare->kind, DiagnosticKind::Note);
+}
+
+TEST(DiagnosticLine, RejectsNonDiagnosticLines) {
+    EXPECT_FALSE(parseDiagnosticLine("[12/480] Building CXX object main.cpp.o").has_value());
+    EXPECT_FALSE(parseDiagnosticLine("    x.begin();").has_value());
+    EXPECT_FALSE(parseDiagnosticLine("a.cpp: In instantiation of 'void f() [with T = int]':").has_value());
+    EXPECT_FALSE(parseDiagnosticLine("1 error generated.").has_value());
+}
+
+TEST(StringInterner, SameTextSharesOneString) {
+    StringInterner interner;
+    const auto a = interner.intern("include/vector.h");
+    const auto b = interner.intern(std::string("include/") + "vector.h");
+    const auto c = interner.intern("main.cpp");
+
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(interner.size(), 2u);
+    EXPECT_EQ(interner.str(a).data(), interner.internView("include/vector.h").data());
+}
@@ -0,0 +1,136 @@
+#include "analyzer.hpp"
+#include "api.hpp"
+#include "dialect.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace template_insight;
+
+namespace {
+
+const std::string kClangLog =
+    "In file included from src/main.cpp:2:\n"
+    "src/a.h:4:7: error: no member named 'begin' in 'int'\n"
+    "    x.begin();\n"
+    "    ~ ^\n"
+    "src/a.h:9:3: note: in instantiation of function template specialization 'f<int>' requested here\n"
+    "src/main.cpp:3:3: note: in instantiation of member function 'S<int>::run' requested here\n"
+    "[2/3] Building CXX object b.o\n"
+    "src/b.cpp:7:1: warning: no matching function for call to 'g'\n"
+    "src/b.cpp:5:6: note: candidate template ignored: couldn't infer template argument 'T'\n"
+    "1 warning and 1 error generated.\n";
+
+const std::string kGccLog =
+    "In file included from src/main.cpp:2:\n"
+    "src/a.h: In instantiation of 'void f(T) [with T = int]':\n"
+    "src/a.h:9:4:   required from 'void S<T>::run() [with T = int]'\n"
+    "src/main.cpp:3:5:   required from here\n"
+    "src/a.h:4:7: error: 'int' has no member named 'begin'\n"
+    "    4 |     x.begin();\n"
+    "      |       ^~~~~\n"
+    "[2/3] Building CXX object b.o\n"
+    "src/b.cpp: In function 'void h()':\n"
+    "src/b.cpp:7:1: warning: no matching function for call to 'g()'\n"
+    "src/b.cpp:5:6: note: candidate: 'template<class T> void g(T)'\n";
+
+/// Code, file and line of every issue, then the frames of the first one.
+std::vector<std::string> golden(const TemplateInsightResult& result) {
+    std::vector<std::string> lines;
+    for (const TemplateIssue& issue : result.issues) {
+        lines.push_back(issue.code + " " + (issue.location ? issue.location->file + ":" +
+                                                                 std::to_string(issue.location->line)
+                                                           : std::string("-")));
+    }
+    if (!result.issues.empty()) {
+        for (auto node = result.issues[0].instantiation; node.has_value(); node = result.instantiations[*node].parent) {
+            lines.push_back(result.instantiations[*node].description);
+        }
+    }
+    return lines;
+}
+
+/// Analyze `log` fed in small chunks, as compiler `compiler`.
+TemplateInsightResult feedAs(const std::string& log, const std::string& compiler, std::optional<Dialect>& dialect) {
+    AnalysisOptions options;
+    options.compiler = compiler;
+    DiagnosticsAnalyzer analyzer(options, AppConfig{});
+    for (std::size_t pos = 0; pos < log.size(); pos += 7) {
+        analyzer.feed(std::string_view(log).substr(pos, 7));
+    }
+    dialect = analyzer.dialect();
+    return analyzer.finish();
+}
+
+} // namespace
+
+TEST(Dialect, SelectsAndDetectsDialect) {
+    EXPECT_EQ(dialectFromCompiler("clang++"), Dialect::Clang);
+    EXPECT_EQ(dialectFromCompiler("gcc"), Dialect::Gcc);
+    EXPECT_EQ(dialectFromCompiler("icx"), Dialect::Generic);
+    EXPECT_FALSE(dialectFromCompiler("auto").has_value());
+
+    EXPECT_EQ(detectDialect(kClangLog), Dialect::Clang);
+    EXPECT_EQ(detectDialect(kGccLog), Dialect::Gcc);
+    EXPECT_EQ(detectDialect(kClangLog + kGccLog), Dialect::Generic);
+    EXPECT_FALSE(detectDialect("[1/3] Building CXX object a.o\n").has_value());
+    // GNU ld's "In function" says nothing about the compiler.
+    const std::string linkError = "a.o: In function `main':\nmain.cpp:(.text+0x5): undefined reference to `g'\n";
+    EXPECT_FALSE(detectDialect(linkError).has_value());
+    EXPECT_EQ(detectDialect(linkError + kClangLog), Dialect::Clang);
+
+    // Decided by the first telling phrase, even one split across chunks.
+    DiagnosticsAnalyzer analyzer(AnalysisOptions{}, AppConfig{});
+    analyzer.feed("[1/3] Building CXX object a.o\n");
+    EXPECT_FALSE(analyzer.dialect().has_value());
+    analyzer.feed("src/a.h:9:3: note: ... requ");
+    EXPECT_FALSE(analyzer.dialect().has_value());
+    analyzer.feed("ested here\n");
+    EXPECT_EQ(analyzer.dialect(), Dialect::Clang);
+
+    // Generic once kDialectProbeBytes told nothing.
+    DiagnosticsAnalyzer undecided(AnalysisOptions{}, AppConfig{});
+    undecided.feed(std::string(kDialectProbeBytes - 1, '\n'));
+    EXPECT_FALSE(undecided.dialect().has_value());
+    undecided.feed("\n");
+    EXPECT_EQ(undecided.dialect(), Dialect::Generic);
+}
+
+TEST(Dialect, SpecializedParsersMatchGoldenResults) {
+    const std::string linkedClangLog = "a.o: In function `main':\n" + kClangLog;
+    const std::vector<std::string> clangGolden = {
+        "NO_MEMBER src/a.h:4",
+        "NO_MATCHING_FUNCTION src/b.cpp:7",
+        "function template specialization 'f<int>'",
+        "member function 'S<int>::run'",
+    };
+    const std::vector<std::string> gccGolden = {
+        "NO_MEMBER src/a.h:4",
+        "NO_MATCHING_FUNCTION src/b.cpp:7",
+        "void f(T) [with T = int]",
+        "void S<T>::run() [with T = int]",
+    };
+    const struct {
+        const std::string& log;
+        const std::vector<std::string>& golden;
+        const char* compiler;
+        Dialect dialect;
+    } cases[] = {
+        {kClangLog, clangGolden, "auto", Dialect::Clang},
+        {kClangLog, clangGolden, "clang", Dialect::Clang},
+        {kClangLog, clangGolden, "generic", Dialect::Generic},
+        {kGccLog, gccGolden, "auto", Dialect::Gcc},
+        {kGccLog, gccGolden, "g++", Dialect::Gcc},
+        {kGccLog, gccGolden, "generic", Dialect::Generic},
+        // A link error first must not lose the clang backtraces.
+        {linkedClangLog, clangGolden, "auto", Dialect::Clang},
+    };
+    for (const auto& c : cases) {
+        std::optional<Dialect> dialect;
+        EXPECT_EQ(golden(feedAs(c.log, c.compiler, dialect)), c.golden) << c.compiler;
+        EXPECT_EQ(dialect, c.dialect) << c.compiler;
+
+        AnalysisOptions options;
+        options.compiler = c.compiler;
+        EXPECT_EQ(golden(analyzeDiagnostics(c.log, options, AppConfig{})), c.golden) << c.compiler;
+    }
+}
@@ -0,0 +1,105 @@
+#include "api.hpp"
+#include "instantiation.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace template_insight;
+
+namespace {
+
+/// Descriptions of the frames of an issue, innermost first.
+std::vector<std::string> stackOf(const TemplateInsightResult& result, const TemplateIssue& issue) {
+    std::vector<std::string> stack;
+    for (auto node = issue.instantiation; node.has_value(); node = result.instantiations[*node].parent) {
+        stack.push_back(result.instantiations[*node].description);
+    }
+    return stack;
+}
+
+} // namespace
+
+TEST(InstantiationBacktrace, ParsesClangNotes) {
+    const std::string block =
+        "a.h:4:7: error: no member named 'begin' in 'int'\n"
+        "a.h:9:3: note: in instantiation of function template specialization 'f<int>' requested here\n"
+        "main.cpp:3:3: note: in instantiation of member function 'S<int>::run' requested here\n"
+        "note: (skipping 7 contexts in backtrace; use -ftemplate-backtrace-limit=0 to see all)\n";
+
+    std::vector<BacktraceFrame> frames;
+    const std::size_t skipped = parseInstantiationBacktrace(block, frames);
+
+    EXPECT_EQ(skipped, 7u);
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].description, "function template specialization 'f<int>'");
+    EXPECT_EQ(frames[0].file, "a.h");
+    EXPECT_EQ(frames[0].line, 9);
+    EXPECT_EQ(frames[1].description, "member function 'S<int>::run'");
+    EXPECT_EQ(frames[1].file, "main.cpp");
+    EXPECT_EQ(frames[1].column, 3);
+}
+
+TEST(InstantiationBacktrace, ParsesGccContextLines) {
+    const std::string block =
+        "a.h: In instantiation of 'void f(T) [with T = int]':\n"
+        "a.h:9:4:   required from 'void g(T) [with T = int]'\n"
+        "main.cpp:3:5:   required from here\n"
+        "a.h:4:7: error: 'int' has no member named 'begin'\n";
+
+    std::vector<BacktraceFrame> frames;
+    parseInstantiationBacktrace(block, frames);
+
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].description, "void f(T) [with T = int]");
+    EXPECT_EQ(frames[0].line, 9);
+    EXPECT_EQ(frames[1].description, "void g(T) [with T = int]");
+    EXPECT_EQ(frames[1].file, "main.cpp");
+    EXPECT_EQ(frames[1].line, 3);
+}
+
+TEST(InstantiationBacktrace, IssuesShareOuterFrames) {
+    const std::string logText =
+        "a.h:4:7: error: no member named 'begin' in 'int'\n"
+        "a.h:9:3: note: in instantiation of function template specialization 'f<int>' requested here\n"
+        "main.cpp:3:3: note: in instantiation of member function 'S<int>::run' requested here\n"
+        "a.h:5:7: error: no member named 'end' in 'int'\n"
+        "a.h:10:3: note: in instantiation of function template specialization 'h<int>' requested here\n"
+        "main.cpp:3:3: note: in instantiation of member function 'S<int>::run' requested here\n";
+
+    AnalysisOptions options;
+    AppConfig config;
+    TemplateInsightResult result = analyzeDiagnostics(logText, options, config);
+
+    ASSERT_EQ(result.issues.size(), 2u);
+    // 'S<int>::run' is stored once and shared as the outer frame.
+    EXPECT_EQ(result.instantiations.size(), 3u);
+    EXPECT_EQ(stackOf(result, result.issues[0]),
+              (std::vector<std::string>{"function template specialization 'f<int>'",
+                                        "member function 'S<int>::run'"}));
+    EXPECT_EQ(stackOf(result, result.issues[1]),
+              (std::vector<std::string>{"function template specialization 'h<int>'",
+                                        "member function 'S<int>::run'"}));
+
+    EXPECT_NE(serializeToJson(result).find("\"instantiations\""), std::string::npos);
+}
+
+TEST(InstantiationBacktrace, DeepBacktraceIsTruncatedToMaxDepth) {
+    std::vector<BacktraceFrame> frames;
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back("frame" + std::to_string(i));
+    }
+    for (const auto& name : names) {
+        frames.push_back({name, "a.h", 1, 1});
+    }
+
+    InstantiationTreeBuilder builder;
+    std::size_t omitted = 0;
+    auto leaf = builder.insert(frames, 4, omitted);
+
+    ASSERT_TRUE(leaf.has_value());
+    EXPECT_EQ(omitted, 996u);
+    ASSERT_EQ(builder.frames().size(), 4u);
+    // Innermost two and outermost two frames survive.
+    EXPECT_EQ(builder.frames()[*leaf].description, "frame0");
+    EXPECT_EQ(builder.frames()[0].description, "frame999");
+}
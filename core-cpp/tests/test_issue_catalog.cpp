@@ -0,0 +1,47 @@
+#include "issue_catalog.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace template_insight;
+
+TEST(IssueCatalog, MergesRegistryWithBuiltinKinds) {
+    IssueRegistry registry;
+    IssueKind noMember;
+    noMember.code = IssueCodes::NO_MEMBER;
+    noMember.category = "Custom";
+    registry.addIssueKind(noMember);
+    IssueKind custom;
+    custom.code = "CUSTOM";
+    custom.patterns = {"custom failure"};
+    registry.addIssueKind(custom);
+
+    IssueCatalog catalog(registry, {});
+    EXPECT_EQ(catalog.size(), builtinIssueKinds().size() + 1);
+
+    // Registry metadata wins, built-in patterns fill in what it leaves empty.
+    auto id = catalog.findId(IssueCodes::NO_MEMBER);
+    ASSERT_TRUE(id.has_value());
+    EXPECT_EQ(catalog.kind(*id).category, "Custom");
+    EXPECT_FALSE(catalog.kind(*id).patterns.empty());
+
+    auto customId = catalog.findId("CUSTOM");
+    ASSERT_TRUE(customId.has_value());
+    EXPECT_EQ(catalog.kind(*customId).code, "CUSTOM");
+    EXPECT_FALSE(catalog.findId("UNKNOWN_CODE").has_value());
+}
+
+TEST(IssueCatalog, MatchesOnlyEnabledKinds) {
+    IssueCatalog catalog(IssueRegistry{}, {IssueCodes::TYPE_MISMATCH});
+    ASSERT_FALSE(catalog.matcher().empty());
+
+    const std::string text = "error: no member named 'x'; error: cannot convert 'int'";
+    std::vector<std::string> codes;
+    catalog.matcher().scan(text, [&](std::size_t, std::uint32_t index) {
+        codes.push_back(catalog.kind(catalog.kindOfPattern(index)).code);
+        return true;
+    });
+    EXPECT_EQ(codes, std::vector<std::string>{IssueCodes::TYPE_MISMATCH});
+
+    // Disabled kinds still resolve, they are just never matched.
+    EXPECT_TRUE(catalog.findId(IssueCodes::NO_MEMBER).has_value());
+}
@@ -0,0 +1,64 @@
+#include "api.hpp"
+#include "binary_format.hpp"
+#include "issue_dedup.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace template_insight;
+
+namespace {
+
+/// The same header error seen from several translation units.
+std::string headerErrorLog(const std::string& headerSpelling, const std::string& caller) {
+    return headerSpelling + ":3:7: error: no member named 'begin' in 'int'\n"
+           "src/" + caller + ":9:3: note: in instantiation of function template specialization "
+           "'f<int>' requested here\n";
+}
+
+} // namespace
+
+TEST(IssueDedup, MergesSameCodeLocationAndStack) {
+    const std::string log = headerErrorLog("inc/a.h", "main.cpp") +
+                            headerErrorLog("inc/./a.h", "main.cpp") +
+                            headerErrorLog("inc/a.h", "main.cpp") +
+                            headerErrorLog("inc/a.h", "other.cpp") + // Different stack.
+                            headerErrorLog("inc/a.h", "main.cpp");
+    TemplateInsightResult result = analyzeDiagnostics(log, AnalysisOptions{}, AppConfig{});
+    ASSERT_EQ(result.issues.size(), 5u);
+    const char* units[] = {"u1.cpp", "u2.cpp", "u1.cpp", "u3.cpp", "u4.cpp"};
+    for (std::size_t i = 0; i < result.issues.size(); ++i) {
+        result.issues[i].translationUnit = units[i];
+    }
+
+    EXPECT_EQ(deduplicateIssues(result, 1), 3u);
+    ASSERT_EQ(result.issues.size(), 2u);
+    const TemplateIssue& merged = result.issues[0];
+    EXPECT_EQ(merged.occurrences, 4u);
+    EXPECT_EQ(merged.translationUnit, "u1.cpp");
+    EXPECT_EQ(merged.duplicateTranslationUnits, std::vector<std::string>{"u2.cpp"}); // Capped at 1.
+    EXPECT_EQ(result.issues[1].occurrences, 1u);
+    EXPECT_EQ(result.issues[1].translationUnit, "u3.cpp");
+    EXPECT_NE(result.issues[0].instantiation, result.issues[1].instantiation);
+}
+
+TEST(IssueDedup, AggregatedIssuesSurviveSerializationAndRemerging) {
+    TemplateInsightResult result = analyzeDiagnostics(
+        headerErrorLog("inc/a.h", "main.cpp") + headerErrorLog("inc/a.h", "main.cpp"),
+        AnalysisOptions{}, AppConfig{});
+    result.issues[0].translationUnit = "u1.cpp";
+    result.issues[1].translationUnit = "u2.cpp";
+    deduplicateIssues(result, 8);
+
+    const std::string json = serializeToJson(result);
+    EXPECT_NE(json.find("\"occurrences\":2,\"duplicateTranslationUnits\":[\"u2.cpp\"]"), std::string::npos);
+    EXPECT_EQ(serializeToJson(decodeBinaryResult(encodeBinaryResult(result))), json);
+
+    // Merging two already aggregated results adds up their counts.
+    TemplateInsightResult twice = result;
+    twice.issues.push_back(result.issues[0]);
+    twice.issues[1].translationUnit = "u3.cpp";
+    deduplicateIssues(twice, 8);
+    ASSERT_EQ(twice.issues.size(), 1u);
+    EXPECT_EQ(twice.issues[0].occurrences, 4u);
+    EXPECT_EQ(twice.issues[0].duplicateTranslationUnits, (std::vector<std::string>{"u2.cpp", "u3.cpp"}));
+}
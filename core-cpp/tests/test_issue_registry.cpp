@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 #include <fstream>
 #include <cstdio>
+#include <algorithm>
 
 using namespace template_insight;
 
@@ -34,16 +35,45 @@ TEST(IssueRegistry, LoadSimpleIssueKindsJson) {
 
     std::remove(filename);
 
-    auto kindOpt = registry.find("NO_MEMBER");
-    ASSERT_TRUE(kindOpt.has_value());
+    const IssueKind* found = registry.find("NO_MEMBER");
+    ASSERT_NE(found, nullptr);
 
-    const IssueKind& kind = *kindOpt;
+    const IssueKind& kind = *found;
     EXPECT_EQ(kind.code, "NO_MEMBER");
     EXPECT_EQ(kind.category, "MemberAccess");
     EXPECT_EQ(kind.defaultSeverity, Severity::Error);
     EXPECT_EQ(kind.defaultShortMessage, "Type does not have the required member.");
     EXPECT_EQ(kind.defaultDetailedMessage, "Detailed explanation here.");
 
-    auto missing = registry.find("UNKNOWN_CODE");
-    EXPECT_FALSE(missing.has_value());
+    EXPECT_EQ(registry.find("UNKNOWN_CODE"), nullptr);
+}
+
+TEST(IssueRegistry, LoadsPatternsAndProvidesBuiltinKinds) {
+    const char* filename = "test_issue_kinds_patterns.json";
+
+    {
+        std::ofstream out(filename);
+        ASSERT_TRUE(out.is_open());
+
+        out << R"({ "issue_kinds": [ { "code": "CUSTOM", "patterns": ["custom failure", 42] } ] })";
+    }
+
+    IssueRegistry registry;
+    registry.loadFromJsonFile(filename);
+    std::remove(filename);
+
+    const IssueKind* custom = registry.find("CUSTOM");
+    ASSERT_NE(custom, nullptr);
+    EXPECT_EQ(custom->patterns, std::vector<std::string>{"custom failure"});
+
+    // Every well-known code has built-in metadata and at least one pattern.
+    for (const char* code : {IssueCodes::NO_MEMBER, IssueCodes::NO_MATCHING_FUNCTION,
+                             IssueCodes::TYPE_MISMATCH, IssueCodes::SUBSTITUTION_FAILURE,
+                             IssueCodes::CONSTRAINT_NOT_SATISFIED}) {
+        const auto& kinds = builtinIssueKinds();
+        auto it = std::find_if(kinds.begin(), kinds.end(),
+                               [&](const IssueKind& k) { return k.code == code; });
+        ASSERT_NE(it, kinds.end()) << code;
+        EXPECT_FALSE(it->patterns.empty()) << code;
+    }
 }
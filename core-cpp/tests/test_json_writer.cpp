@@ -0,0 +1,64 @@
+#include "api.hpp"
+#include "issue_catalog.hpp"
+#include "json_writer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <nlohmann/json.hpp>
+
+#include <sstream>
+
+using namespace template_insight;
+
+TEST(JsonWriter, EscapesQuotesBackslashesAndControlCharacters) {
+    // Long enough for the 16-byte fast path, with specials at both ends of a block.
+    const std::string text = std::string("\"a\\b") + std::string(20, 'x') + "\n\t\x1b[0m" + "\xc3\xa9";
+    std::string out;
+    appendJsonEscaped(out, text);
+    EXPECT_EQ(out, "\\\"a\\\\b" + std::string(20, 'x') + "\\n\\t\\u001b[0m\xc3\xa9");
+
+    // Round trip through a real JSON parser.
+    EXPECT_EQ(nlohmann::json::parse("\"" + out + "\"").get<std::string>(), text);
+}
+
+TEST(JsonWriter, NdjsonWritesFramesBeforeTheirIssues) {
+    const std::string logText =
+        "a.h:3:5: error: no member named 'size' in 'int'\n"
+        "main.cpp:9:3: note: in instantiation of function template specialization 'f<int>' requested here\n"
+        "b.cpp:1:1: error: cannot convert 'int' to 'S'\n";
+
+    AppConfig config;
+    OutputBuffer out;
+    ResultJsonWriter writer(out, ResultJsonWriter::Layout::Ndjson);
+    TemplateInsightResult result = analyzeDiagnostics(
+        logText, AnalysisOptions{}, config, IssueCatalog::load(config.analysis),
+        [&](const TemplateIssue& issue, const std::vector<InstantiationFrame>& frames) {
+            writer.writeIssue(issue, frames);
+        });
+    EXPECT_TRUE(result.issues.empty());
+    writer.finish(result);
+
+    std::vector<nlohmann::json> records;
+    std::istringstream lines(out.str());
+    for (std::string line; std::getline(lines, line);) {
+        records.push_back(nlohmann::json::parse(line));
+    }
+    ASSERT_EQ(records.size(), 4u);
+    EXPECT_EQ(records[0]["type"], "frame");
+    EXPECT_EQ(records[1]["type"], "issue");
+    EXPECT_EQ(records[1]["instantiation"], records[0]["id"]);
+    EXPECT_EQ(records[2]["type"], "issue");
+    EXPECT_EQ(records[3]["type"], "summary");
+    EXPECT_EQ(records[3]["issues"], 2);
+
+    // A run that fails before the first issue leaves the output empty.
+    OutputBuffer unused;
+    ResultJsonWriter document(unused, ResultJsonWriter::Layout::Document);
+    EXPECT_TRUE(unused.str().empty());
+    document.finish(TemplateInsightResult{});
+    EXPECT_EQ(nlohmann::json::parse(unused.str())["issues"].size(), 0u);
+
+    // The document layout still matches serializeToJson().
+    EXPECT_EQ(nlohmann::json::parse(serializeToJson(analyzeDiagnostics(logText, AnalysisOptions{}, config)))
+                  ["issues"].size(), 2u);
+}
@@ -0,0 +1,122 @@
+#include "log_follower.hpp"
+#include "issue_catalog.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace template_insight;
+
+namespace {
+
+const char* kFollowedLog = "test_log_follower.log";
+
+void appendToLog(const std::string& text, std::ios::openmode mode = std::ios::app) {
+    std::ofstream out(kFollowedLog, std::ios::binary | mode);
+    out << text;
+}
+
+/// Issue codes received from the follower thread.
+class CollectingSink {
+public:
+    CompactIssueSink sink() {
+        return [this](const CompactResult& result, const CompactIssue& issue, const std::vector<InstantiationFrame>&) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            codes_.emplace_back(result.code(issue));
+        };
+    }
+
+    /// Wait (up to a few seconds) until `count` issues were received.
+    std::vector<std::string> waitFor(std::size_t count) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (codes_.size() >= count) {
+                    return codes_;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        return codes_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::string> codes_;
+};
+
+AppConfig followConfig() {
+    AppConfig config;
+    config.analysis.followSettleMs = 20;
+    return config;
+}
+
+} // namespace
+
+TEST(LogFollower, ReportsIssuesWhileTheLogGrows) {
+    appendToLog("[1/40] Building CXX object a.cpp.o\n", std::ios::trunc);
+    const AppConfig config = followConfig();
+    CollectingSink issues;
+    std::atomic<bool> stop{false};
+    std::optional<CompactResult> result;
+    std::thread follower([&] {
+        result = followLog(kFollowedLog, AnalysisOptions{}, config, IssueCatalog::load(config.analysis),
+                           issues.sink(), stop);
+    });
+
+    // A diagnostic written in pieces is reported once complete, without
+    // waiting for further output.
+    appendToLog("src/a.cpp:3:5: error: no member named 'size' in ");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    appendToLog("'int'\n    x.size();\n");
+    EXPECT_EQ(issues.waitFor(1), std::vector<std::string>{"NO_MEMBER"});
+
+    appendToLog("src/b.cpp:7:1: error: no matching function for call to 'f'\n[2/40] Building CXX object b.cpp.o\n");
+    EXPECT_EQ(issues.waitFor(2).size(), 2u);
+
+    stop = true;
+    follower.join();
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->issues().empty());
+    EXPECT_EQ(result->truncation, TruncationReason::None);
+    std::remove(kFollowedLog);
+}
+
+TEST(LogFollower, RereadsReplacedLogAndStopsWhenIdle) {
+    EXPECT_THROW(followLog("does_not_exist.log", AnalysisOptions{}, AppConfig{},
+                           IssueCatalog::load(AnalysisConfig{}), {}, std::atomic<bool>{false}),
+                 std::runtime_error);
+
+    appendToLog("src/a.cpp:3:5: error: no member named 'size' in 'int'\n", std::ios::trunc);
+    AppConfig config = followConfig();
+    config.analysis.followIdleTimeoutMs = 500;
+    CollectingSink issues;
+    std::atomic<bool> stop{false};
+    std::thread follower([&] {
+        followLog(kFollowedLog, AnalysisOptions{}, config, IssueCatalog::load(config.analysis),
+                  issues.sink(), stop);
+    });
+    EXPECT_EQ(issues.waitFor(1).size(), 1u);
+    // The old build is cut off in the middle of a line.
+    appendToLog("src/b.cpp:7:1: error: no matching function for call to 'f'");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // A new build truncates the log and starts over; its first line is not
+    // glued onto the old unterminated one.
+    appendToLog("src/c.cpp:1:1: error: no member named 'end' in 'int'\n", std::ios::trunc);
+    EXPECT_EQ(issues.waitFor(3), (std::vector<std::string>{"NO_MEMBER", "NO_MATCHING_FUNCTION", "NO_MEMBER"}));
+
+    // Ends on its own once the log stays unchanged.
+    follower.join();
+    std::remove(kFollowedLog);
+}
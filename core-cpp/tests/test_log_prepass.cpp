@@ -0,0 +1,130 @@
+#include "analysis_cache.hpp"
+#include "analyzer.hpp"
+#include "log_prepass.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace template_insight;
+
+namespace {
+
+// clang -fcolor-diagnostics and gcc -fdiagnostics-color=always output,
+// the latter with an OSC 8 hyperlink on the warning option.
+const std::string kColored =
+    "\x1b[1msrc/a.cpp:3:5: \x1b[0m\x1b[0;1;31merror: \x1b[0m\x1b[1mno member named 'size' in 'int'\x1b[0m\n"
+    "    x.size();\n"
+    "\x1b[0;1;32m    ~ ^\n\x1b[0m"
+    "\x1b[01m\x1b[Ksrc/b.cpp:7:1:\x1b[m\x1b[K \x1b[01;35m\x1b[Kwarning: \x1b[m\x1b[Kno matching function for call to "
+    "'\x1b[01m\x1b[Kf\x1b[m\x1b[K' [\x1b[01;35m\x1b[K\x1b]8;;https://gcc.gnu.org/onlinedocs/gcc/Warning-Options.html"
+    "\x1b\\-Wfoo\x1b]8;;\x07\x1b[m\x1b[K]\n";
+
+const std::string kPlain =
+    "src/a.cpp:3:5: error: no member named 'size' in 'int'\n"
+    "    x.size();\n"
+    "    ~ ^\n"
+    "src/b.cpp:7:1: warning: no matching function for call to 'f' [-Wfoo]\n";
+
+} // namespace
+
+TEST(LogPrepass, IndexesLineEndsWithEveryKernel) {
+    std::mt19937 random(7);
+    std::string text;
+    for (int i = 0; i < 5000; ++i) {
+        // Mostly short lines, some empty, some longer than a vector step.
+        const int length = random() % 8 == 0 ? static_cast<int>(random() % 200) : static_cast<int>(random() % 12);
+        text.append(static_cast<std::size_t>(length), static_cast<char>('a' + random() % 26));
+        text += '\n';
+    }
+    text += "unterminated";
+
+    std::vector<std::uint32_t> expected;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\n') {
+            expected.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    const ScanKernel best = detectScanKernel();
+    for (ScanKernel kernel : {ScanKernel::Scalar, ScanKernel::Sse2, ScanKernel::Avx2}) {
+        if (static_cast<int>(kernel) > static_cast<int>(best)) {
+            continue;
+        }
+        // Every alignment and every length of the scalar tail.
+        for (std::size_t offset = 0; offset < 70; ++offset) {
+            const std::string_view view = std::string_view(text).substr(offset, text.size() - 2 * offset);
+            std::vector<std::uint32_t> ends;
+            indexLineEnds(view, ends, kernel);
+            std::vector<std::uint32_t> want;
+            for (std::uint32_t end : expected) {
+                if (end >= offset && end < offset + view.size()) {
+                    want.push_back(static_cast<std::uint32_t>(end - offset));
+                }
+            }
+            ASSERT_EQ(ends, want) << scanKernelName(kernel) << " at offset " << offset;
+        }
+    }
+}
+
+TEST(LogPrepass, StripsColorCodesAcrossChunksBeforeAnalysis) {
+    EXPECT_TRUE(containsEscape(kColored));
+    EXPECT_FALSE(containsEscape(kPlain));
+    EXPECT_EQ(stripAnsiEscapes(kColored), kPlain);
+    // A malformed sequence ends at the line end.
+    EXPECT_EQ(stripAnsiEscapes("a\x1b[31\nb\x1b]8;;x\nc\x1b"), "a\nb\nc");
+
+    // Split at every position, sequences span chunks.
+    for (std::size_t split = 0; split <= kColored.size(); ++split) {
+        AnsiStripper ansi;
+        std::string first;
+        std::string second;
+        ansi.strip(std::string_view(kColored).substr(0, split), first);
+        ansi.strip(std::string_view(kColored).substr(split), second);
+        ASSERT_EQ(first + second, kPlain) << "split at " << split;
+        EXPECT_EQ(ansi.sequences(), 26u);
+    }
+
+    AppConfig config;
+    const TemplateInsightResult plain = analyzeDiagnostics(kPlain, AnalysisOptions{}, config);
+    ASSERT_EQ(plain.issues.size(), 2u);
+    const TemplateInsightResult colored = analyzeDiagnostics(kColored, AnalysisOptions{}, config);
+    DiagnosticsAnalyzer analyzer(AnalysisOptions{}, config);
+    for (std::size_t pos = 0; pos < kColored.size(); pos += 5) {
+        analyzer.feed(std::string_view(kColored).substr(pos, 5));
+    }
+    const TemplateInsightResult fed = analyzer.finish();
+    for (const TemplateInsightResult* result : {&colored, &fed}) {
+        ASSERT_EQ(result->issues.size(), 2u);
+        EXPECT_EQ(result->issues[0].code, plain.issues[0].code);
+        EXPECT_EQ(result->issues[1].code, plain.issues[1].code);
+        EXPECT_EQ(result->issues[1].severity, Severity::Warning);
+        ASSERT_TRUE(result->issues[1].location.has_value());
+        EXPECT_EQ(result->issues[1].location->file, "src/b.cpp");
+#if TEMPLATE_INSIGHT_METRICS
+        EXPECT_EQ(result->stats.counter(Counter::EscapeSequences), 26u);
+#endif
+    }
+
+    // Colored logs are split into blocks as they are, and each chunk or
+    // block is stripped where it is analyzed.
+    EXPECT_EQ(DiagnosticsAnalyzer::nextBlockBoundary(kColored, 1), kColored.find("\x1b[0m\x1b[01m\x1b[Ksrc/b.cpp"));
+    std::string scratch;
+    EXPECT_EQ(strippedPrefix(kColored, 9, scratch), "src/a.cpp");
+    std::string log;
+    for (int i = 0; i < 20; ++i) {
+        log += kColored;
+    }
+    AppConfig parallel = config;
+    parallel.analysis.workerThreads = 2;
+    parallel.analysis.parallelChunkBytes = 256;
+    AnalysisCache cache(1 << 20);
+    for (AnalysisCache* c : {static_cast<AnalysisCache*>(nullptr), &cache, &cache}) {
+        const TemplateInsightResult result =
+            analyzeDiagnostics(log, AnalysisOptions{}, parallel, IssueCatalog::load(config.analysis), {}, c);
+        ASSERT_EQ(result.issues.size(), 40u);
+        EXPECT_EQ(result.issues[39].location->file, "src/b.cpp");
+#if TEMPLATE_INSIGHT_METRICS
+        EXPECT_EQ(result.stats.counter(Counter::EscapeSequences), 20 * 26u);
+#endif
+    }
+}
@@ -0,0 +1,37 @@
+#include "mapped_file.hpp"
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace template_insight;
+
+TEST(MappedFile, ViewMatchesFileContent) {
+    const char* filename = "test_mapped_file.log";
+    const std::string content =
+        "main.cpp:10:5: error: no member named 'begin' in 'int'\n"
+        "    x.begin();\n";
+
+    {
+        std::ofstream out(filename, std::ios::binary);
+        ASSERT_TRUE(out.is_open());
+        out << content;
+    }
+
+    {
+        MappedFile file = MappedFile::open(filename);
+        EXPECT_EQ(file.view(), content);
+
+        // Moving keeps the view valid for both mapped and buffered files.
+        MappedFile moved = std::move(file);
+        EXPECT_EQ(moved.view(), content);
+        EXPECT_TRUE(file.view().empty());
+    }
+
+    std::remove(filename);
+}
+
+TEST(MappedFile, MissingFileThrows) {
+    EXPECT_THROW(MappedFile::open("does_not_exist.log"), std::runtime_error);
+}
@@ -0,0 +1,96 @@
+#include "api.hpp"
+#include "issue_dedup.hpp"
+#include "json_writer.hpp"
+#include "metrics.hpp"
+
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace template_insight;
+
+namespace {
+
+const std::string kLog =
+    "src/a.cpp:3:5: error: no member named 'size' in 'int'\n"
+    "src/a.cpp:9:2: note: in instantiation of function template specialization 'f<int>' requested here\n"
+    "src/b.cpp:4:1: error: use of undeclared identifier 'x'\n"
+    "src/a.cpp:3:5: error: no member named 'size' in 'int'\n"
+    "src/a.cpp:9:2: note: in instantiation of function template specialization 'f<int>' requested here\n";
+
+std::size_t spansNamed(const AnalysisStats& stats, const std::string& name) {
+    std::size_t n = 0;
+    for (const auto& span : stats.spans) {
+        n += name == span.name;
+    }
+    return n;
+}
+
+} // namespace
+
+TEST(Metrics, CountsPhasesAndWritesStatsBlock) {
+    if (!TEMPLATE_INSIGHT_METRICS) {
+        GTEST_SKIP() << "built without TEMPLATE_INSIGHT_METRICS";
+    }
+    AppConfig config;
+    config.analysis.workerThreads = 1;
+    TemplateInsightResult result = analyzeDiagnostics(kLog, AnalysisOptions{}, config);
+    const AnalysisStats& stats = result.stats;
+    EXPECT_EQ(stats.counter(Counter::BytesScanned), kLog.size());
+    EXPECT_EQ(stats.counter(Counter::Lines), 5u);
+    EXPECT_EQ(stats.counter(Counter::Blocks), 3u);
+    EXPECT_EQ(stats.counter(Counter::UnclassifiedBlocks), 1u);
+    EXPECT_EQ(stats.counter(Counter::Issues), 2u);
+    EXPECT_EQ(spansNamed(stats, "registryLoad"), 1u);
+    EXPECT_EQ(spansNamed(stats, "analyze"), 1u);
+
+    EXPECT_EQ(deduplicateIssues(result, 8), 1u);
+    EXPECT_EQ(result.stats.counter(Counter::MergedDuplicates), 1u);
+    EXPECT_EQ(spansNamed(result.stats, "filter"), 1u);
+
+    // Statistics are only written on request.
+    EXPECT_FALSE(nlohmann::json::parse(serializeToJson(result)).contains("stats"));
+    OutputBuffer out;
+    ResultJsonWriter writer(out, ResultJsonWriter::Layout::Document);
+    writer.setWriteStats(true);
+    writer.finish(result);
+    const auto json = nlohmann::json::parse(out.str());
+    ASSERT_TRUE(json.contains("stats"));
+    EXPECT_EQ(json["stats"]["counters"]["bytesScanned"], kLog.size());
+    EXPECT_EQ(json["stats"]["counters"]["mergedDuplicates"], 1);
+    EXPECT_TRUE(json["stats"]["phaseMicros"].contains("serialize"));
+}
+
+TEST(Metrics, MergesParallelChunksAndWritesChromeTrace) {
+    if (!TEMPLATE_INSIGHT_METRICS) {
+        GTEST_SKIP() << "built without TEMPLATE_INSIGHT_METRICS";
+    }
+    std::string log;
+    for (int i = 0; i < 40; ++i) {
+        log += kLog;
+    }
+    AppConfig config;
+    config.analysis.workerThreads = 2;
+    config.analysis.parallelChunkBytes = 1024;
+    const TemplateInsightResult result = analyzeDiagnostics(log, AnalysisOptions{}, config);
+    EXPECT_EQ(result.stats.counter(Counter::BytesScanned), log.size());
+    EXPECT_EQ(result.stats.counter(Counter::Issues), 80u);
+    EXPECT_GT(spansNamed(result.stats, "chunk"), 1u);
+
+    const std::string path = "test_metrics_trace.json";
+    writeChromeTrace(result.stats, path);
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::remove(path.c_str());
+
+    const auto trace = nlohmann::json::parse(buffer.str());
+    const auto& events = trace["traceEvents"];
+    ASSERT_EQ(events.size(), result.stats.spans.size() + 1);
+    EXPECT_EQ(events[0]["ph"], "X");
+    EXPECT_EQ(events.back()["ph"], "C");
+    EXPECT_EQ(events.back()["args"]["issues"], 80);
+}
@@ -0,0 +1,89 @@
+#include "analyzer.hpp"
+#include "api.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace template_insight;
+
+namespace {
+
+/// A log mixing clang and gcc diagnostics, shared backtraces and build noise.
+std::string makeMixedLog(int blocks) {
+    std::string log;
+    for (int i = 0; i < blocks; ++i) {
+        const std::string n = std::to_string(i);
+        log += "[" + n + "/500] Building CXX object src/f" + n + ".cpp.o\n";
+        if (i % 3 == 0) {
+            log += "src/a.h:" + n + ":7: error: no member named 'begin' in 'int'\n"
+                   "    x.begin();\n"
+                   "src/a.h:9:3: note: in instantiation of function template specialization 'f<int>' requested here\n"
+                   "src/main.cpp:3:3: note: in instantiation of member function 'S<int>::run' requested here\n";
+        } else if (i % 3 == 1) {
+            log += "src/b.h: In instantiation of 'void g(T) [with T = int]':\n"
+                   "src/b.h:12:4:   required from 'void h(T) [with T = int]'\n"
+                   "src/f" + n + ".cpp:3:5:   required from here\n"
+                   "src/b.h:4:7: error: no matching function for call to 'k(int&)'\n"
+                   "    4 |   k(t);\n";
+        } else {
+            log += "src/c.cpp:" + n + ":1: warning: cannot convert 'int' to 'S'\n";
+        }
+    }
+    log += "3 errors generated.\n";
+    return log;
+}
+
+} // namespace
+
+TEST(ParallelAnalysis, MergedOutputMatchesSequential) {
+    const std::string logText = makeMixedLog(300);
+
+    AnalysisOptions options;
+    AppConfig sequentialCfg;
+    sequentialCfg.analysis.workerThreads = 1;
+
+    AppConfig parallelCfg;
+    parallelCfg.analysis.workerThreads = 4;
+    parallelCfg.analysis.parallelChunkBytes = 512;
+
+    const std::string sequential = serializeToJson(analyzeDiagnostics(logText, options, sequentialCfg));
+    const std::string parallel = serializeToJson(analyzeDiagnostics(logText, options, parallelCfg));
+
+    EXPECT_EQ(parallel, sequential);
+    EXPECT_NE(parallel.find("\"instantiations\""), std::string::npos);
+}
+
+TEST(ParallelAnalysis, MaxIssuesAppliesAcrossChunks) {
+    const std::string logText = makeMixedLog(300);
+
+    AnalysisOptions options;
+    AppConfig sequentialCfg;
+    sequentialCfg.analysis.workerThreads = 1;
+    sequentialCfg.analysis.maxIssues = 7;
+    sequentialCfg.analysis.enabledIssueCodes = {IssueCodes::NO_MATCHING_FUNCTION};
+
+    AppConfig parallelCfg = sequentialCfg;
+    parallelCfg.analysis.workerThreads = 3;
+    parallelCfg.analysis.parallelChunkBytes = 256;
+
+    TemplateInsightResult parallel = analyzeDiagnostics(logText, options, parallelCfg);
+
+    ASSERT_EQ(parallel.issues.size(), 7u);
+    for (const auto& issue : parallel.issues) {
+        EXPECT_EQ(issue.code, IssueCodes::NO_MATCHING_FUNCTION);
+    }
+    EXPECT_EQ(serializeToJson(parallel),
+              serializeToJson(analyzeDiagnostics(logText, options, sequentialCfg)));
+}
+
+TEST(ParallelAnalysis, BlockBoundaryNeverSplitsAGccPrelude) {
+    const std::string text =
+        "src/b.h: In instantiation of 'void g(T) [with T = int]':\n"
+        "src/f.cpp:3:5:   required from here\n"
+        "src/b.h:4:7: error: no matching function for call to 'k(int&)'\n"
+        "next.cpp:1:1: error: no member named 'x' in 'int'\n";
+
+    // Anywhere inside the prelude, the next safe split is the following diagnostic.
+    EXPECT_EQ(DiagnosticsAnalyzer::nextBlockBoundary(text, 10), text.find("next.cpp"));
+    EXPECT_EQ(DiagnosticsAnalyzer::nextBlockBoundary(text, 0), 0u);
+    EXPECT_EQ(DiagnosticsAnalyzer::nextBlockBoundary(text, text.size() - 3), text.size());
+}
@@ -0,0 +1,59 @@
+#include "pattern_matcher.hpp"
+
+#include <gtest/gtest.h>
+#include <utility>
+#include <vector>
+
+using namespace template_insight;
+
+TEST(PatternMatcher, FindsEveryOccurrenceOfEveryPatternInOnePass) {
+    PatternMatcher matcher({
+        {"NO_MEMBER", "no member"},
+        {"NO_MEMBER", "member named"},
+        {"TYPE_MISMATCH", "cannot convert"},
+    });
+
+    const std::string text =
+        "a.cpp:1:1: error: no member named 'x' in 'T'\n"
+        "b.cpp:2:2: error: cannot convert 'int' to 'T'\n"
+        "c.cpp:3:3: error: no member named 'y' in 'U'\n";
+
+    std::vector<std::pair<std::size_t, std::string>> matches;
+    matcher.scan(text, [&](std::size_t offset, std::uint32_t index) {
+        matches.emplace_back(offset, matcher.pattern(index).text);
+        return true;
+    });
+
+    const std::vector<std::pair<std::size_t, std::string>> expected = {
+        {text.find("no member"), "no member"},
+        {text.find("member named"), "member named"},
+        {text.find("cannot convert"), "cannot convert"},
+        {text.rfind("no member"), "no member"},
+        {text.rfind("member named"), "member named"},
+    };
+    EXPECT_EQ(matches, expected);
+}
+
+TEST(PatternMatcher, OverlappingAndSuffixPatterns) {
+    PatternMatcher matcher({{"A", "he"}, {"B", "she"}, {"C", "hers"}});
+
+    std::vector<std::string> found;
+    matcher.scan("ushers", [&](std::size_t, std::uint32_t index) {
+        found.push_back(matcher.pattern(index).code);
+        return true;
+    });
+
+    EXPECT_EQ(found, (std::vector<std::string>{"B", "A", "C"}));
+}
+
+TEST(PatternMatcher, ScanStopsWhenCallbackReturnsFalse) {
+    PatternMatcher matcher(std::vector<IssuePattern>{{"A", "x"}});
+
+    int calls = 0;
+    matcher.scan("xxxx", [&](std::size_t, std::uint32_t) {
+        ++calls;
+        return false;
+    });
+
+    EXPECT_EQ(calls, 1);
+}
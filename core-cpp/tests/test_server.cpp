@@ -0,0 +1,71 @@
+#include "server.hpp"
+
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <map>
+#include <sstream>
+
+using namespace template_insight;
+using nlohmann::json;
+
+TEST(AnalysisServer, AnswersEveryFramedRequest) {
+    std::stringstream in;
+    for (int id = 0; id < 8; ++id) {
+        json request = {
+            {"id", id},
+            {"log", "main.cpp:" + std::to_string(id + 1) + ":5: error: no member named 'begin' in 'int'\n"},
+        };
+        writeFrame(in, request.dump());
+    }
+    writeFrame(in, "not json");
+
+    std::stringstream out;
+    AnalysisServer server(AppConfig{}, 3);
+    server.serve(in, out);
+
+    std::map<int, json> responses;
+    std::string payload;
+    int errors = 0;
+    while (readFrame(out, payload)) {
+        json response = json::parse(payload);
+        if (response.contains("error")) {
+            ++errors;
+            continue;
+        }
+        responses[response["id"].get<int>()] = response["result"];
+    }
+
+    EXPECT_EQ(errors, 1);
+    ASSERT_EQ(responses.size(), 8u);
+    for (const auto& [id, result] : responses) {
+        ASSERT_EQ(result["issues"].size(), 1u);
+        EXPECT_EQ(result["issues"][0]["code"], "NO_MEMBER");
+        EXPECT_EQ(result["issues"][0]["location"]["line"], id + 1);
+    }
+}
+
+TEST(AnalysisServer, RejectsRequestWithoutLog) {
+    AnalysisServer server(AppConfig{}, 1);
+    json response = json::parse(server.handle(R"({"id":"abc"})"));
+
+    EXPECT_EQ(response["id"], "abc");
+    EXPECT_TRUE(response.contains("error"));
+}
+
+TEST(AnalysisServer, AnswersMalformedUtf8WithError) {
+    std::stringstream in;
+    writeFrame(in, "\xff");
+    writeFrame(in, std::string(R"({"id":1,"log":"main.cpp:1:5: error: )") + "\xc3\x28" + "\"}");
+
+    std::stringstream out;
+    AnalysisServer server(AppConfig{}, 1);
+    server.serve(in, out);
+
+    std::string payload;
+    int errors = 0;
+    while (readFrame(out, payload)) {
+        EXPECT_TRUE(json::parse(payload).contains("error"));
+        ++errors;
+    }
+    EXPECT_EQ(errors, 2);
+}
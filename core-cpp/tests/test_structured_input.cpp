@@ -0,0 +1,102 @@
+#include "api.hpp"
+#include "structured_input.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+using namespace template_insight;
+
+namespace {
+
+/// Shaped like clang -fdiagnostics-format=sarif: notes are results of their own.
+const char* kSarif = R"({
+  "$schema": "https://docs.oasis-open.org/sarif/sarif/v2.1.0/cos02/schemas/sarif-schema-2.1.0.json",
+  "version": "2.1.0",
+  "runs": [{
+    "tool": { "driver": { "name": "clang", "rules": [{ "id": "", "fullDescription": { "text": "" } }] } },
+    "artifacts": [{ "location": { "uri": "file:///src/a%20b.h" }, "length": -1 }],
+    "results": [
+      { "level": "error", "ruleId": "3214",
+        "message": { "text": "no member named 'begin' in 'int'" },
+        "locations": [{ "physicalLocation": {
+            "artifactLocation": { "index": 0, "uri": "file:///src/a%20b.h" },
+            "region": { "startLine": 3, "startColumn": 7, "endColumn": 8 } } }] },
+      { "level": "note", "ruleId": "1234",
+        "message": { "text": "in instantiation of function template specialization 'f<int>' requested here" },
+        "locations": [{ "physicalLocation": {
+            "artifactLocation": { "uri": "file:///src/main.cpp" },
+            "region": { "startLine": 9, "startColumn": 3 } } }] },
+      { "level": "warning", "ruleId": "42",
+        "message": { "text": "cannot convert 'int' to 'S'" },
+        "locations": [{ "physicalLocation": {
+            "artifactLocation": { "uri": "file:///src/c.cpp" },
+            "region": { "startLine": 1, "startColumn": 1 } } }] }
+    ]
+  }]
+})";
+
+/// Shaped like gcc -fdiagnostics-format=json.
+const char* kGccJson = R"([
+  {"kind": "error", "message": "no matching function for call to 'k(int&)'",
+   "locations": [{"caret": {"file": "src/b.h", "line": 4, "display-column": 7, "byte-column": 7, "column": 7},
+                  "finish": {"file": "src/b.h", "line": 4, "column": 10}}],
+   "children": [
+     {"kind": "note", "message": "In instantiation of 'void g(T) [with T = int]':", "locations": []},
+     {"kind": "note", "message": "required from here",
+      "locations": [{"caret": {"file": "src/main.cpp", "line": 3, "column": 5}}]}],
+   "column-origin": 1, "option": "", "escape-source": false}
+])";
+
+} // namespace
+
+TEST(StructuredInput, DetectsFormat) {
+    EXPECT_EQ(resolveInputFormat("clang", "\n  {\"version\": \"2.1.0\"}"), InputFormat::Sarif);
+    EXPECT_EQ(resolveInputFormat("gcc", "[\n  {\"kind\": \"error\"}]"), InputFormat::GccJson);
+    EXPECT_EQ(resolveInputFormat("gcc", "[1/20] Building CXX object a.o\n"), InputFormat::Text);
+    EXPECT_EQ(resolveInputFormat("clang", "a.cpp:1:2: error: x\n"), InputFormat::Text);
+    EXPECT_EQ(resolveInputFormat("gcc-json", "[3/20] ..."), InputFormat::GccJson);
+}
+
+TEST(StructuredInput, MapsSarifResultsAndNotes) {
+    AppConfig config;
+    const TemplateInsightResult result = analyzeDiagnostics(kSarif, AnalysisOptions{}, config);
+
+    ASSERT_EQ(result.issues.size(), 2u);
+    const TemplateIssue& first = result.issues[0];
+    EXPECT_EQ(first.code, IssueCodes::NO_MEMBER);
+    ASSERT_TRUE(first.location.has_value());
+    EXPECT_EQ(first.location->file, "/src/a b.h");
+    EXPECT_EQ(first.location->line, 3);
+    EXPECT_EQ(first.location->column, 7);
+    ASSERT_TRUE(first.instantiation.has_value());
+    const InstantiationFrame& frame = result.instantiations[*first.instantiation];
+    EXPECT_EQ(frame.description, "function template specialization 'f<int>'");
+    ASSERT_TRUE(frame.location.has_value());
+    EXPECT_EQ(frame.location->file, "/src/main.cpp");
+    EXPECT_EQ(frame.location->line, 9);
+
+    EXPECT_EQ(result.issues[1].code, IssueCodes::TYPE_MISMATCH);
+    EXPECT_EQ(result.issues[1].severity, Severity::Warning);
+    EXPECT_FALSE(result.issues[1].instantiation.has_value());
+}
+
+TEST(StructuredInput, StreamsGccJson) {
+    std::istringstream in(kGccJson);
+    const TemplateInsightResult result = analyzeDiagnosticsStream(in, AnalysisOptions{}, AppConfig{});
+
+    ASSERT_EQ(result.issues.size(), 1u);
+    const TemplateIssue& issue = result.issues[0];
+    EXPECT_EQ(issue.code, IssueCodes::NO_MATCHING_FUNCTION);
+    ASSERT_TRUE(issue.location.has_value());
+    EXPECT_EQ(issue.location->file, "src/b.h");
+    EXPECT_EQ(issue.location->line, 4);
+    ASSERT_TRUE(issue.instantiation.has_value());
+    const InstantiationFrame& frame = result.instantiations[*issue.instantiation];
+    EXPECT_EQ(frame.description, "void g(T) [with T = int]");
+    ASSERT_TRUE(frame.location.has_value());
+    EXPECT_EQ(frame.location->file, "src/main.cpp");
+
+    std::istringstream broken("[{\"kind\": \"error\", ");
+    EXPECT_THROW(analyzeDiagnosticsStream(broken, AnalysisOptions{}, AppConfig{}), std::runtime_error);
+}
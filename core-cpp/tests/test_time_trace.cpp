@@ -0,0 +1,111 @@
+#include "issue_catalog.hpp"
+#include "time_trace.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace template_insight;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+/// Scratch build directory with a few trace files.
+class TimeTraceDir {
+public:
+    TimeTraceDir() : root_(fs::temp_directory_path() / "template_insight_time_trace_test") {
+        fs::remove_all(root_);
+        fs::create_directories(root_ / "sub");
+    }
+    ~TimeTraceDir() { fs::remove_all(root_); }
+
+    void write(const std::string& name, const std::string& text) const {
+        std::ofstream(root_ / name, std::ios::binary) << text;
+    }
+    std::string path() const { return root_.string(); }
+
+private:
+    fs::path root_;
+};
+
+std::string complete(const std::string& name, const std::string& detail, int dur) {
+    return R"({"pid":1,"tid":7,"ph":"X","ts":0,"dur":)" + std::to_string(dur) + R"(,"name":")" + name +
+           R"(","args":{"detail":")" + detail + R"("}})";
+}
+
+} // namespace
+
+TEST(TimeTrace, AggregatesTraceFilesAcrossWorkers) {
+    TimeTraceDir dir;
+    // Older clang: Source as complete events.
+    dir.write("a.cpp.json", R"({"traceEvents":[)" +
+        complete("InstantiateClass", "std::vector<int>", 3000) + "," +
+        complete("InstantiateFunction", "f<int>", 500) + "," +
+        complete("Source", "/inc/big.h", 8000) + "," +
+        complete("Frontend", "", 20000) + "," +
+        complete("Total InstantiateClass", "", 3000) + R"(], "beginningOfTime": 1})");
+    // Newer clang: nested Source begin/end pairs.
+    dir.write("sub/b.cpp.json", R"({"traceEvents":[)"
+        R"({"pid":1,"tid":7,"ph":"b","id":1,"ts":100,"cat":"Source","name":"Source","args":{"detail":"/inc/big.h"}},)"
+        R"({"pid":1,"tid":7,"ph":"b","id":2,"ts":200,"cat":"Source","name":"Source","args":{"detail":"/inc/small.h"}},)"
+        R"({"pid":1,"tid":7,"ph":"e","id":2,"ts":700,"cat":"Source","name":"Source"},)"
+        R"({"pid":1,"tid":7,"ph":"e","id":1,"ts":4100,"cat":"Source","name":"Source"},)" +
+        complete("InstantiateClass", "std::vector<int>", 2000) + "," +
+        complete("InstantiateClass", "std::vector<int>", 1000) + "," +
+        complete("Frontend", "", 20000) + "]}");
+    dir.write("compile_commands.json", "[]");
+    dir.write("sub/broken.json", R"({"traceEvents":[)" + complete("InstantiateClass", "std::vector<int>", 9000) +
+                                     R"(,{"ph":)");
+
+    const std::vector<std::string> files = findTimeTraceFiles(dir.path());
+    ASSERT_EQ(files.size(), 3u);
+
+    TimeTraceProfile profile;
+    EXPECT_TRUE(profile.addFile(files[0]));
+    EXPECT_TRUE(profile.addFile(files[1]));
+    // sub/broken.json: the event before the error is not counted either.
+    EXPECT_THROW(profile.addFile(files[2]), std::runtime_error);
+    const auto& vector = profile.instantiations().at("std::vector<int>");
+    EXPECT_EQ(vector.microseconds, 6000u);
+    EXPECT_EQ(vector.count, 3u);
+    EXPECT_EQ(vector.translationUnits, 2u);
+    EXPECT_EQ(profile.headers().at("/inc/big.h").microseconds, 12000u);
+    EXPECT_EQ(profile.headers().at("/inc/small.h").microseconds, 500u);
+    EXPECT_EQ(profile.frontendMicroseconds(), 40000u);
+    EXPECT_EQ(profile.instantiations().count("Total InstantiateClass"), 0u);
+
+    AnalysisConfig config;
+    config.workerThreads = 3;
+    config.profileTopN = 1;
+    IssueCatalog catalog(IssueRegistry{}, {});
+    const TemplateInsightResult result = profileTimeTraces(files, config, catalog);
+    ASSERT_EQ(result.issues.size(), 2u);
+    EXPECT_EQ(result.issues[0].code, IssueCodes::EXPENSIVE_INSTANTIATION);
+    EXPECT_EQ(result.issues[0].severity, Severity::Warning);
+    EXPECT_NE(result.issues[0].detailedMessage.find("'std::vector<int>' took 6.0 ms in 3 instantiations "
+                                                    "across 2 translation units (15.0% of frontend time)"),
+              std::string::npos);
+    EXPECT_EQ(result.issues[1].code, IssueCodes::EXPENSIVE_HEADER);
+    ASSERT_TRUE(result.issues[1].location.has_value());
+    EXPECT_EQ(result.issues[1].location->file, "/inc/big.h");
+}
+
+TEST(TimeTrace, RespectsEnabledCodesAndIgnoresOtherJson) {
+    TimeTraceDir dir;
+    dir.write("a.json", R"({"traceEvents":[)" + complete("Source", "/inc/a.h", 10) + "," +
+                        complete("InstantiateClass", "A<1>", 10) + "]}");
+    dir.write("b.json", R"([{"kind": "error"}])");
+    dir.write("c.json", R"({"version": "2.1.0", "runs": []})");
+
+    TimeTraceProfile profile;
+    EXPECT_FALSE(profile.addFile(dir.path() + "/b.json"));
+    EXPECT_FALSE(profile.addFile(dir.path() + "/c.json"));
+    EXPECT_EQ(profile.files(), 0u);
+
+    IssueCatalog catalog(IssueRegistry{}, {IssueCodes::EXPENSIVE_HEADER});
+    const TemplateInsightResult result = profileTimeTraces(findTimeTraceFiles(dir.path()), AnalysisConfig{}, catalog);
+    ASSERT_EQ(result.issues.size(), 1u);
+    EXPECT_EQ(result.issues[0].code, IssueCodes::EXPENSIVE_HEADER);
+}
@@ -0,0 +1,65 @@
+#include "api.hpp"
+#include "type_names.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace template_insight;
+
+TEST(TypeNames, ElidesDefaultsAndRepeatedSubtrees) {
+    const TypeNameOptions options;
+    const std::string libcxxString =
+        "std::__1::basic_string<char, std::__1::char_traits<char>, std::__1::allocator<char> >";
+    EXPECT_EQ(abbreviateTypeNames(libcxxString, options), "std::string");
+    EXPECT_EQ(abbreviateTypeNames("std::vector<int, std::allocator<int>>", options), "std::vector<int>");
+    EXPECT_EQ(abbreviateTypeNames("std::vector<int, MyAllocator<int>>", options), "std::vector<int, MyAllocator<int>>");
+
+    const std::string map = "std::__cxx11::map<std::__cxx11::basic_string<char, std::char_traits<char>, "
+                            "std::allocator<char>>, int, std::less<std::__cxx11::basic_string<char, "
+                            "std::char_traits<char>, std::allocator<char>>>, std::allocator<std::pair<const "
+                            "std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char>>, int>>>";
+    EXPECT_EQ(abbreviateTypeNames("function template specialization 'f<" + map + ">'", options),
+              "function template specialization 'f<std::map<std::string, int>>'");
+
+    // Long template-ids shown more than once become back-references.
+    const std::string pair = "Pair<Tuple<Alpha, Beta, Gamma, Delta>, Tuple<Alpha, Beta, Gamma, Delta>>";
+    EXPECT_EQ(abbreviateTypeNames("'" + pair + "'", options), "'Pair<$1, $1>' [with $1 = Tuple<Alpha, Beta, Gamma, Delta>]");
+
+    // Operators and unbalanced text are left alone.
+    EXPECT_EQ(abbreviateTypeNames("'operator<<' for 'std::vector<int>'", options), "'operator<<' for 'std::vector<int>'");
+    EXPECT_FALSE(TypeNameTree::parse("A<B<C>"));
+
+    TypeNameOptions shallow;
+    shallow.maxDepth = 1;
+    EXPECT_EQ(abbreviateTypeNames("Outer<Middle<Inner<int>>, float>", shallow), "Outer<Middle<...>, float>");
+}
+
+TEST(TypeNames, KeepsFullSpellingsAndAbbreviatesFrames) {
+    const std::string source = "Box<std::__1::vector<int, std::__1::allocator<int>>>";
+    const auto tree = TypeNameTree::parse(source);
+    ASSERT_TRUE(tree);
+    EXPECT_EQ(tree->spelling(tree->root()), source);
+    EXPECT_EQ(tree->canonicalLength(tree->root()), std::string("Box<std::vector<int>>").size());
+    EXPECT_EQ(tree->abbreviate(TypeNameOptions{}), "Box<std::vector<int>>");
+
+    std::string nested = "int";
+    for (int i = 0; i < 10; ++i) {
+        nested = "std::__1::vector<" + nested + ", std::__1::allocator<" + nested + ">>";
+    }
+    ASSERT_GT(nested.size(), 10000u);
+    const std::string log = "a.cpp:3:5: error: no member named 'x' in 'S'\n"
+                            "a.cpp:9:3: note: in instantiation of function template specialization 'f<" +
+                            nested + ">' requested here\n";
+
+    // Descriptions are kept verbatim unless abbreviation is asked for.
+    AppConfig config;
+    config.analysis.maxTemplateDepth = 3;
+    const TemplateInsightResult verbatim = analyzeDiagnostics(log, AnalysisOptions{}, config);
+    ASSERT_EQ(verbatim.instantiations.size(), 1u);
+    EXPECT_EQ(verbatim.instantiations[0].description, "function template specialization 'f<" + nested + ">'");
+
+    config.analysis.typeNameAbbreviationLength = 256;
+    const TemplateInsightResult result = analyzeDiagnostics(log, AnalysisOptions{}, config);
+    ASSERT_EQ(result.instantiations.size(), 1u);
+    EXPECT_EQ(result.instantiations[0].description,
+              "function template specialization 'f<std::vector<std::vector<std::vector<...>>>>'");
+}